@@ -0,0 +1,402 @@
+#include "ans.h"
+#include <math.h>
+#include <string.h>
+
+/**
+ * Schrittweite, mit der die Zeichen über die Zustände verteilt werden.
+ * Sie ist ungerade und erreicht damit jeden Zustand genau einmal.
+ */
+#define ANS_SPREAD_STEP ((ANS_TABLE_SIZE >> 1) + (ANS_TABLE_SIZE >> 3) + 3)
+
+/**
+ * Höchster Wert, den ein Zähler bei der Normierung annimmt, damit die
+ * Produkte auch bei Häufigkeiten aus beschädigten Dateien in 64 Bit passen
+ */
+#define ANS_MAX_SCALED_COUNT (1ull << 32)
+
+/**
+ * Anzahl der abwechselnd verwendeten Zustände
+ */
+#define ANS_STATE_COUNT 2
+
+/**
+ * Verteilt die Zeichen gemäß ihrer normierten Häufigkeiten über die
+ * Zustände, sodass jedes Zeichen gleichmäßig vertreten ist.
+ * @param normalized - normierte Häufigkeiten
+ * @param symbols - Ziel, Zeichen je Zustand
+ */
+static void spread_symbols(const unsigned short normalized[], unsigned char symbols[]);
+
+/**
+ * Liefert die Position des höchsten gesetzten Bits.
+ * @param value - Wert größer 0
+ * @return Position, 0 für das niedrigste Bit
+ */
+static unsigned int get_highest_bit(unsigned int value);
+
+/**
+ * Kodiert ein Zeichen: gibt die niedrigen Bits des Zustands aus und
+ * wechselt in einen Zustand des Zeichens.
+ * @param state - Zustand
+ * @param character - Zeichen
+ * @param table - Tabelle zum Kodieren
+ * @param bit_buffer - Puffer der auszugebenden Bits, wird erweitert
+ * @param bit_count - Anzahl der Bits im Puffer, wird erhöht
+ * @return Folgezustand
+ */
+static inline unsigned int encode_symbol(unsigned int state, unsigned char character, const ANS_ENCODE_TABLE *table,
+                                         unsigned long long *bit_buffer, unsigned int *bit_count);
+
+/**
+ * Liest Bits des Bitstroms.
+ * @param source - Bitstrom, mit dem niedrigsten Bit des ersten Bytes beginnend
+ * @param position - Position des ersten zu lesenden Bits
+ * @param count - Anzahl der Bits, höchstens ANS_TABLE_LOG
+ * @return gelesene Bits
+ */
+static inline unsigned int read_bits(const unsigned char *source, unsigned long long position, unsigned int count);
+
+/**
+ * Lädt die 64 Bits des Bitstroms ab einer Position, die letzten
+ * (position & 7) Bits sind 0.
+ * @param source - Bitstrom, mit dem niedrigsten Bit des ersten Bytes beginnend
+ * @param position - Position des ersten zu lesenden Bits
+ * @return geladene Bits, das erste im niedrigsten Bit
+ */
+static inline unsigned long long load_bits(const unsigned char *source, unsigned long long position);
+
+extern EXIT ans_normalize(const unsigned long long counts[], unsigned short normalized[])
+{
+    unsigned long long scaled_counts[NUM_OF_SYMBOLS];
+    unsigned long long max_count = 0;
+    unsigned long long total = 0;
+    unsigned int shift = 0;
+    unsigned int sum = 0;
+    int largest = -1;
+
+    for (int i = 0; i < NUM_OF_SYMBOLS; i++)
+    {
+        max_count = counts[i] > max_count ? counts[i] : max_count;
+    }
+    if (max_count == 0)
+    {
+        return COMPRESSION_EXCEPTION;
+    }
+    while (max_count >> shift >= ANS_MAX_SCALED_COUNT)
+    {
+        shift++;
+    }
+
+    for (int i = 0; i < NUM_OF_SYMBOLS; i++)
+    {
+        scaled_counts[i] = counts[i] >> shift;
+        if (counts[i] > 0 && scaled_counts[i] == 0)
+        {
+            scaled_counts[i] = 1;
+        }
+        total += scaled_counts[i];
+    }
+
+    // round to the nearest share, but keep every present char encodable
+    for (int i = 0; i < NUM_OF_SYMBOLS; i++)
+    {
+        normalized[i] = 0;
+        if (scaled_counts[i] > 0)
+        {
+            unsigned long long share = (scaled_counts[i] * ANS_TABLE_SIZE + total / 2) / total;
+            normalized[i] = (unsigned short) (share > 0 ? share : 1);
+            sum += normalized[i];
+            if (largest == -1 || normalized[i] > normalized[largest])
+            {
+                largest = i;
+            }
+        }
+    }
+
+    // settle the rounding error where it costs the fewest bits, at the most frequent chars
+    if (sum < ANS_TABLE_SIZE)
+    {
+        normalized[largest] = (unsigned short) (normalized[largest] + ANS_TABLE_SIZE - sum);
+    }
+    while (sum > ANS_TABLE_SIZE)
+    {
+        largest = 0;
+        for (int i = 1; i < NUM_OF_SYMBOLS; i++)
+        {
+            if (normalized[i] > normalized[largest])
+            {
+                largest = i;
+            }
+        }
+        normalized[largest]--;
+        sum--;
+    }
+    return SUCCESS;
+}
+
+extern double ans_get_bits(const unsigned long long counts[], const unsigned short normalized[])
+{
+    double bits = ANS_STATE_COUNT * ANS_TABLE_LOG;
+
+    for (int i = 0; i < NUM_OF_SYMBOLS; i++)
+    {
+        if (counts[i] > 0)
+        {
+            if (normalized[i] == 0)
+            {
+                return HUGE_VAL;
+            }
+            bits += (double) counts[i] * (ANS_TABLE_LOG - log2(normalized[i]));
+        }
+    }
+    return bits;
+}
+
+extern void ans_build_encode_table(const unsigned short normalized[], ANS_ENCODE_TABLE *table)
+{
+    unsigned char symbols[ANS_TABLE_SIZE];
+    unsigned int next_states[NUM_OF_SYMBOLS];
+    unsigned int cumulative = 0;
+
+    spread_symbols(normalized, symbols);
+
+    for (int i = 0; i < NUM_OF_SYMBOLS; i++)
+    {
+        unsigned int count = normalized[i];
+
+        next_states[i] = cumulative;
+        table->symbols[i].delta_bit_count = 0;
+        table->symbols[i].delta_state = 0;
+        if (count == 1)
+        {
+            table->symbols[i].delta_bit_count = (ANS_TABLE_LOG << 16) - ANS_TABLE_SIZE;
+            table->symbols[i].delta_state = (int) cumulative - 1;
+        }
+        else if (count > 1)
+        {
+            // states of the char lie in [count, 2 * count), the bits shift them there
+            unsigned int max_bit_count = ANS_TABLE_LOG - get_highest_bit(count - 1);
+            table->symbols[i].delta_bit_count = (max_bit_count << 16) - (count << max_bit_count);
+            table->symbols[i].delta_state = (int) cumulative - (int) count;
+        }
+        cumulative += count;
+    }
+
+    // states of each char in ascending order, as the decoder numbers them
+    for (unsigned int state = 0; state < ANS_TABLE_SIZE; state++)
+    {
+        table->states[next_states[symbols[state]]++] = (unsigned short) (ANS_TABLE_SIZE + state);
+    }
+}
+
+extern void ans_build_decode_table(const unsigned short normalized[], ANS_DECODE_TABLE *table)
+{
+    unsigned char symbols[ANS_TABLE_SIZE];
+    unsigned int next_states[NUM_OF_SYMBOLS];
+
+    spread_symbols(normalized, symbols);
+    for (int i = 0; i < NUM_OF_SYMBOLS; i++)
+    {
+        next_states[i] = normalized[i];
+    }
+
+    for (unsigned int state = 0; state < ANS_TABLE_SIZE; state++)
+    {
+        unsigned char symbol = symbols[state];
+        unsigned int next_state = next_states[symbol]++;
+        unsigned int bit_count = ANS_TABLE_LOG - get_highest_bit(next_state);
+
+        table->entries[state].symbol = symbol;
+        table->entries[state].bit_count = (unsigned char) bit_count;
+        table->entries[state].state_base = (unsigned short) ((next_state << bit_count) - ANS_TABLE_SIZE);
+    }
+}
+
+extern size_t ans_get_bound(size_t block_size)
+{
+    // every char costs at most ANS_TABLE_LOG bits, then the final states and the end marker
+    return (block_size * ANS_TABLE_LOG + ANS_STATE_COUNT * ANS_TABLE_LOG + 1 + 7) / 8;
+}
+
+extern size_t ans_encode(const unsigned char *block, size_t block_size, const ANS_ENCODE_TABLE *table,
+                         unsigned char *destination)
+{
+    unsigned long long bit_buffer = 0;
+    unsigned int bit_count = 0;
+    unsigned int state0 = ANS_TABLE_SIZE;
+    unsigned int state1 = ANS_TABLE_SIZE;
+    size_t position = 0;
+    size_t i = block_size;
+
+    // encode backwards, so the decoder gets the chars in order; even chars use the first state
+    if (i % 2 == 1)
+    {
+        state0 = encode_symbol(state0, block[i - 1], table, &bit_buffer, &bit_count);
+        i--;
+    }
+    for (; i > 0; i -= 2)
+    {
+        // at most 31 pending bits plus two times ANS_TABLE_LOG bits fit into the buffer
+        state1 = encode_symbol(state1, block[i - 1], table, &bit_buffer, &bit_count);
+        state0 = encode_symbol(state0, block[i - 2], table, &bit_buffer, &bit_count);
+
+        if (bit_count >= 32)
+        {
+            destination[position] = (unsigned char) bit_buffer;
+            destination[position + 1] = (unsigned char) (bit_buffer >> 8);
+            destination[position + 2] = (unsigned char) (bit_buffer >> 16);
+            destination[position + 3] = (unsigned char) (bit_buffer >> 24);
+            position += 4;
+            bit_buffer >>= 32;
+            bit_count -= 32;
+        }
+    }
+
+    // final states, then a 1-bit that marks the end of the stream
+    bit_buffer |= (unsigned long long) (state0 - ANS_TABLE_SIZE) << bit_count;
+    bit_count += ANS_TABLE_LOG;
+    bit_buffer |= (unsigned long long) (state1 - ANS_TABLE_SIZE) << bit_count;
+    bit_count += ANS_TABLE_LOG;
+    bit_buffer |= 1ull << bit_count;
+    bit_count++;
+    while (bit_count > 0)
+    {
+        destination[position++] = (unsigned char) bit_buffer;
+        bit_buffer >>= 8;
+        bit_count = bit_count > 8 ? bit_count - 8 : 0;
+    }
+    return position;
+}
+
+extern EXIT ans_decode(const unsigned char *source, size_t source_size, const ANS_DECODE_TABLE *table,
+                       unsigned char *destination, size_t char_count)
+{
+    unsigned long long position;
+    unsigned long long window_position;
+    unsigned long long window = 0;
+    unsigned int state0;
+    unsigned int state1;
+    size_t i = 0;
+
+    if (source_size == 0 || source[source_size - 1] == 0)
+    {
+        return COMPRESSION_EXCEPTION;
+    }
+
+    // the stream is read from the end marker back to its start
+    position = (unsigned long long) (source_size - 1) * 8 + get_highest_bit(source[source_size - 1]);
+    if (position < 2 * ANS_TABLE_LOG)
+    {
+        return COMPRESSION_EXCEPTION;
+    }
+    position -= ANS_TABLE_LOG;
+    state1 = read_bits(source, position, ANS_TABLE_LOG);
+    position -= ANS_TABLE_LOG;
+    state0 = read_bits(source, position, ANS_TABLE_LOG);
+
+    // states that stay in place without reading bits repeat their char, as in blocks of a single char
+    if (table->entries[state0].bit_count == 0 && table->entries[state0].state_base == state0
+        && table->entries[state1].bit_count == 0 && table->entries[state1].state_base == state1
+        && table->entries[state0].symbol == table->entries[state1].symbol)
+    {
+        memset(destination, table->entries[state0].symbol, char_count);
+        i = char_count;
+    }
+
+    // the two states alternate, so the lookups of one overlap those of the other
+    window_position = position;
+    for (; i + 2 <= char_count; i += 2)
+    {
+        ANS_DECODE_ENTRY entry0 = table->entries[state0];
+        ANS_DECODE_ENTRY entry1 = table->entries[state1];
+        unsigned long long bits;
+
+        // refill the window with a single load, it then holds the bits of at least two pairs below the position
+        if (position - window_position < 2 * ANS_TABLE_LOG)
+        {
+            window_position = position > 56 ? (position - 56) & ~7ull : 0;
+            window = load_bits(source, window_position);
+        }
+
+        destination[i] = entry0.symbol;
+        destination[i + 1] = entry1.symbol;
+        if (position < (unsigned int) entry0.bit_count + entry1.bit_count)
+        {
+            return COMPRESSION_EXCEPTION;
+        }
+
+        // the second state's bits lie below the first one's
+        position -= (unsigned int) entry0.bit_count + entry1.bit_count;
+        bits = window >> (position - window_position);
+        state1 = entry1.state_base + (unsigned int) (bits & ((1u << entry1.bit_count) - 1));
+        state0 = entry0.state_base + (unsigned int) ((bits >> entry1.bit_count) & ((1u << entry0.bit_count) - 1));
+    }
+    if (i < char_count)
+    {
+        ANS_DECODE_ENTRY entry0 = table->entries[state0];
+
+        destination[i] = entry0.symbol;
+        if (position < entry0.bit_count)
+        {
+            return COMPRESSION_EXCEPTION;
+        }
+        position -= entry0.bit_count;
+        state0 = entry0.state_base + read_bits(source, position, entry0.bit_count);
+    }
+
+    // the encoder started in the first state and every bit was used
+    return position == 0 && state0 == 0 && state1 == 0 ? SUCCESS : COMPRESSION_EXCEPTION;
+}
+
+static void spread_symbols(const unsigned short normalized[], unsigned char symbols[])
+{
+    unsigned int position = 0;
+
+    for (int i = 0; i < NUM_OF_SYMBOLS; i++)
+    {
+        for (unsigned int j = 0; j < normalized[i]; j++)
+        {
+            symbols[position] = (unsigned char) i;
+            position = (position + ANS_SPREAD_STEP) & (ANS_TABLE_SIZE - 1);
+        }
+    }
+}
+
+static unsigned int get_highest_bit(unsigned int value)
+{
+    unsigned int bit = 0;
+
+    while (value >>= 1)
+    {
+        bit++;
+    }
+    return bit;
+}
+
+static inline unsigned int encode_symbol(unsigned int state, unsigned char character, const ANS_ENCODE_TABLE *table,
+                                         unsigned long long *bit_buffer, unsigned int *bit_count)
+{
+    const ANS_SYMBOL *symbol = &table->symbols[character];
+    unsigned int count = (state + symbol->delta_bit_count) >> 16;
+
+    *bit_buffer |= (unsigned long long) (state & ((1u << count) - 1)) << *bit_count;
+    *bit_count += count;
+    return table->states[(int) (state >> count) + symbol->delta_state];
+}
+
+static inline unsigned int read_bits(const unsigned char *source, unsigned long long position, unsigned int count)
+{
+    return (unsigned int) load_bits(source, position) & ((1u << count) - 1);
+}
+
+static inline unsigned long long load_bits(const unsigned char *source, unsigned long long position)
+{
+    unsigned long long word;
+
+    // a single unaligned load, the stream is little endian
+    memcpy(&word, source + (position >> 3), sizeof(word));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    word = __builtin_bswap64(word);
+#endif
+    return word >> (position & 7);
+}
@@ -0,0 +1,161 @@
+/**
+ * @file
+ * Dieses Modul implementiert eine tabellenbasierte ANS-Kodierung (tANS) als
+ * Alternative zu Huffman-Codes. Ein Zeichen mit Wahrscheinlichkeit p kostet
+ * hier etwa -log2(p) Bits statt einer ganzen Zahl von Bits, was sich bei
+ * sehr ungleich verteilten Zeichen lohnt.
+ *
+ * Die Häufigkeiten werden auf ANS_TABLE_SIZE normiert und über die
+ * Zustände einer Tabelle verteilt. Kodiert wird rückwärts, sodass der
+ * Dekodierer die Zeichen vorwärts erhält und dabei den Bitstrom vom Ende
+ * zum Anfang liest. Gerade und ungerade Zeichen verwenden je einen eigenen
+ * Zustand, damit der Dekodierer zwei Zeichen gleichzeitig bearbeiten kann.
+ *
+ * @author  Tim Ostermann
+ * @date    2020-12-05
+ */
+
+#ifndef HUFFMAN_ANS_H
+#define HUFFMAN_ANS_H
+
+#include "huffman_common.h"
+#include <stddef.h>
+
+/**
+ * Zweierlogarithmus der Anzahl der Zustände
+ */
+#define ANS_TABLE_LOG 12
+
+/**
+ * Anzahl der Zustände, auf die die Häufigkeiten normiert werden
+ */
+#define ANS_TABLE_SIZE (1 << ANS_TABLE_LOG)
+
+/**
+ * Übergang eines Zeichens beim Kodieren
+ */
+typedef struct
+{
+    /**
+     * Verschiebung, aus der sich die Anzahl der auszugebenden Bits ergibt
+     */
+    unsigned int delta_bit_count;
+
+    /**
+     * Verschiebung in die Zustände des Zeichens
+     */
+    int delta_state;
+} ANS_SYMBOL;
+
+/**
+ * Tabelle zum Kodieren
+ */
+typedef struct
+{
+    /**
+     * Folgezustände, nach Zeichen gruppiert
+     */
+    unsigned short states[ANS_TABLE_SIZE];
+
+    /**
+     * Übergang je Zeichen
+     */
+    ANS_SYMBOL symbols[NUM_OF_SYMBOLS];
+} ANS_ENCODE_TABLE;
+
+/**
+ * Eintrag der Dekodiertabelle
+ */
+typedef struct
+{
+    /**
+     * Basis des Folgezustands, zu der die gelesenen Bits addiert werden
+     */
+    unsigned short state_base;
+
+    /**
+     * Dekodiertes Zeichen
+     */
+    unsigned char symbol;
+
+    /**
+     * Anzahl der zu lesenden Bits
+     */
+    unsigned char bit_count;
+} ANS_DECODE_ENTRY;
+
+/**
+ * Tabelle zum Dekodieren, indiziert über den Zustand
+ */
+typedef struct
+{
+    ANS_DECODE_ENTRY entries[ANS_TABLE_SIZE];
+} ANS_DECODE_TABLE;
+
+/**
+ * Normiert Häufigkeiten auf ANS_TABLE_SIZE. Jedes vorkommende Zeichen
+ * erhält mindestens 1. Das Ergebnis hängt nur von den Häufigkeiten ab,
+ * sodass Kodierer und Dekodierer dieselbe Tabelle aufbauen.
+ * @param counts - Häufigkeiten je Zeichen
+ * @param normalized - Ziel für die normierten Häufigkeiten
+ * @return COMPRESSION_EXCEPTION, falls kein Zeichen vorkommt
+ */
+extern EXIT ans_normalize(const unsigned long long counts[], unsigned short normalized[]);
+
+/**
+ * Schätzt die Länge der Kodierung von Häufigkeiten mit normierten
+ * Häufigkeiten, einschließlich der Endzustände.
+ * @param counts - Häufigkeiten je Zeichen
+ * @param normalized - normierte Häufigkeiten
+ * @return Anzahl Bits, unendlich, falls ein Zeichen nicht kodierbar ist
+ */
+extern double ans_get_bits(const unsigned long long counts[], const unsigned short normalized[]);
+
+/**
+ * Baut die Tabelle zum Kodieren auf.
+ * @param normalized - normierte Häufigkeiten
+ * @param table - Ziel
+ */
+extern void ans_build_encode_table(const unsigned short normalized[], ANS_ENCODE_TABLE *table);
+
+/**
+ * Baut die Tabelle zum Dekodieren auf.
+ * @param normalized - normierte Häufigkeiten
+ * @param table - Ziel
+ */
+extern void ans_build_decode_table(const unsigned short normalized[], ANS_DECODE_TABLE *table);
+
+/**
+ * Liefert die Größe, die die Kodierung eines Speicherbereichs höchstens
+ * belegt.
+ * @param block_size - Anzahl der Zeichen
+ * @return Anzahl Bytes
+ */
+extern size_t ans_get_bound(size_t block_size);
+
+/**
+ * Kodiert die Zeichen eines Speicherbereichs. Alle Zeichen müssen eine
+ * normierte Häufigkeit größer 0 haben.
+ * @param block - Anfang des Speicherbereichs
+ * @param block_size - Anzahl der Zeichen
+ * @param table - Tabelle zum Kodieren
+ * @param destination - Ziel, mindestens ans_get_bound(block_size) Bytes groß
+ * @return Anzahl der geschriebenen Bytes
+ */
+extern size_t ans_encode(const unsigned char *block, size_t block_size, const ANS_ENCODE_TABLE *table,
+                         unsigned char *destination);
+
+/**
+ * Dekodiert einen Speicherbereich. Hinter der Kodierung müssen 8 Bytes
+ * lesbar sein.
+ * @param source - Kodierung
+ * @param source_size - Anzahl der Bytes der Kodierung
+ * @param table - Tabelle zum Dekodieren
+ * @param destination - Ziel
+ * @param char_count - Anzahl zu dekodierender Zeichen
+ * @return COMPRESSION_EXCEPTION, falls die Kodierung nicht genau aufgeht
+ */
+extern EXIT ans_decode(const unsigned char *source, size_t source_size, const ANS_DECODE_TABLE *table,
+                       unsigned char *destination, size_t char_count);
+
+#endif //HUFFMAN_ANS_H
@@ -0,0 +1,543 @@
+#include "archive.h"
+#include "huffman.h"
+#include "io.h"
+#include "checksum.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/stat.h>
+
+/**
+ * Maximale Anzahl gemeinsamer Code-Tabellen eines Archivs
+ */
+#define MAX_TABLES 64
+
+/**
+ * Länge des Offsets des zentralen Verzeichnisses am Dateiende in Bytes
+ */
+#define TRAILER_SIZE 8
+
+/**
+ * Eintrag des zentralen Verzeichnisses
+ */
+typedef struct
+{
+    /**
+     * Gespeicherter Name der Datei
+     */
+    char *name;
+
+    /**
+     * Index der Code-Tabelle
+     */
+    unsigned int table;
+
+    /**
+     * Offset des kodierten Inhalts im Archiv
+     */
+    unsigned long long offset;
+
+    /**
+     * Größe der Datei in Bytes
+     */
+    unsigned long long size;
+
+    /**
+     * Größe des kodierten Inhalts in Bytes
+     */
+    unsigned long long packed_size;
+
+    /**
+     * CRC-32 des Inhalts
+     */
+    unsigned int crc;
+} MEMBER;
+
+/**
+ * Häufigkeiten einer gemeinsamen Code-Tabelle
+ */
+typedef unsigned long long TABLE[NUM_OF_SYMBOLS];
+
+/**
+ * Ordnet einer Datei eine Code-Tabelle zu: Eine bestehende Tabelle wird
+ * übernommen, wenn die geschätzten Mehrkosten durch die gemeinsame
+ * Verteilung geringer sind als die Kosten einer eigenen Tabelle.
+ * Die Häufigkeiten der Datei werden der gewählten Tabelle hinzugefügt.
+ * @param tables - Code-Tabellen
+ * @param table_count - Zeiger auf Anzahl der Code-Tabellen
+ * @param counts - Häufigkeiten der Datei
+ * @return Index der gewählten Code-Tabelle
+ */
+static unsigned int assign_table(TABLE *tables, unsigned int *table_count, const unsigned long long counts[]);
+
+/**
+ * Schätzt die Anzahl der Bits, die die Zeichen bei entropieoptimaler
+ * Kodierung benötigen.
+ * @param counts - Häufigkeiten
+ * @return geschätzte Anzahl Bits
+ */
+static double entropy_bits(const unsigned long long counts[]);
+
+/**
+ * Schätzt die Anzahl der Bits, die das Speichern einer Code-Tabelle kostet.
+ * @param counts - Häufigkeiten
+ * @return geschätzte Anzahl Bits
+ */
+static double table_bits(const unsigned long long counts[]);
+
+/**
+ * Schreibt eine 64-Bit-Zahl mit fester Länge (Big Endian) in die Ausgabedatei.
+ * @param value - zu schreibender Wert
+ * @param length - Anzahl Bytes
+ */
+static void write_fixed(unsigned long long value, int length);
+
+/**
+ * Liest eine Zahl mit fester Länge (Big Endian) aus der Eingabedatei.
+ * @param length - Anzahl Bytes
+ * @return gelesener Wert
+ */
+static unsigned long long read_fixed(int length);
+
+/**
+ * Liest das zentrale Verzeichnis eines Archivs.
+ * @param members - Zeiger auf die zu reservierenden Verzeichniseinträge
+ * @param member_count - Zeiger auf Anzahl der Verzeichniseinträge
+ * @param table_count - Anzahl der Code-Tabellen des Archivs
+ * @return Exit-Code
+ */
+static EXIT read_directory(MEMBER **members, unsigned long long *member_count, unsigned int table_count);
+
+/**
+ * Bestimmt den Namen der Ausgabedatei eines Verzeichniseintrags und legt
+ * fehlende Verzeichnisse an. Führende "/" werden entfernt, Namen mit ".."
+ * werden abgelehnt, ebenso Pfade, die über einen symbolischen Link führen
+ * oder auf einen zeigen.
+ * @param name - gespeicherter Name
+ * @param out_filename - Zeiger auf Ausgabedatei
+ * @return Exit-Code
+ */
+static EXIT get_member_out_filename(char *name, char *out_filename);
+
+extern EXIT compress_archive(char **in_filenames, int in_count, char *out_filename)
+{
+    MEMBER *members = (MEMBER *) calloc((size_t) in_count, sizeof(MEMBER));
+    TABLE *tables = (TABLE *) calloc(MAX_TABLES, sizeof(TABLE));
+    unsigned int table_count = 0;
+    unsigned long long counts[NUM_OF_SYMBOLS];
+    EXIT exit = SUCCESS;
+
+    if (members == NULL || tables == NULL || open_outfile(out_filename) != SUCCESS)
+    {
+        free(members);
+        free(tables);
+        return IO_EXCEPTION;
+    }
+
+    // first pass: count frequencies and checksum of every member, assign shared tables
+    for (int i = 0; i < in_count && exit == SUCCESS; i++)
+    {
+        unsigned int crc = CHECKSUM_INIT;
+
+        if (open_infile(in_filenames[i]) != SUCCESS)
+        {
+            exit = IO_EXCEPTION;
+            break;
+        }
+
+        memset(counts, 0, sizeof(counts));
+        count_frequencies(counts, &crc);
+        close_infile();
+
+        members[i].name = in_filenames[i];
+        members[i].crc = checksum_final(crc);
+        for (int j = 0; j < NUM_OF_SYMBOLS; j++)
+        {
+            members[i].size += counts[j];
+        }
+        members[i].table = assign_table(tables, &table_count, counts);
+    }
+
+    if (exit == SUCCESS)
+    {
+        // write archive identification and shared tables
+        write_char(ARCHIVE_MAGIC[0]);
+        write_char(ARCHIVE_MAGIC[1]);
+        write_char(FORMAT_VERSION);
+        write_varint(table_count);
+        for (unsigned int t = 0; t < table_count; t++)
+        {
+            write_frequencies(tables[t]);
+        }
+
+        // second pass: encode members grouped by table, so every table is built once
+        for (unsigned int t = 0; t < table_count && exit == SUCCESS; t++)
+        {
+            exit = build_code_table(tables[t], 0);
+            for (int i = 0; i < in_count && exit == SUCCESS; i++)
+            {
+                if (members[i].table != t)
+                {
+                    continue;
+                }
+
+                members[i].offset = get_out_offset();
+                if (open_infile(members[i].name) != SUCCESS)
+                {
+                    exit = IO_EXCEPTION;
+                    break;
+                }
+                encode_infile();
+                align_out();
+                close_infile();
+                members[i].packed_size = get_out_offset() - members[i].offset;
+            }
+        }
+    }
+
+    if (exit == SUCCESS)
+    {
+        // write central directory and its offset
+        unsigned long long directory_offset = get_out_offset();
+
+        write_varint((unsigned long long) in_count);
+        for (int i = 0; i < in_count; i++)
+        {
+            size_t name_length = strlen(members[i].name);
+            write_varint(name_length);
+            for (size_t j = 0; j < name_length; j++)
+            {
+                write_char((unsigned char) members[i].name[j]);
+            }
+            write_varint(members[i].table);
+            write_varint(members[i].offset);
+            write_varint(members[i].size);
+            write_varint(members[i].packed_size);
+            write_fixed(members[i].crc, 4);
+        }
+        write_fixed(directory_offset, TRAILER_SIZE);
+    }
+
+    release_code_table();
+    close_infile();
+    close_outfile();
+    free(members);
+    free(tables);
+
+    return exit;
+}
+
+extern EXIT decompress_archive(char *in_filename, char *member_name)
+{
+    TABLE *tables = NULL;
+    MEMBER *members = NULL;
+    unsigned long long member_count = 0;
+    unsigned int table_count;
+    unsigned int built_table = MAX_TABLES;
+    bool found = member_name == NULL;
+    EXIT exit = SUCCESS;
+
+    if (open_infile(in_filename) != SUCCESS)
+    {
+        return IO_EXCEPTION;
+    }
+
+    // check archive identification and format version
+    if (!has_next_char() || read_char() != ARCHIVE_MAGIC[0]
+        || !has_next_char() || read_char() != ARCHIVE_MAGIC[1]
+        || !has_next_char() || read_char() != FORMAT_VERSION)
+    {
+        close_infile();
+        return COMPRESSION_EXCEPTION;
+    }
+
+    // read shared tables
+    table_count = (unsigned int) read_varint();
+    tables = (TABLE *) calloc(MAX_TABLES, sizeof(TABLE));
+    if (has_varint_error() || table_count > MAX_TABLES || tables == NULL)
+    {
+        free(tables);
+        close_infile();
+        return COMPRESSION_EXCEPTION;
+    }
+    for (unsigned int t = 0; t < table_count && exit == SUCCESS; t++)
+    {
+        exit = read_frequencies(tables[t], NULL);
+    }
+
+    if (exit == SUCCESS)
+    {
+        exit = read_directory(&members, &member_count, table_count);
+    }
+
+    // extract selected members by seeking to their offsets
+    for (unsigned long long i = 0; i < member_count && exit == SUCCESS; i++)
+    {
+        char out_filename[MAX_LENGTH_FILENAME];
+        unsigned int crc = CHECKSUM_INIT;
+
+        if (member_name != NULL && strcmp(members[i].name, member_name) != 0)
+        {
+            continue;
+        }
+        found = true;
+
+        exit = get_member_out_filename(members[i].name, out_filename);
+        if (exit == SUCCESS && members[i].table != built_table)
+        {
+            exit = build_code_table(tables[members[i].table], 0);
+            built_table = members[i].table;
+        }
+        if (exit == SUCCESS && seek_infile(members[i].offset) != SUCCESS)
+        {
+            exit = IO_EXCEPTION;
+        }
+        if (exit == SUCCESS)
+        {
+            exit = decode_file(out_filename, members[i].size, &crc);
+        }
+        if (exit == SUCCESS && checksum_final(crc) != members[i].crc)
+        {
+            exit = COMPRESSION_EXCEPTION;
+        }
+    }
+
+    if (exit == SUCCESS && !found)
+    {
+        exit = ARGUMENTS_EXCEPTION;
+    }
+
+    for (unsigned long long i = 0; i < member_count; i++)
+    {
+        free(members[i].name);
+    }
+    free(members);
+    free(tables);
+    release_code_table();
+    close_infile();
+
+    return exit;
+}
+
+extern bool is_archive(char *filename)
+{
+    char magic[2] = {'\0'};
+    FILE *file = fopen(filename, "rb");
+
+    if (file == NULL)
+    {
+        return false;
+    }
+
+    size_t size = fread(magic, sizeof(char), 2, file);
+    fclose(file);
+
+    return size == 2 && magic[0] == ARCHIVE_MAGIC[0] && magic[1] == ARCHIVE_MAGIC[1];
+}
+
+static unsigned int assign_table(TABLE *tables, unsigned int *table_count, const unsigned long long counts[])
+{
+    unsigned long long merged[NUM_OF_SYMBOLS];
+    double own_bits = entropy_bits(counts);
+    double best_extra_bits = table_bits(counts);
+    double min_extra_bits = HUGE_VAL;
+    int best = -1;
+    int min = 0;
+
+    for (unsigned int t = 0; t < *table_count; t++)
+    {
+        // extra cost of coding the member and the table's previous members with the merged distribution
+        for (int i = 0; i < NUM_OF_SYMBOLS; i++)
+        {
+            merged[i] = tables[t][i] + counts[i];
+        }
+        double extra_bits = entropy_bits(merged) - entropy_bits(tables[t]) - own_bits;
+
+        if (extra_bits < best_extra_bits)
+        {
+            best_extra_bits = extra_bits;
+            best = (int) t;
+        }
+        if (extra_bits < min_extra_bits)
+        {
+            min_extra_bits = extra_bits;
+            min = (int) t;
+        }
+    }
+
+    if (best == -1)
+    {
+        // new table pays off, reuse the closest one if the limit is reached
+        best = *table_count < MAX_TABLES ? (int) (*table_count)++ : min;
+    }
+
+    for (int i = 0; i < NUM_OF_SYMBOLS; i++)
+    {
+        tables[best][i] += counts[i];
+    }
+
+    return (unsigned int) best;
+}
+
+static double entropy_bits(const unsigned long long counts[])
+{
+    double total = 0.0;
+    double bits = 0.0;
+
+    for (int i = 0; i < NUM_OF_SYMBOLS; i++)
+    {
+        if (counts[i] > 0)
+        {
+            total += (double) counts[i];
+            bits -= (double) counts[i] * log2((double) counts[i]);
+        }
+    }
+
+    return total > 0.0 ? bits + total * log2(total) : 0.0;
+}
+
+static double table_bits(const unsigned long long counts[])
+{
+    double bytes = 1.0;
+
+    for (int i = 0; i < NUM_OF_SYMBOLS; i++)
+    {
+        if (counts[i] > 0)
+        {
+            // character and varint count
+            bytes += 1.0 + floor(log2((double) counts[i]) / 7.0) + 1.0;
+        }
+    }
+
+    return bytes * 8.0;
+}
+
+static void write_fixed(unsigned long long value, int length)
+{
+    for (int i = length - 1; i >= 0; i--)
+    {
+        write_char((unsigned char) (value >> (8 * i)));
+    }
+}
+
+static unsigned long long read_fixed(int length)
+{
+    unsigned long long value = 0;
+
+    for (int i = 0; i < length && has_next_char(); i++)
+    {
+        value = (value << 8) | read_char();
+    }
+    return value;
+}
+
+static EXIT read_directory(MEMBER **members, unsigned long long *member_count, unsigned int table_count)
+{
+    unsigned long long in_size = get_infile_size();
+    unsigned long long directory_offset;
+
+    // the offset of the central directory is stored at the end of the archive
+    if (in_size < TRAILER_SIZE || seek_infile(in_size - TRAILER_SIZE) != SUCCESS)
+    {
+        return COMPRESSION_EXCEPTION;
+    }
+    directory_offset = read_fixed(TRAILER_SIZE);
+    if (directory_offset >= in_size - TRAILER_SIZE || seek_infile(directory_offset) != SUCCESS)
+    {
+        return COMPRESSION_EXCEPTION;
+    }
+
+    *member_count = read_varint();
+    if (has_varint_error() || *member_count > in_size)
+    {
+        *member_count = 0;
+        return COMPRESSION_EXCEPTION;
+    }
+    *members = (MEMBER *) calloc((size_t) *member_count + 1, sizeof(MEMBER));
+    if (*members == NULL)
+    {
+        *member_count = 0;
+        return UNKNOWN_EXCEPTION;
+    }
+
+    for (unsigned long long i = 0; i < *member_count; i++)
+    {
+        MEMBER *member = *members + i;
+        unsigned long long name_length = read_varint();
+
+        if (has_varint_error() || name_length == 0 || name_length > MAX_LENGTH_FILENAME - 4)
+        {
+            return COMPRESSION_EXCEPTION;
+        }
+        member->name = (char *) malloc((size_t) name_length + 1);
+        if (member->name == NULL)
+        {
+            return UNKNOWN_EXCEPTION;
+        }
+        member->name[name_length] = '\0';
+        for (unsigned long long j = 0; j < name_length; j++)
+        {
+            if (!has_next_char())
+            {
+                return COMPRESSION_EXCEPTION;
+            }
+            member->name[j] = (char) read_char();
+        }
+
+        member->table = (unsigned int) read_varint();
+        member->offset = read_varint();
+        member->size = read_varint();
+        member->packed_size = read_varint();
+        member->crc = (unsigned int) read_fixed(4);
+
+        if (has_varint_error() || member->table >= table_count || member->offset > directory_offset
+            || member->packed_size > directory_offset - member->offset)
+        {
+            return COMPRESSION_EXCEPTION;
+        }
+    }
+
+    return SUCCESS;
+}
+
+static EXIT get_member_out_filename(char *name, char *out_filename)
+{
+    struct stat attribut;
+
+    // strip leading slashes, refuse to leave the current directory
+    while (*name == '/')
+    {
+        name++;
+    }
+    if (*name == '\0' || strcmp(name, "..") == 0 || strncmp(name, "../", 3) == 0
+        || strstr(name, "/../") != NULL
+        || (strlen(name) >= 3 && strcmp(name + strlen(name) - 3, "/..") == 0))
+    {
+        return COMPRESSION_EXCEPTION;
+    }
+
+    snprintf(out_filename, MAX_LENGTH_FILENAME, "%s.hd", name);
+
+    // create missing parent directories, an existing symlink among them could lead out of the current directory
+    for (char *separator = strchr(out_filename, '/'); separator != NULL; separator = strchr(separator + 1, '/'))
+    {
+        *separator = '\0';
+        if ((mkdir(out_filename, 0777) != 0 && errno != EEXIST)
+            || lstat(out_filename, &attribut) != 0 || !S_ISDIR(attribut.st_mode))
+        {
+            *separator = '/';
+            return IO_EXCEPTION;
+        }
+        *separator = '/';
+    }
+
+    // the outfile is opened by name, so it must not be a symlink either
+    if (lstat(out_filename, &attribut) == 0 && S_ISLNK(attribut.st_mode))
+    {
+        return IO_EXCEPTION;
+    }
+
+    return SUCCESS;
+}
@@ -0,0 +1,55 @@
+/**
+ * @file
+ * Dieses Modul implementiert solide Archive: mehrere Dateien werden in eine
+ * .hc-Datei gepackt. Dateien mit ähnlicher Zeichenverteilung teilen sich eine
+ * Code-Tabelle. Ein zentrales Verzeichnis am Dateiende (Name, Offset, Größe,
+ * Prüfsumme je Datei) erlaubt das Entpacken einzelner Dateien.
+ *
+ * Aufbau eines Archivs:
+ *  - Kennung ARCHIVE_MAGIC und FORMAT_VERSION
+ *  - Anzahl der Tabellen, je Tabelle die Häufigkeiten (write_frequencies())
+ *  - kodierte Inhalte der Dateien, jeweils ab einer Byte-Grenze
+ *  - zentrales Verzeichnis: Anzahl der Dateien, je Datei Namenslänge, Name,
+ *    Tabellenindex, Offset, Größe, kodierte Größe und CRC-32
+ *  - Offset des zentralen Verzeichnisses (8 Byte, Big Endian)
+ *
+ * @author  Tim Ostermann
+ * @date    2020-12-05
+ */
+
+#ifndef HUFFMAN_ARCHIVE_H
+#define HUFFMAN_ARCHIVE_H
+
+#include "huffman_common.h"
+
+/**
+ * Kennung am Anfang jedes Archivs
+ */
+#define ARCHIVE_MAGIC "HA"
+
+/**
+ * Packt alle Eingabedateien in ein Archiv.
+ * @param in_filenames - Namen der Eingabedateien
+ * @param in_count - Anzahl der Eingabedateien
+ * @param out_filename - Name des Archivs
+ * @return Exit-Code
+ */
+extern EXIT compress_archive(char **in_filenames, int in_count, char *out_filename);
+
+/**
+ * Entpackt alle oder eine Datei eines Archivs. Die Namen der Ausgabedateien
+ * sind die gespeicherten Namen mit Endung ".hd".
+ * @param in_filename - Name des Archivs
+ * @param member_name - Name der zu entpackenden Datei oder NULL für alle
+ * @return Exit-Code
+ */
+extern EXIT decompress_archive(char *in_filename, char *member_name);
+
+/**
+ * Gibt an, ob eine Datei ein Archiv ist.
+ * @param filename - Name der Datei
+ * @return Wahrheitswert
+ */
+extern bool is_archive(char *filename);
+
+#endif //HUFFMAN_ARCHIVE_H
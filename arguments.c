@@ -1,15 +1,80 @@
 #include "arguments.h"
+#include "huffman.h"
+#include "kernel.h"
 #include <string.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <dirent.h>
 #include <sys/stat.h>
 #include <time.h>
 
+/**
+ * Maximale Anzahl der Worker-Threads
+ */
+#define MAX_THREADS 1024
+
 /**
  * Variable zum Festhalten der Startzeit des Programms.
  */
 static clock_t prg_start;
 
-extern EXIT read_arguments(char *argv[], int argc, OPERATION_MODE *operation_mode, bool *should_view_info, bool *should_view_help, int *level, char *out_filename, char *in_filename)
+/**
+ * Fügt eine Eingabedatei hinzu. Verzeichnisse werden bei rekursivem Aufruf
+ * durchlaufen; dabei werden bei der Komprimierung nur Dateien ohne, bei der
+ * Dekomprimierung nur Dateien mit Endung ".hc" berücksichtigt.
+ * @param arguments - Zeiger auf die Eingabeparameter
+ * @param path - Name der Datei bzw. des Verzeichnisses
+ * @param from_directory - Gibt an, ob der Name beim Durchlaufen eines Verzeichnisses gefunden wurde
+ * @return entsprechender Exit-Code
+ */
+static EXIT add_input(ARGUMENTS *arguments, char *path, bool from_directory);
+
+/**
+ * Fügt alle Dateien eines Verzeichnisses rekursiv als Eingabedateien hinzu.
+ * @param arguments - Zeiger auf die Eingabeparameter
+ * @param path - Name des Verzeichnisses
+ * @return entsprechender Exit-Code
+ */
+static EXIT add_directory(ARGUMENTS *arguments, char *path);
+
+/**
+ * Liest zeilenweise Namen von Eingabedateien von der Standardeingabe.
+ * @param arguments - Zeiger auf die Eingabeparameter
+ * @return entsprechender Exit-Code
+ */
+static EXIT add_inputs_from_stdin(ARGUMENTS *arguments);
+
+/**
+ * Gibt an, ob ein Dateiname mit der Endung ".hc" endet.
+ * @param filename - Dateiname
+ * @return Wahrheitswert
+ */
+static bool has_compressed_extension(char *filename);
+
+/**
+ * Liest eine Anzahl Bytes, optional mit binärer Einheit K, M oder G.
+ * @param text - Zeichenkette
+ * @param byte_count - Übergabeparameter für die Anzahl
+ * @return ARGUMENTS_EXCEPTION, falls die Zeichenkette keine Anzahl größer 0 ist
+ */
+static EXIT parse_byte_count(char *text, unsigned long long *byte_count);
+
+/**
+ * Liest einen Filter: "auto" oder "delta", "xor" bzw. "shuffle", gefolgt
+ * von der Breite einer Lane (1, 2, 4 oder 8), optional mit "+shuffle".
+ * @param text - Zeichenkette
+ * @param filter - Übergabeparameter für den Filter
+ * @return ARGUMENTS_EXCEPTION, falls die Zeichenkette kein gültiger Filter ist
+ */
+static EXIT parse_filter(char *text, unsigned int *filter);
+
+/**
+ * Gibt eine Zeichenkette als JSON-String aus.
+ * @param text - Zeichenkette
+ */
+static void print_json_string(const char *text);
+
+extern EXIT read_arguments(char *argv[], int argc, ARGUMENTS *arguments)
 {
     // indices of legal arguments
     int argument_index_c = search_for_argument(argv, argc, "-c");
@@ -18,19 +83,42 @@ extern EXIT read_arguments(char *argv[], int argc, OPERATION_MODE *operation_mod
     int argument_index_h = search_for_argument(argv, argc, "-h");
     int argument_index_l = search_for_argument(argv, argc, "-l");
     int argument_index_o = search_for_argument(argv, argc, "-o");
+    int argument_index_r = search_for_argument(argv, argc, "-r");
+    int argument_index_t = search_for_argument(argv, argc, "-t");
+    int argument_index_s = search_for_argument(argv, argc, "-s");
+    int argument_index_x = search_for_argument(argv, argc, "-x");
+    int argument_index_m = search_for_argument(argv, argc, "-m");
+    int argument_index_u = search_for_argument(argv, argc, "-u");
+    int argument_index_z = search_for_argument(argv, argc, "-z");
+    int argument_index_w = search_for_argument(argv, argc, "-w");
+    int argument_index_f = search_for_argument(argv, argc, "-f");
+    int argument_index_a = search_for_argument(argv, argc, "-a");
+    int argument_index_j = search_for_argument(argv, argc, "-j");
+    int argument_index_n = search_for_argument(argv, argc, "-n");
+    int argument_index_p = search_for_argument(argv, argc, "-p");
+    int argument_index_table = search_for_argument(argv, argc, "--table-from");
 
     // determine, if program help shall be viewed
-    if (argument_index_h != -1)
+    arguments->should_view_help = argument_index_h != -1;
+
+    // get operation mode, the daemon receives it with every request
+    if (argument_index_u != -1)
     {
-        *should_view_help = true;
+        if (argument_index_c != -1 || argument_index_d != -1 || argument_index_a != -1)
+        {
+            return ARGUMENTS_EXCEPTION;
+        }
+        arguments->operation_mode = DAEMON;
     }
-    else
+    else if (argument_index_a != -1)
     {
-        *should_view_help = false;
+        if (argument_index_c != -1 || argument_index_d != -1)
+        {
+            return ARGUMENTS_EXCEPTION;
+        }
+        arguments->operation_mode = ANALYSIS;
     }
-
-    // get operation mode
-    if (argument_index_c == -1 && argument_index_d == -1 && !*should_view_help)
+    else if (argument_index_c == -1 && argument_index_d == -1 && !arguments->should_view_help)
     {
         return ARGUMENTS_EXCEPTION;
     }
@@ -38,44 +126,37 @@ extern EXIT read_arguments(char *argv[], int argc, OPERATION_MODE *operation_mod
     {
         if (argument_index_c > argument_index_d)
         {
-            *operation_mode = COMPRESSION;
+            arguments->operation_mode = COMPRESSION;
         }
         else
         {
-            *operation_mode = DECOMPRESSION;
+            arguments->operation_mode = DECOMPRESSION;
         }
     }
     else if (argument_index_c != -1)
     {
-        *operation_mode = COMPRESSION;
+        arguments->operation_mode = COMPRESSION;
     }
     else if (argument_index_d != -1)
     {
-        *operation_mode = DECOMPRESSION;
+        arguments->operation_mode = DECOMPRESSION;
     }
     else
     {
-        *operation_mode = HELP;
+        arguments->operation_mode = HELP;
         return SUCCESS;
     }
 
     // determine, if further information of the (de-)compression shall be viewed
-    if (argument_index_v != -1)
-    {
-        *should_view_info = true;
-    }
-    else
-    {
-        *should_view_info = false;
-    }
+    arguments->should_view_info = argument_index_v != -1;
 
-    // determine level of compression
-    if (*operation_mode == COMPRESSION && argument_index_l != -1)
+    // determine level of compression, the analysis splits blocks like it
+    if ((arguments->operation_mode == COMPRESSION || arguments->operation_mode == ANALYSIS) && argument_index_l != -1)
     {
         if (strlen(argv[argument_index_l]) == 3)
         {
-            *level = (int) (argv[argument_index_l][2] - '0');
-            if (*level < 1 || *level > 9)
+            arguments->level = (int) (argv[argument_index_l][2] - '0');
+            if (arguments->level < 1 || arguments->level > 9)
             {
                 return ARGUMENTS_EXCEPTION;
             }
@@ -86,67 +167,267 @@ extern EXIT read_arguments(char *argv[], int argc, OPERATION_MODE *operation_mod
         }
     }
 
-    // determine name of infile
-    if (argc < 2
-        || argc - 1 == argument_index_c
-        || argc - 1 == argument_index_d
-        || argc - 1 == argument_index_h
-        || argc - 1 == argument_index_l
-        || argc - 1 == argument_index_v
-        || argc - 1 == argument_index_o
-        || argc - 2 == argument_index_o
-        || strlen(argv[argc - 1]) > MAX_LENGTH_FILENAME)
+    // determine number of worker threads
+    if (argument_index_t != -1)
+    {
+        char *end = NULL;
+        long threads = strtol(argv[argument_index_t] + 2, &end, 10);
+        if (argv[argument_index_t][2] == '\0' || *end != '\0' || threads < 1 || threads > MAX_THREADS)
+        {
+            return ARGUMENTS_EXCEPTION;
+        }
+        arguments->threads = (int) threads;
+    }
+
+    // determine memory budget in bytes, optionally with binary suffix K, M or G
+    if (argument_index_m != -1)
+    {
+        if (strcmp(argv[argument_index_m], "-m") != 0 || argument_index_m + 1 >= argc
+            || parse_byte_count(argv[argument_index_m + 1], &arguments->memory_budget) != SUCCESS)
+        {
+            return ARGUMENTS_EXCEPTION;
+        }
+    }
+
+    // determine window of the lz77 stage, the daemon applies it to every compression
+    if (argument_index_z != -1)
+    {
+        if (strcmp(argv[argument_index_z], "-z") != 0
+            || (arguments->operation_mode != COMPRESSION && arguments->operation_mode != DAEMON))
+        {
+            return ARGUMENTS_EXCEPTION;
+        }
+        arguments->window_size = MAX_BLOCK_SIZE;
+    }
+    if (argument_index_w != -1)
+    {
+        if (argument_index_z == -1 || strcmp(argv[argument_index_w], "-w") != 0 || argument_index_w + 1 >= argc
+            || parse_byte_count(argv[argument_index_w + 1], &arguments->window_size) != SUCCESS
+            || arguments->window_size > MAX_BLOCK_SIZE)
+        {
+            return ARGUMENTS_EXCEPTION;
+        }
+    }
+
+    // determine filter of every block buffer, the daemon applies it to every compression
+    if (argument_index_f != -1)
+    {
+        if (strcmp(argv[argument_index_f], "-f") != 0 || argument_index_f + 1 >= argc
+            || (arguments->operation_mode != COMPRESSION && arguments->operation_mode != DAEMON)
+            || parse_filter(argv[argument_index_f + 1], &arguments->filter) != SUCCESS)
+        {
+            return ARGUMENTS_EXCEPTION;
+        }
+    }
+
+    // determine, if the analysis is printed as json
+    arguments->is_json = argument_index_j != -1;
+    if (arguments->is_json && arguments->operation_mode != ANALYSIS)
     {
         return ARGUMENTS_EXCEPTION;
     }
-    else
+
+    // determine, if files bypass the page cache
+    arguments->is_direct_io = argument_index_n != -1;
+
+    // determine, if large files are read and written by threads of their own
+    arguments->is_pipelined_io = argument_index_p != -1;
+
+    // determine, if directories shall be processed recursively
+    arguments->recursive = argument_index_r != -1;
+
+    // determine, if infiles shall be packed into one archive
+    arguments->solid = argument_index_s != -1;
+    if (arguments->solid && arguments->operation_mode != COMPRESSION)
     {
-        strncpy(in_filename, argv[argc - 1], MAX_LENGTH_FILENAME);
+        return ARGUMENTS_EXCEPTION;
     }
 
-    // determine name of outfile
-    if (argument_index_o != -1)
+    // determine name of single member to extract from an archive
+    if (argument_index_x != -1)
     {
-        if (argument_index_o + 1 == argument_index_c
+        if (arguments->operation_mode != DECOMPRESSION
+            || argument_index_x + 1 >= argc
+            || argv[argument_index_x + 1][0] == '-'
+            || strlen(argv[argument_index_x + 1]) > MAX_LENGTH_FILENAME - 4)
+        {
+            return ARGUMENTS_EXCEPTION;
+        }
+        strncpy(arguments->member_name, argv[argument_index_x + 1], MAX_LENGTH_FILENAME - 4);
+    }
+
+    // determine compressed file whose table encodes all infiles, which leaves nothing to count, search or filter
+    if (argument_index_table != -1)
+    {
+        if (strcmp(argv[argument_index_table], "--table-from") != 0
+            || arguments->operation_mode != COMPRESSION || arguments->solid
+            || argument_index_z != -1 || argument_index_f != -1
+            || argument_index_table + 1 >= argc
+            || strlen(argv[argument_index_table + 1]) > MAX_LENGTH_FILENAME - 4)
+        {
+            return ARGUMENTS_EXCEPTION;
+        }
+        strncpy(arguments->table_filename, argv[argument_index_table + 1], MAX_LENGTH_FILENAME - 4);
+    }
+
+    // determine name of the socket the daemon listens on
+    if (argument_index_u != -1)
+    {
+        if (strcmp(argv[argument_index_u], "-u") != 0
+            || argument_index_u + 1 >= argc
+            || argv[argument_index_u + 1][0] == '-'
+            || strlen(argv[argument_index_u + 1]) > MAX_LENGTH_FILENAME - 4)
+        {
+            return ARGUMENTS_EXCEPTION;
+        }
+        strncpy(arguments->socket_filename, argv[argument_index_u + 1], MAX_LENGTH_FILENAME - 4);
+    }
+
+    // check name of outfile
+    if (argument_index_o != -1
+        && (argument_index_o + 1 >= argc
+            || argument_index_o + 1 == argument_index_c
             || argument_index_o + 1 == argument_index_d
             || argument_index_o + 1 == argument_index_h
             || argument_index_o + 1 == argument_index_l
             || argument_index_o + 1 == argument_index_v
-            || argument_index_o + 2 >= argc
-            || strlen(argv[argument_index_o + 1]) > MAX_LENGTH_FILENAME - 4
-                )
-        {
-            return ARGUMENTS_EXCEPTION;
-        }
-        strncpy(out_filename, argv[argument_index_o + 1], MAX_LENGTH_FILENAME - 4);
+            || argument_index_o + 1 == argument_index_r
+            || argument_index_o + 1 == argument_index_t
+            || argument_index_o + 1 == argument_index_s
+            || argument_index_o + 1 == argument_index_x
+            || argument_index_o + 1 == argument_index_m
+            || argument_index_o + 1 == argument_index_u
+            || argument_index_o + 1 == argument_index_z
+            || argument_index_o + 1 == argument_index_w
+            || argument_index_o + 1 == argument_index_f
+            || argument_index_o + 1 == argument_index_a
+            || argument_index_o + 1 == argument_index_j
+            || argument_index_o + 1 == argument_index_n
+            || argument_index_o + 1 == argument_index_p
+            || argument_index_o + 1 == argument_index_table
+            || strlen(argv[argument_index_o + 1]) > MAX_LENGTH_FILENAME - 4))
+    {
+        return ARGUMENTS_EXCEPTION;
     }
-    else
+
+    // determine names of infiles, every other argument has to be a legal option
+    for (int i = 1; i < argc; i++)
     {
-        strncpy(out_filename, in_filename, MAX_LENGTH_FILENAME - 4);
-        if (*operation_mode == COMPRESSION)
+        EXIT exit = SUCCESS;
+
+        if (i == argument_index_c || i == argument_index_d || i == argument_index_v
+            || i == argument_index_h || i == argument_index_l || i == argument_index_o
+            || i == argument_index_r || i == argument_index_t
+            || i == argument_index_s || i == argument_index_x || i == argument_index_m
+            || i == argument_index_u || i == argument_index_z || i == argument_index_w || i == argument_index_f
+            || i == argument_index_a || i == argument_index_j || i == argument_index_n
+            || i == argument_index_p || i == argument_index_table
+            || (argument_index_o != -1 && i == argument_index_o + 1)
+            || (argument_index_table != -1 && i == argument_index_table + 1)
+            || (argument_index_x != -1 && i == argument_index_x + 1)
+            || (argument_index_m != -1 && i == argument_index_m + 1)
+            || (argument_index_u != -1 && i == argument_index_u + 1)
+            || (argument_index_w != -1 && i == argument_index_w + 1)
+            || (argument_index_f != -1 && i == argument_index_f + 1))
         {
-            strncat(out_filename, ".hc", MAX_LENGTH_FILENAME);
+            continue;
         }
-        else if (*operation_mode == DECOMPRESSION)
+
+        if (strcmp(argv[i], "-") == 0)
         {
-            strncat(out_filename, ".hd", MAX_LENGTH_FILENAME);
+            exit = add_inputs_from_stdin(arguments);
+        }
+        else if (argv[i][0] == '-')
+        {
+            exit = ARGUMENTS_EXCEPTION;
         }
         else
         {
-            return ARGUMENTS_EXCEPTION;
+            exit = add_input(arguments, argv[i], false);
         }
+
+        if (exit != SUCCESS)
+        {
+            return exit;
+        }
+    }
+
+    // the daemon's requests name their files themselves
+    if (arguments->operation_mode == DAEMON)
+    {
+        return arguments->in_count == 0 && argument_index_o == -1 ? SUCCESS : ARGUMENTS_EXCEPTION;
     }
 
-    if (strcmp(in_filename, out_filename) == 0)
+    if (arguments->in_count == 0)
     {
         return ARGUMENTS_EXCEPTION;
     }
 
-    if (check_number_of_arguments(argument_index_c, argument_index_d, argument_index_l, argument_index_h, argument_index_v, argument_index_o) != argc)
+    // the analysis writes no outfile
+    if (arguments->operation_mode == ANALYSIS)
+    {
+        return argument_index_o == -1 ? SUCCESS : ARGUMENTS_EXCEPTION;
+    }
+
+    // determine name of outfile, only possible for exactly one infile or an archive
+    if (argument_index_o != -1)
+    {
+        if (arguments->in_count != 1 && !arguments->solid)
+        {
+            return ARGUMENTS_EXCEPTION;
+        }
+        strncpy(arguments->out_filename, argv[argument_index_o + 1], MAX_LENGTH_FILENAME - 4);
+    }
+    else if (arguments->solid && arguments->in_count != 1)
+    {
+        return ARGUMENTS_EXCEPTION;
+    }
+    else if (arguments->in_count == 1
+             && get_default_out_filename(arguments->in_filenames[0], arguments->operation_mode,
+                                         arguments->out_filename) != SUCCESS)
     {
         return ARGUMENTS_EXCEPTION;
     }
 
+    for (int i = 0; i < arguments->in_count; i++)
+    {
+        if (strcmp(arguments->in_filenames[i], arguments->out_filename) == 0)
+        {
+            return ARGUMENTS_EXCEPTION;
+        }
+    }
+
+    return SUCCESS;
+}
+
+extern void free_arguments(ARGUMENTS *arguments)
+{
+    for (int i = 0; i < arguments->in_count; i++)
+    {
+        free(arguments->in_filenames[i]);
+    }
+    free(arguments->in_filenames);
+    arguments->in_filenames = NULL;
+    arguments->in_count = 0;
+    arguments->in_size = 0;
+}
+
+extern EXIT get_default_out_filename(char *in_filename, OPERATION_MODE operation_mode, char *out_filename)
+{
+    out_filename[0] = '\0';
+    strncat(out_filename, in_filename, MAX_LENGTH_FILENAME - 4);
+    if (operation_mode == COMPRESSION)
+    {
+        strncat(out_filename, ".hc", MAX_LENGTH_FILENAME);
+    }
+    else if (operation_mode == DECOMPRESSION)
+    {
+        strncat(out_filename, ".hd", MAX_LENGTH_FILENAME);
+    }
+    else
+    {
+        return ARGUMENTS_EXCEPTION;
+    }
     return SUCCESS;
 }
 
@@ -165,55 +446,221 @@ extern int search_for_argument(char *argv[], int argc, char *arg)
     return argument_index;
 }
 
-extern int check_number_of_arguments(int argument_index_c, int argument_index_d, int argument_index_l, int argument_index_h, int argument_index_v, int argument_index_o)
+static EXIT add_input(ARGUMENTS *arguments, char *path, bool from_directory)
 {
-    // program name and filename already counted
-    int arg_count = 2;
+    struct stat attribut;
+    bool exists;
 
-    if (argument_index_c != -1 && argument_index_d != -1)
+    if (strlen(path) > MAX_LENGTH_FILENAME - 4)
     {
-        arg_count += 2;
+        return ARGUMENTS_EXCEPTION;
     }
-    else
+
+    exists = stat(path, &attribut) == 0;
+    if (exists && S_ISDIR(attribut.st_mode))
     {
-        arg_count++;
+        return arguments->recursive ? add_directory(arguments, path) : ARGUMENTS_EXCEPTION;
     }
 
-    if (argument_index_l != -1)
+    // while walking directories, skip files that do not belong to the operation mode
+    if (from_directory
+        && (!exists || !S_ISREG(attribut.st_mode)
+            || has_compressed_extension(path) != (arguments->operation_mode == DECOMPRESSION)))
     {
-        arg_count++;
+        return SUCCESS;
     }
 
-    if (argument_index_h != -1)
+    if (arguments->in_count == arguments->in_size)
     {
-        arg_count++;
+        // double memory of infile names
+        arguments->in_size = arguments->in_size == 0 ? NUM_OF_ELEMENTS : arguments->in_size * 2;
+        arguments->in_filenames = (char **) realloc(arguments->in_filenames,
+                                                    sizeof(char *) * (size_t) arguments->in_size);
+        if (arguments->in_filenames == NULL)
+        {
+            return UNKNOWN_EXCEPTION;
+        }
     }
 
-    if (argument_index_v != -1)
+    arguments->in_filenames[arguments->in_count] = strdup(path);
+    arguments->in_count++;
+    return SUCCESS;
+}
+
+static EXIT add_directory(ARGUMENTS *arguments, char *path)
+{
+    DIR *dir = opendir(path);
+    struct dirent *entry;
+    struct stat attribut;
+    char entry_path[MAX_LENGTH_FILENAME];
+    EXIT exit = SUCCESS;
+
+    if (dir == NULL)
     {
-        arg_count++;
+        return IO_EXCEPTION;
     }
 
-    if (argument_index_o != -1)
+    while (exit == SUCCESS && (entry = readdir(dir)) != NULL)
+    {
+        if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0)
+        {
+            continue;
+        }
+
+        if (snprintf(entry_path, MAX_LENGTH_FILENAME, "%s/%s", path, entry->d_name) >= MAX_LENGTH_FILENAME - 4)
+        {
+            exit = ARGUMENTS_EXCEPTION;
+        }
+        // do not follow symbolic links to directories
+        else if (lstat(entry_path, &attribut) == 0 && !(S_ISLNK(attribut.st_mode) && stat(entry_path, &attribut) == 0
+                                                        && S_ISDIR(attribut.st_mode)))
+        {
+            exit = add_input(arguments, entry_path, true);
+        }
+    }
+
+    closedir(dir);
+    return exit;
+}
+
+static EXIT add_inputs_from_stdin(ARGUMENTS *arguments)
+{
+    char line[MAX_LENGTH_FILENAME + 2];
+
+    while (fgets(line, sizeof(line), stdin) != NULL)
     {
-        arg_count += 2;
+        size_t length = strcspn(line, "\r\n");
+        if (line[length] == '\0' && !feof(stdin))
+        {
+            // line longer than maximal length of filename
+            return ARGUMENTS_EXCEPTION;
+        }
+        line[length] = '\0';
+
+        if (length > 0 && add_input(arguments, line, false) != SUCCESS)
+        {
+            return ARGUMENTS_EXCEPTION;
+        }
     }
 
-    return arg_count;
+    return SUCCESS;
+}
+
+static bool has_compressed_extension(char *filename)
+{
+    size_t length = strlen(filename);
+    return length > 3 && strcmp(filename + length - 3, ".hc") == 0;
+}
+
+static EXIT parse_byte_count(char *text, unsigned long long *byte_count)
+{
+    char *end = NULL;
+    unsigned long long count;
+
+    if (text[0] < '0' || text[0] > '9')
+    {
+        return ARGUMENTS_EXCEPTION;
+    }
+    count = strtoull(text, &end, 10);
+    switch (*end)
+    {
+        case 'G':
+        case 'g':
+            count <<= 10;
+            // fall through
+        case 'M':
+        case 'm':
+            count <<= 10;
+            // fall through
+        case 'K':
+        case 'k':
+            count <<= 10;
+            end++;
+            break;
+        default:
+            break;
+    }
+    if (*end != '\0' || count == 0)
+    {
+        return ARGUMENTS_EXCEPTION;
+    }
+    *byte_count = count;
+    return SUCCESS;
+}
+
+static EXIT parse_filter(char *text, unsigned int *filter)
+{
+    static const char *transforms[] = {"shuffle", "delta", "xor"};
+    static const unsigned int transform_filters[] = {FILTER_SHUFFLE, FILTER_DELTA, FILTER_XOR};
+    char *end = NULL;
+    unsigned long lane;
+    size_t length;
+    int i = 0;
+
+    if (strcmp(text, "auto") == 0)
+    {
+        *filter = FILTER_AUTO;
+        return SUCCESS;
+    }
+
+    while (i < 3 && strncmp(text, transforms[i], strlen(transforms[i])) != 0)
+    {
+        i++;
+    }
+    if (i == 3)
+    {
+        return ARGUMENTS_EXCEPTION;
+    }
+    length = strlen(transforms[i]);
+    if (text[length] < '1' || text[length] > '8')
+    {
+        return ARGUMENTS_EXCEPTION;
+    }
+    lane = strtoul(text + length, &end, 10);
+    *filter = transform_filters[i];
+    if (i > 0 && strcmp(end, "+shuffle") == 0)
+    {
+        *filter |= FILTER_SHUFFLE;
+        end += strlen(end);
+    }
+    if (*end != '\0' || (lane != 1 && lane != 2 && lane != 4 && lane != 8))
+    {
+        return ARGUMENTS_EXCEPTION;
+    }
+
+    // the lane width is stored as its logarithm
+    *filter |= lane == 1 ? 0 : lane == 2 ? 1 : lane == 4 ? 2 : 3;
+    return is_valid_filter(*filter) ? SUCCESS : ARGUMENTS_EXCEPTION;
 }
 
 extern void print_help(void)
 {
     printf("Programmhilfe Huffman:\n"
-           "Aufruf: huffman <options> <filename>\n"
+           "Aufruf: huffman <options> <filename> [<filename> ...]\n"
+           "        huffman -a [-j] [-l<level>] <filename> [<filename> ...]\n"
+           "        huffman -u <socket> [-t<threads>] [-m <bytes>] [-z [-w <bytes>]] [-f <filter>] [-n] [-p] [-v]\n"
            " -c\tDie Eingabedatei wird komprimiert.\n"
            " -d\tDie Eingabedatei wird dekomprimiert.\n"
            " \tSind im Aufruf beide Optionen -c und -d angegeben, bestimmt die letzte Angabe, ob komprimiert oder dekomprimiert wird.\n"
-           " -l<level>\tLegt den Level der Komprimierung fest. Der Wert für den Level folgt ohne Leerzeichen auf die Option -l und muss zwischen 1 und 9 liegen. Fehlt die Option, wird der Level standardmäßig auf 2 eingestellt. Der Parameter wird ignoriert, wenn die Option -d angegeben wurde.\n"
+           " -l<level>\tLegt den Level der Komprimierung fest. Der Wert für den Level folgt ohne Leerzeichen auf die Option -l und muss zwischen 1 und 9 liegen. Beim Level 1 werden große Dateien nur einmal gelesen, die Code-Tabelle stammt dann aus einer Stichprobe der Datei. Ab Level 2 wird ein Block mit tANS statt mit Huffman-Codes kodiert, wenn er dadurch kürzer wird, etwa bei sehr ungleich verteilten Zeichen. Ab Level 5 enden Blöcke dort, wo sich die Verteilung der Zeichen ändert, sodass jeder Abschnitt eine passende Code-Tabelle erhält. Ab Level 8 wird jeder Block zusätzlich mit einer Burrows-Wheeler-Transformation versucht, was vor allem bei Text deutlich kleinere Dateien ergibt, aber langsamer ist. Fehlt die Option, wird der Level standardmäßig auf 2 eingestellt. Der Parameter wird ignoriert, wenn die Option -d angegeben wurde.\n"
+           " -a\tAnalysiert die Eingabedateien, ohne sie zu komprimieren: Ausgegeben werden Entropie, die exakte Größe mit Huffman-Codes samt Köpfen und Tabellen, die mittlere Codelänge und wie stark die Entropie der Blöcke schwankt. Blöcke werden wie bei der Komprimierung mit dem angegebenen Level gebildet; tANS, Filter und Vorstufen bleiben außen vor.\n"
+           " -j\tGibt die Analyse je Eingabedatei als JSON-Objekt in einer Zeile aus.\n"
            " -v\tGibt Informationen über die Komprimierung bzw. Dekomprimierung aus.\n"
            " -o <outfile>\tLegt den Namen der Ausgabedatei fest. Wird die Option weggelassen, wird der Name der Ausgabedatei standardmäßig festgelegt.\n"
+           " -r\tVerzeichnisse werden rekursiv durchlaufen. Bei der Komprimierung werden alle Dateien ohne, bei der Dekomprimierung alle Dateien mit Endung .hc verarbeitet.\n"
+           " -s\tAlle Eingabedateien werden in ein solides Archiv gepackt. Dateien mit ähnlicher Zeichenverteilung teilen sich eine Code-Tabelle. Bei mehreren Eingabedateien ist -o erforderlich. Archive werden mit -d automatisch erkannt und alle Dateien unter ihrem gespeicherten Namen mit Endung .hd entpackt.\n"
+           " -x <member>\tEntpackt nur die angegebene Datei aus einem Archiv.\n"
+           " -t<threads>\tLegt die Anzahl der Threads fest, die mehrere Eingabedateien parallel verarbeiten. Beim Komprimieren werden Dateien über 4 MiB in Teile zerlegt, die mehrere Threads gleichzeitig bearbeiten; ohne Stichprobe beginnt jeder Teil mit einer eigenen Code-Tabelle. Fehlt die Option, wird die Anzahl der Prozessoren verwendet.\n"
+           " -n\tLiest und schreibt reguläre Dateien mit O_DIRECT in ausgerichteten Abschnitten von 4 MiB am Seitencache vorbei, sodass sehr große Dateien keine anderen Daten aus dem Cache verdrängen. Unterstützt das Dateisystem O_DIRECT nicht, wird gepuffert gelesen und geschrieben.\n"
+           " --table-from <file>\tKodiert jede Eingabedatei in einem Durchgang mit der Code-Tabelle des ersten Blocks einer früher komprimierten Datei, ohne die Datei vorab zu zählen; das lohnt sich bei Dateien mit nahezu gleicher Zeichenverteilung. Zeichen, die in der Tabelle fehlen, werden über ein Escape-Symbol kodiert. Ein Block, den eine eigene Tabelle kürzer kodiert, erhält diese. Die Datei muss mit -c ohne -z und -f komprimiert sein. Nicht mit -s, -z und -f.\n"
+           " -p\tLiest und schreibt große Dateien beim Komprimieren in je einem eigenen Thread, sodass Lesen, Kodieren und Schreiben gleichzeitig laufen. Die Threads reichen sich Puffer von 1 MiB über Ringe ohne Sperren weiter. Ohne Wirkung mit -n.\n"
+           " -m <bytes>\tBegrenzt den Speicher des Programms auf die angegebene Anzahl Bytes, optional mit Einheit K, M oder G. Blockgröße und Anzahl der Threads werden so gewählt, dass die Grenze eingehalten wird; reicht sie nicht aus, bricht das Programm ab.\n"
+           " -z\tZerlegt jeden Block vor der Kodierung in LZ77-Sequenzen aus Literalen und Verweisen auf frühere Wiederholungen, falls er dadurch kürzer wird. Literale sowie Anzahlen, Längen und Abstände der Verweise erhalten je eine eigene Code-Tabelle. Je höher der Level, desto gründlicher wird nach Verweisen gesucht.\n"
+           " -w <bytes>\tLegt mit -z den größten Abstand eines Verweises fest, optional mit Einheit K, M oder G, höchstens 256K. Fehlt die Option, reichen Verweise bis zum Anfang des Blocks.\n"
+           " -f <filter>\tFiltert jeden Block vor der Kodierung, was Felder von Zahlen fester Breite deutlich verkleinert. delta<N> speichert die Differenz zur vorherigen Zahl aus N Bytes (1, 2, 4 oder 8), xor<N> das XOR mit ihr, etwa bei Gleitkommazahlen. shuffle<N> sowie der Zusatz +shuffle legen die Bytes gleicher Stelle aller Zahlen hintereinander, die dann eigene Code-Tabellen erhalten. auto wählt je Block den Filter, der laut Schätzung am kürzesten ist, oder keinen. Die Dekomprimierung erkennt Filter automatisch.\n"
+           " -u <socket>\tStartet einen Dienst, der an dem Unix-Socket Anfragen annimmt, bis er mit SIGINT oder SIGTERM beendet wird. Jede Anfrage ist eine Zeile: \"c <level> <infile> <outfile>\" bzw. \"d <infile> <outfile>\" bearbeitet Dateien, \"C <level> <size>\" bzw. \"D <size>\" die folgenden size Bytes. Statt eines Dateinamens steht - für einen mit der Anfrage übergebenen Dateideskriptor. Die Antwort enthält den Exit-Code, bei C und D gefolgt von der Größe des Ergebnisses, das danach gesendet wird.\n"
            " -h\tZeigt eine Hilfe an, die die Benutzung des Programms erklärt.\n"
-           " <filename>\tName der Eingabedatei.\n\n");
+           " <filename>\tName der Eingabedatei. Es können mehrere Dateien angegeben werden; - liest die Namen zeilenweise von der Standardeingabe. Die Option -o ist dann nicht erlaubt.\n\n");
 }
 
 extern void start_clock(void)
@@ -224,14 +671,74 @@ extern void start_clock(void)
 extern void print_further_information(char *in_filename, char *out_filename)
 {
     struct stat attribut;
-    stat(in_filename, &attribut);
-    printf(" - Größe der Eingabedatei %s (byte): %d\n",
-           in_filename, (int) attribut.st_size);
+    if (in_filename != NULL)
+    {
+        stat(in_filename, &attribut);
+        printf(" - Größe der Eingabedatei %s (byte): %lld\n",
+               in_filename, (long long) attribut.st_size);
+    }
 
     stat(out_filename, &attribut);
-    printf(" - Größe der Ausgabedatei %s (byte): %d\n",
-           out_filename, (int) attribut.st_size);
+    printf(" - Größe der Ausgabedatei %s (byte): %lld\n",
+           out_filename, (long long) attribut.st_size);
     clock_t prg_end = clock();
     printf(" - Die Laufzeit betrug %.4f Sekunden\n",
            (float) (prg_end - prg_start) / CLOCKS_PER_SEC);
-}
\ No newline at end of file
+}
+
+extern void print_analysis(char *in_filename, const FILE_ANALYSIS *analysis, bool is_json)
+{
+    // order 0 over the whole file, blocks with tables of their own may well end up smaller
+    double order0_size = analysis->entropy * (double) analysis->char_count / 8;
+
+    if (is_json)
+    {
+        printf("{\"file\":");
+        print_json_string(in_filename);
+        printf(",\"size\":%llu,\"entropy\":%.6f,\"order0_entropy_size\":%.0f,\"huffman_size\":%llu,"
+               "\"average_code_length\":%.6f,\"blocks\":%llu,\"reused_tables\":%llu,"
+               "\"block_entropy_min\":%.6f,\"block_entropy_max\":%.6f,\"block_entropy_deviation\":%.6f}\n",
+               analysis->char_count, analysis->entropy, order0_size, analysis->huffman_size,
+               analysis->average_code_length, analysis->block_count, analysis->reused_count,
+               analysis->min_block_entropy, analysis->max_block_entropy, analysis->block_entropy_deviation);
+        return;
+    }
+
+    printf("Analyse von %s:\n", in_filename);
+    printf(" - Größe (byte): %llu\n", analysis->char_count);
+    printf(" - Entropie 0. Ordnung der Gesamtdatei (bit/Zeichen): %.4f, entspricht (byte): %.0f\n",
+           analysis->entropy, order0_size);
+    printf(" - Größe mit Huffman-Codes samt Köpfen (byte): %llu", analysis->huffman_size);
+    if (analysis->char_count > 0)
+    {
+        printf(", Anteil %.2f %%", 100.0 * (double) analysis->huffman_size / (double) analysis->char_count);
+    }
+    printf("\n - Mittlere Codelänge (bit/Zeichen): %.4f\n", analysis->average_code_length);
+    printf(" - Blöcke: %llu, davon %llu mit Tabelle des Vorgängers\n", analysis->block_count, analysis->reused_count);
+    printf(" - Entropie je Block (bit/Zeichen): %.4f bis %.4f, Standardabweichung %.4f\n",
+           analysis->min_block_entropy, analysis->max_block_entropy, analysis->block_entropy_deviation);
+}
+
+static void print_json_string(const char *text)
+{
+    putchar('"');
+    for (; *text != '\0'; text++)
+    {
+        unsigned char c = (unsigned char) *text;
+
+        // names are passed through as bytes, only quotes, backslashes and control chars are escaped
+        if (c == '"' || c == '\\')
+        {
+            printf("\\%c", c);
+        }
+        else if (c < 0x20)
+        {
+            printf("\\u%04x", c);
+        }
+        else
+        {
+            putchar(c);
+        }
+    }
+    putchar('"');
+}
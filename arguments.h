@@ -1,4 +1,5 @@
 #include "huffman_common.h"
+#include "huffman.h"
 
 #ifndef HUFFMAN_ARGUMENTS_H
 #define HUFFMAN_ARGUMENTS_H
@@ -11,22 +12,146 @@ typedef enum
     NONE = -1,
     HELP = 0,
     COMPRESSION = 1,
-    DECOMPRESSION = 2
+    DECOMPRESSION = 2,
+    DAEMON = 3,
+    ANALYSIS = 4
 } OPERATION_MODE;
 
+/**
+ * Eingabeparameter des Konsolenaufrufs
+ */
+typedef struct
+{
+    /**
+     * Ausführungsmodus
+     */
+    OPERATION_MODE operation_mode;
+
+    /**
+     * Gibt an, ob weitere Informationen ausgegeben werden sollen
+     */
+    bool should_view_info;
+
+    /**
+     * Gibt an, ob die Programmhilfe ausgegeben werden soll
+     */
+    bool should_view_help;
+
+    /**
+     * Komprimierungslevel
+     */
+    int level;
+
+    /**
+     * Anzahl der Worker-Threads, 0 für Anzahl der Prozessoren
+     */
+    int threads;
+
+    /**
+     * Obergrenze für den Speicher des Prozesses in Bytes, 0 für unbegrenzt
+     */
+    unsigned long long memory_budget;
+
+    /**
+     * Fenster der LZ77-Vorstufe in Bytes, 0 für keine Vorstufe
+     */
+    unsigned long long window_size;
+
+    /**
+     * Filter der Blöcke, FILTER_AUTO oder 0 für keinen
+     */
+    unsigned int filter;
+
+    /**
+     * Gibt an, ob die Analyse als JSON ausgegeben wird
+     */
+    bool is_json;
+
+    /**
+     * Gibt an, ob Dateien mit O_DIRECT am Seitencache vorbei gelesen und
+     * geschrieben werden
+     */
+    bool is_direct_io;
+
+    /**
+     * Gibt an, ob große Dateien in eigenen Threads gelesen und geschrieben
+     * werden
+     */
+    bool is_pipelined_io;
+
+    /**
+     * Gibt an, ob Verzeichnisse rekursiv durchlaufen werden
+     */
+    bool recursive;
+
+    /**
+     * Gibt an, ob alle Eingabedateien in ein solides Archiv gepackt werden
+     */
+    bool solid;
+
+    /**
+     * Name der einzelnen aus einem Archiv zu entpackenden Datei, leer für alle
+     */
+    char member_name[MAX_LENGTH_FILENAME];
+
+    /**
+     * Name der komprimierten Datei, deren Tabelle alle Eingabedateien
+     * kodiert, leer für eigene Tabellen
+     */
+    char table_filename[MAX_LENGTH_FILENAME];
+
+    /**
+     * Name der Ausgabedatei, nur bei genau einer Eingabedatei oder einem
+     * Archiv gesetzt
+     */
+    char out_filename[MAX_LENGTH_FILENAME];
+
+    /**
+     * Name des Sockets, an dem der Dienst Anfragen annimmt
+     */
+    char socket_filename[MAX_LENGTH_FILENAME];
+
+    /**
+     * Namen der Eingabedateien
+     */
+    char **in_filenames;
+
+    /**
+     * Anzahl der Eingabedateien
+     */
+    int in_count;
+
+    /**
+     * Größe des Speichers für die Namen der Eingabedateien
+     */
+    int in_size;
+} ARGUMENTS;
+
 /**
  * Liest Eingabeparameter des Konsolenaufrufs aus.
+ * Neben Dateinamen werden Verzeichnisse (mit -r) sowie "-" für eine
+ * zeilenweise Liste von Dateinamen auf der Standardeingabe akzeptiert.
  * @param argv - Eingabeparameter
  * @param argc - Anzahl Eingabeparameter
- * @param operation_mode - Zeiger auf Ausführungsmodus
- * @param print_info - Zeiger auf Wahrheitswert, der Angabe weiterer Informationen repräsentiert
- * @param should_view_help - Zeiger auf Wahrheitswert, der Angabe von Programmhilfe repräsentiert
- * @param level - Zeiger auf Komprimierungslevel
+ * @param arguments - Zeiger auf die zu füllenden Eingabeparameter
+ * @return entsprechender Exit-Code
+ */
+extern EXIT read_arguments(char *argv[], int argc, ARGUMENTS *arguments);
+
+/**
+ * Gibt den Speicher der Eingabeparameter frei.
+ * @param arguments - Zeiger auf die Eingabeparameter
+ */
+extern void free_arguments(ARGUMENTS *arguments);
+
+/**
+ * Bestimmt den Standardnamen der Ausgabedatei (Endung ".hc" bzw. ".hd").
+ * @param in_filename - Name der Eingabedatei
+ * @param operation_mode - Ausführungsmodus
  * @param out_filename - Zeiger auf Ausgabedatei
- * @param in_filename - Zeiger auf Eingabedatei
  * @return entsprechender Exit-Code
  */
-extern EXIT read_arguments(char *argv[], int argc, OPERATION_MODE *operation_mode, bool *print_info, bool *should_view_help, int *level, char *out_filename, char *in_filename);
+extern EXIT get_default_out_filename(char *in_filename, OPERATION_MODE operation_mode, char *out_filename);
 
 /**
  * Sucht nach bestimmten Parameter in den Eingabeparametern.
@@ -37,18 +162,6 @@ extern EXIT read_arguments(char *argv[], int argc, OPERATION_MODE *operation_mod
  */
 extern int search_for_argument(char *argv[], int argc, char *arg);
 
-/**
- * Bestimmt Anzahl der vorkommenden legalen Eingabeparameter.
- * @param argument_index_c - Index des "-c"-Parameters
- * @param argument_index_d - Index des "-d"-Parameters
- * @param argument_index_l - Index des "-l"-Parameters
- * @param argument_index_h - Index des "-h"-Parameters
- * @param argument_index_v - Index des "-v"-Parameters
- * @param argument_index_o - Index des "-o"-Parameters
- * @return Anzahl der legalen Eingabeparameter
- */
-extern int check_number_of_arguments(int argument_index_c, int argument_index_d, int argument_index_l, int argument_index_h, int argument_index_v, int argument_index_o);
-
 /**
  * Gibt Programmhilfe aus.
  */
@@ -61,10 +174,19 @@ extern void start_clock(void);
 
 /**
  * Gibt weitere Informationen zur Programmdurchführung aus.
- * @param in_filename - Name der Eingabedatei
+ * @param in_filename - Name der Eingabedatei oder NULL
  * @param out_filename - Name der Ausgabedatei
  */
 extern void print_further_information(char *in_filename, char *out_filename);
 
+/**
+ * Gibt das Ergebnis der Analyse einer Datei aus, als Text oder als
+ * JSON-Objekt in einer Zeile.
+ * @param in_filename - Name der Eingabedatei
+ * @param analysis - Ergebnis der Analyse
+ * @param is_json - Gibt an, ob als JSON ausgegeben wird
+ */
+extern void print_analysis(char *in_filename, const FILE_ANALYSIS *analysis, bool is_json);
+
 
 #endif //HUFFMAN_ARGUMENTS_H
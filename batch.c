@@ -0,0 +1,835 @@
+#include "batch.h"
+#include "huffman.h"
+#include "archive.h"
+#include "node.h"
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ * Speicher des Prozesses unabhängig von der Anzahl der Threads (Programm,
+ * Bibliotheken, Hauptthread, Tabellen eines Archivs)
+ */
+#define PROCESS_BASE_MEMORY 4194304
+
+/**
+ * Größe der Teile, in die größere Eingabedateien zerlegt werden, wenn
+ * mehrere Threads komprimieren; ein Vielfaches jeder Blockgröße
+ */
+#define PART_SIZE 4194304
+
+/**
+ * Speicher je Thread für die Ausgabe seines Teils und für fertige Teile,
+ * die noch auf ihre Vorgänger warten
+ */
+#define PART_THREAD_MEMORY (3 * (unsigned long long) PART_SIZE)
+
+/**
+ * Komprimierte Ausgabe eines Teils
+ */
+typedef struct
+{
+    /**
+     * Anfang der Ausgabe, NULL, solange der Teil nicht fertig ist
+     */
+    unsigned char *data;
+
+    /**
+     * Anzahl der Bytes
+     */
+    size_t size;
+} PART_OUTPUT;
+
+/**
+ * Auftrag für eine Eingabedatei. Große Dateien werden beim Komprimieren in
+ * Teile zerlegt, die beliebige Threads in aufsteigender Reihenfolge
+ * übernehmen; ihre Ausgaben werden in dieser Reihenfolge geschrieben.
+ */
+typedef struct
+{
+    /**
+     * Name der Eingabedatei
+     */
+    char *in_filename;
+
+    /**
+     * Anzahl der Teile, 1, wenn die Datei als Ganzes bearbeitet wird
+     */
+    unsigned long long part_count;
+
+    /**
+     * Nummer des nächsten zu übernehmenden Teils
+     */
+    unsigned long long next_part;
+
+    /**
+     * Anzahl der fertigen Teile
+     */
+    unsigned long long finished_count;
+
+    /**
+     * Anzahl der in die Ausgabedatei geschriebenen Teile
+     */
+    unsigned long long committed_count;
+
+    /**
+     * Gibt an, ob gerade ein Thread Teile in die Ausgabedatei schreibt
+     */
+    bool is_committing;
+
+    /**
+     * Angaben zu allen Teilen, wird vor dem ersten Teil bestimmt; NULL, wenn
+     * das fehlschlägt
+     */
+    COMPRESS_PLAN *plan;
+
+    /**
+     * Ausgaben der fertigen, noch nicht geschriebenen Teile
+     */
+    PART_OUTPUT *outputs;
+
+    /**
+     * Ausgabedatei, wird mit dem ersten Teil geöffnet
+     */
+    FILE *outfile;
+
+    /**
+     * Exit-Code des ersten fehlgeschlagenen Teils
+     */
+    EXIT exit;
+
+    /**
+     * Schützt alle Angaben des Auftrags
+     */
+    pthread_mutex_t mutex;
+} BATCH_JOB;
+
+/**
+ * Aufträge eines Worker-Threads als Bereich der Auftragsliste. Der Worker
+ * bearbeitet sie von vorne, andere Worker stehlen die hintere Hälfte.
+ */
+typedef struct
+{
+    /**
+     * Index des Auftrags, an dem der Worker arbeitet
+     */
+    int head;
+
+    /**
+     * Index hinter dem letzten Auftrag
+     */
+    int tail;
+
+    /**
+     * Schützt head und tail
+     */
+    pthread_mutex_t mutex;
+} JOB_DEQUE;
+
+/**
+ * Eingabeparameter des laufenden Aufrufs
+ */
+static ARGUMENTS *batch_arguments;
+
+/**
+ * Aufträge aller Eingabedateien in deren Reihenfolge
+ */
+static BATCH_JOB *batch_jobs;
+
+/**
+ * Deque je Worker-Thread
+ */
+static JOB_DEQUE *deques;
+
+/**
+ * Anzahl der Deques
+ */
+static int deque_count;
+
+/**
+ * Anzahl der fertigen Teile, die noch auf ihre Vorgänger warten
+ */
+static unsigned long long pending_parts;
+
+/**
+ * Höchste Anzahl wartender Teile, bevor keine weiteren Teile übernommen werden
+ */
+static unsigned long long max_pending_parts;
+
+/**
+ * Exit-Code der ersten fehlgeschlagenen Datei
+ */
+static EXIT batch_exit;
+
+/**
+ * Schützt pending_parts, batch_exit und die Bildschirmausgabe
+ */
+static pthread_mutex_t batch_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ * Signalisiert, dass wartende Teile geschrieben wurden
+ */
+static pthread_cond_t pending_cond = PTHREAD_COND_INITIALIZER;
+
+/**
+ * Arbeitsfunktion eines Worker-Threads: übernimmt so lange Dateien und
+ * Teile von Dateien, bis keine mehr übrig sind. Ein Worker wird zuerst an
+ * seinen NUMA-Knoten gebunden, sodass er seinen Speicher dort anlegt.
+ * @param worker - Nummer des Worker-Threads ab 1, NULL für den Hauptthread
+ * @return NULL
+ */
+static void *work(void *worker);
+
+/**
+ * Übernimmt den nächsten Teil eines Auftrags: zuerst aus der eigenen Deque,
+ * sonst wird die hintere Hälfte der Aufträge eines anderen Workers
+ * gestohlen oder, wenn dieser nur noch einen hat, dessen nächster Teil
+ * übernommen.
+ * @param worker - Nummer des Worker-Threads ab 0
+ * @param job - Übergabeparameter für den Auftrag
+ * @param part - Übergabeparameter für die Nummer des Teils
+ * @return Wahrheitswert, ob ein Teil übernommen wurde, false, wenn alle vergeben sind
+ */
+static bool take_part(int worker, BATCH_JOB **job, unsigned long long *part);
+
+/**
+ * Stiehlt die hintere Hälfte der Aufträge eines anderen Workers in die
+ * eigene, leere Deque. Worker auf dem eigenen NUMA-Knoten werden zuerst
+ * bestohlen, damit die Teile einer Datei möglichst auf einem Knoten
+ * bleiben.
+ * @param worker - Nummer des stehlenden Worker-Threads ab 0
+ * @return den Auftrag, an dem weitergearbeitet wird, NULL, falls kein
+ *         Worker mehr unvergebene Teile hat
+ */
+static BATCH_JOB *steal_job(int worker);
+
+/**
+ * Stiehlt die hintere Hälfte der Aufträge eines Workers oder teilt dessen
+ * letzten Auftrag, wenn er noch unvergebene Teile hat.
+ * @param worker - Nummer des stehlenden Worker-Threads ab 0
+ * @param victim - Deque des bestohlenen Workers
+ * @return den Auftrag, an dem weitergearbeitet wird, NULL, falls der
+ *         Worker nichts abgeben kann
+ */
+static BATCH_JOB *steal_from(int worker, JOB_DEQUE *victim);
+
+/**
+ * Übernimmt den nächsten Teil eines Auftrags. Vor dem ersten Teil einer
+ * zerlegten Datei wird die Komprimierung vorbereitet.
+ * @param job - Auftrag
+ * @param part - Übergabeparameter für die Nummer des Teils
+ * @return Wahrheitswert, ob ein Teil übernommen wurde
+ */
+static bool take_from_job(BATCH_JOB *job, unsigned long long *part);
+
+/**
+ * Gibt an, ob ein Auftrag noch unvergebene Teile hat.
+ * @param job - Auftrag
+ * @return Wahrheitswert
+ */
+static bool has_parts(BATCH_JOB *job);
+
+/**
+ * Bearbeitet eine Eingabedatei als Ganzes und meldet das Ergebnis.
+ * @param job - Auftrag der Datei
+ */
+static void run_file(BATCH_JOB *job);
+
+/**
+ * Komprimiert einen Teil einer zerlegten Datei.
+ * @param job - Auftrag der Datei
+ * @param part - Nummer des Teils
+ */
+static void run_part(BATCH_JOB *job, unsigned long long part);
+
+/**
+ * Schreibt die fertigen Teile eines Auftrags, die an die bereits
+ * geschriebenen anschließen, in die Ausgabedatei. Schreibt schon ein
+ * anderer Thread, übernimmt dieser auch die neuen Teile.
+ * Vorbedingung: Der Mutex des Auftrags ist gesperrt.
+ * @param job - Auftrag
+ */
+static void commit_parts(BATCH_JOB *job);
+
+/**
+ * Ändert die Anzahl der wartenden Teile.
+ * @param delta - Änderung
+ */
+static void add_pending_parts(long long delta);
+
+/**
+ * Meldet das Ergebnis einer Datei auf dem Bildschirm.
+ * @param in_filename - Name der Eingabedatei
+ * @param exit - Exit-Code der Datei
+ * @param analysis - Ergebnis der Analyse oder NULL
+ */
+static void report_file(char *in_filename, EXIT exit, FILE_ANALYSIS *analysis);
+
+/**
+ * Bestimmt den Namen der Ausgabedatei zu einer Eingabedatei.
+ * @param in_filename - Name der Eingabedatei
+ * @param out_filename - Übergabeparameter für den Namen der Ausgabedatei
+ */
+static void get_out_filename(char *in_filename, char *out_filename);
+
+/**
+ * Liefert die Anzahl der Teile, in die eine Eingabedatei zerlegt wird.
+ * @param in_filename - Name der Eingabedatei
+ * @return Anzahl der Teile, 1, falls die Größe nicht bestimmt werden kann
+ */
+static unsigned long long get_part_count(char *in_filename);
+
+extern EXIT apply_memory_budget(ARGUMENTS *arguments)
+{
+    unsigned long long base_memory = PROCESS_BASE_MEMORY;
+    unsigned long long available;
+    unsigned long long thread_memory;
+    size_t block_size = MAX_BLOCK_SIZE;
+    int level;
+    int threads;
+
+    if (arguments->memory_budget == 0)
+    {
+        return SUCCESS;
+    }
+
+    // the names of the infiles are kept the whole time, as well as a job for each of them
+    base_memory += (sizeof(char *) + sizeof(BATCH_JOB)) * (unsigned long long) arguments->in_size;
+    for (int i = 0; i < arguments->in_count; i++)
+    {
+        base_memory += strlen(arguments->in_filenames[i]) + 1;
+    }
+    available = arguments->memory_budget > base_memory ? arguments->memory_budget - base_memory : 0;
+
+    // the daemon compresses at any level
+    level = arguments->operation_mode == COMPRESSION ? arguments->level
+            : arguments->operation_mode == DAEMON ? 9 : 0;
+
+    // an archive is packed in the main thread, otherwise as many full-sized workers as fit
+    threads = arguments->solid ? 1 : get_thread_count(arguments);
+    thread_memory = get_codec_memory(block_size, level);
+    if (arguments->operation_mode == COMPRESSION && threads > 1)
+    {
+        // parts of large files are held until they are written in order
+        thread_memory += PART_THREAD_MEMORY;
+    }
+    if (available / thread_memory < (unsigned long long) threads)
+    {
+        threads = (int) (available / thread_memory);
+    }
+
+    // a single worker may still fit with smaller blocks, but decompression needs full-sized ones
+    while (threads == 0 && arguments->operation_mode == COMPRESSION && block_size > MIN_BLOCK_SIZE)
+    {
+        block_size /= 2;
+        threads = get_codec_memory(block_size, level) <= available ? 1 : 0;
+    }
+
+    if (threads == 0)
+    {
+        fprintf(stderr, "Das Speicherbudget reicht nicht aus, benötigt werden mindestens %llu Bytes.\n",
+                base_memory + get_codec_memory(arguments->operation_mode == COMPRESSION ? MIN_BLOCK_SIZE : MAX_BLOCK_SIZE, level));
+        return ARGUMENTS_EXCEPTION;
+    }
+
+    arguments->threads = threads;
+    set_codec_memory(block_size, true);
+    if (arguments->should_view_info)
+    {
+        printf(" - Speicherbudget: %d Threads, Blockgröße %zu Bytes\n", threads, block_size);
+    }
+    return SUCCESS;
+}
+
+extern EXIT run_batch(ARGUMENTS *arguments)
+{
+    int threads = get_thread_count(arguments);
+    // only several threads gain from splitting a file, a single one keeps reusing its tables
+    bool is_split = arguments->operation_mode == COMPRESSION && threads > 1;
+    pthread_t *workers;
+    int started = 0;
+
+    batch_arguments = arguments;
+    batch_exit = SUCCESS;
+    pending_parts = 0;
+    max_pending_parts = (unsigned long long) threads;
+
+    batch_jobs = (BATCH_JOB *) calloc((size_t) arguments->in_count, sizeof(BATCH_JOB));
+    deque_count = threads > 1 ? threads : 1;
+    deques = (JOB_DEQUE *) malloc(sizeof(JOB_DEQUE) * (size_t) deque_count);
+    workers = (pthread_t *) malloc(sizeof(pthread_t) * (size_t) deque_count);
+    if (batch_jobs == NULL || deques == NULL || workers == NULL)
+    {
+        free(batch_jobs);
+        free(deques);
+        free(workers);
+        return UNKNOWN_EXCEPTION;
+    }
+
+    for (int i = 0; i < arguments->in_count; i++)
+    {
+        BATCH_JOB *job = batch_jobs + i;
+
+        job->in_filename = arguments->in_filenames[i];
+        job->part_count = is_split ? get_part_count(job->in_filename) : 1;
+        job->exit = SUCCESS;
+        pthread_mutex_init(&job->mutex, NULL);
+    }
+
+    // each worker starts on a contiguous range of the infiles
+    for (int i = 0; i < deque_count; i++)
+    {
+        deques[i].head = (int) ((long long) arguments->in_count * i / deque_count);
+        deques[i].tail = (int) ((long long) arguments->in_count * (i + 1) / deque_count);
+        pthread_mutex_init(&deques[i].mutex, NULL);
+    }
+
+    if (threads > 1)
+    {
+        if (arguments->should_view_info)
+        {
+            print_node_placement(threads);
+        }
+
+        while (started < threads && pthread_create(workers + started, NULL, work, (void *) (intptr_t) (started + 1)) == 0)
+        {
+            started++;
+        }
+    }
+
+    if (started == 0)
+    {
+        // no pool needed or threads unavailable, work in main thread and steal the other ranges
+        work(NULL);
+    }
+
+    for (int i = 0; i < started; i++)
+    {
+        pthread_join(*(workers + i), NULL);
+    }
+
+    for (int i = 0; i < deque_count; i++)
+    {
+        pthread_mutex_destroy(&deques[i].mutex);
+    }
+    for (int i = 0; i < arguments->in_count; i++)
+    {
+        pthread_mutex_destroy(&batch_jobs[i].mutex);
+    }
+    free(workers);
+    free(deques);
+    free(batch_jobs);
+
+    return batch_exit;
+}
+
+static void *work(void *worker)
+{
+    int index = worker != NULL ? (int) (intptr_t) worker - 1 : 0;
+    BATCH_JOB *job;
+    unsigned long long part;
+
+    if (worker != NULL)
+    {
+        bind_to_node(index);
+    }
+
+    while (take_part(index, &job, &part))
+    {
+        if (job->part_count == 1)
+        {
+            run_file(job);
+        }
+        else
+        {
+            run_part(job, part);
+        }
+    }
+
+    free_codec();
+    return NULL;
+}
+
+extern int get_thread_count(ARGUMENTS *arguments)
+{
+    int threads = arguments->threads;
+
+    if (threads == 0)
+    {
+        long processors = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = processors > 0 ? (int) processors : 1;
+    }
+    if (arguments->operation_mode != DAEMON && threads > arguments->in_count)
+    {
+        // large files are compressed in parts, so they keep more threads busy
+        unsigned long long task_count = (unsigned long long) arguments->in_count;
+
+        for (int i = 0; i < arguments->in_count && task_count < (unsigned long long) threads
+                        && arguments->operation_mode == COMPRESSION && !arguments->solid; i++)
+        {
+            task_count += get_part_count(arguments->in_filenames[i]) - 1;
+        }
+        if (task_count < (unsigned long long) threads)
+        {
+            threads = (int) task_count;
+        }
+    }
+    return threads;
+}
+
+static bool take_part(int worker, BATCH_JOB **job, unsigned long long *part)
+{
+    JOB_DEQUE *deque = deques + worker;
+
+    for (;;)
+    {
+        BATCH_JOB *next = NULL;
+
+        pthread_mutex_lock(&deque->mutex);
+        if (deque->head < deque->tail)
+        {
+            next = batch_jobs + deque->head;
+        }
+        pthread_mutex_unlock(&deque->mutex);
+
+        if (next == NULL)
+        {
+            next = steal_job(worker);
+            if (next == NULL)
+            {
+                return false;
+            }
+        }
+
+        if (take_from_job(next, part))
+        {
+            *job = next;
+            return true;
+        }
+
+        // all parts of the front job are taken, thieves never take it
+        pthread_mutex_lock(&deque->mutex);
+        if (deque->head < deque->tail && batch_jobs + deque->head == next)
+        {
+            deque->head++;
+        }
+        pthread_mutex_unlock(&deque->mutex);
+    }
+}
+
+static BATCH_JOB *steal_job(int worker)
+{
+    int node = get_worker_node(worker);
+
+    // the first round only visits workers on the own node, the second one all others
+    for (int round = 0; round < 2; round++)
+    {
+        for (int i = 1; i < deque_count; i++)
+        {
+            int victim = (worker + i) % deque_count;
+            BATCH_JOB *job;
+
+            if ((get_worker_node(victim) == node) != (round == 0))
+            {
+                continue;
+            }
+            job = steal_from(worker, deques + victim);
+            if (job != NULL)
+            {
+                return job;
+            }
+        }
+    }
+    return NULL;
+}
+
+static BATCH_JOB *steal_from(int worker, JOB_DEQUE *victim)
+{
+    BATCH_JOB *shared = NULL;
+    int head = 0;
+    int tail = 0;
+
+    pthread_mutex_lock(&victim->mutex);
+    if (victim->tail - victim->head >= 2)
+    {
+        // the back half of the files the victim has not begun yet
+        head = victim->head + 1 + (victim->tail - victim->head - 1) / 2;
+        tail = victim->tail;
+        victim->tail = head;
+    }
+    else if (victim->tail - victim->head == 1)
+    {
+        shared = batch_jobs + victim->head;
+    }
+    pthread_mutex_unlock(&victim->mutex);
+
+    if (head < tail)
+    {
+        // locked one after the other, so two thieves never wait for each other
+        pthread_mutex_lock(&deques[worker].mutex);
+        deques[worker].head = head;
+        deques[worker].tail = tail;
+        pthread_mutex_unlock(&deques[worker].mutex);
+        return batch_jobs + head;
+    }
+
+    // a single large file is shared part by part
+    return shared != NULL && has_parts(shared) ? shared : NULL;
+}
+
+static bool take_from_job(BATCH_JOB *job, unsigned long long *part)
+{
+    if (job->part_count > 1)
+    {
+        // finished parts are held in memory until their predecessors are written
+        pthread_mutex_lock(&batch_mutex);
+        while (pending_parts >= max_pending_parts)
+        {
+            pthread_cond_wait(&pending_cond, &batch_mutex);
+        }
+        pthread_mutex_unlock(&batch_mutex);
+    }
+
+    pthread_mutex_lock(&job->mutex);
+    if (job->exit != SUCCESS || job->next_part >= job->part_count)
+    {
+        pthread_mutex_unlock(&job->mutex);
+        return false;
+    }
+
+    if (job->part_count > 1 && job->next_part == 0)
+    {
+        // the other threads wait for the sample, all parts need it
+        job->plan = (COMPRESS_PLAN *) malloc(sizeof(COMPRESS_PLAN));
+        job->outputs = (PART_OUTPUT *) calloc((size_t) job->part_count, sizeof(PART_OUTPUT));
+        if (job->plan == NULL || job->outputs == NULL)
+        {
+            printf("Fehler bei der Speicherreservierung.");
+            exit(1);
+        }
+
+        // the infile must still be as large as when it was split
+        if (plan_compression(job->in_filename, batch_arguments->level, job->plan) != SUCCESS
+            || (job->plan->in_size + PART_SIZE - 1) / PART_SIZE != job->part_count)
+        {
+            free(job->plan);
+            job->plan = NULL;
+        }
+    }
+
+    *part = job->next_part;
+    job->next_part++;
+    pthread_mutex_unlock(&job->mutex);
+
+    return true;
+}
+
+static bool has_parts(BATCH_JOB *job)
+{
+    bool has_parts;
+
+    pthread_mutex_lock(&job->mutex);
+    has_parts = job->exit == SUCCESS && job->next_part < job->part_count;
+    pthread_mutex_unlock(&job->mutex);
+
+    return has_parts;
+}
+
+static void run_file(BATCH_JOB *job)
+{
+    char out_filename[MAX_LENGTH_FILENAME];
+    char *in_filename = job->in_filename;
+    FILE_ANALYSIS analysis;
+    EXIT exit;
+
+    get_out_filename(in_filename, out_filename);
+
+    if (batch_arguments->operation_mode == ANALYSIS)
+    {
+        exit = analyze(in_filename, batch_arguments->level, &analysis);
+    }
+    else if (batch_arguments->operation_mode == COMPRESSION)
+    {
+        exit = compress(in_filename, out_filename, batch_arguments->level);
+    }
+    else if (is_archive(in_filename))
+    {
+        exit = decompress_archive(in_filename, batch_arguments->member_name[0] != '\0'
+                                               ? batch_arguments->member_name
+                                               : NULL);
+    }
+    else
+    {
+        exit = decompress(in_filename, out_filename);
+    }
+
+    report_file(in_filename, exit, batch_arguments->operation_mode == ANALYSIS ? &analysis : NULL);
+}
+
+static void run_part(BATCH_JOB *job, unsigned long long part)
+{
+    unsigned char *data = NULL;
+    size_t size = 0;
+    EXIT exit = IO_EXCEPTION;
+    bool is_complete;
+
+    // the plan is set before the first part is taken and kept until the last one is finished
+    if (job->plan != NULL)
+    {
+        unsigned long long offset = part * PART_SIZE;
+        unsigned long long part_size = job->plan->in_size - offset < PART_SIZE ? job->plan->in_size - offset
+                                                                               : PART_SIZE;
+
+        exit = compress_part(job->in_filename, job->plan, offset, part_size, batch_arguments->level, &data, &size);
+    }
+
+    pthread_mutex_lock(&job->mutex);
+    job->finished_count++;
+    if (exit != SUCCESS && job->exit == SUCCESS)
+    {
+        job->exit = exit;
+    }
+    if (data != NULL)
+    {
+        job->outputs[part].data = data;
+        job->outputs[part].size = size;
+        add_pending_parts(1);
+        commit_parts(job);
+    }
+
+    // the last thread to leave the job closes it, after a failure without waiting for the remaining parts
+    is_complete = !job->is_committing && job->finished_count == job->next_part
+                  && (job->exit != SUCCESS || job->committed_count == job->part_count);
+    if (is_complete)
+    {
+        for (unsigned long long i = job->committed_count; i < job->next_part; i++)
+        {
+            if (job->outputs[i].data != NULL)
+            {
+                free(job->outputs[i].data);
+                add_pending_parts(-1);
+            }
+        }
+        if (job->outfile != NULL && fclose(job->outfile) != 0 && job->exit == SUCCESS)
+        {
+            job->exit = IO_EXCEPTION;
+        }
+        job->outfile = NULL;
+        free(job->outputs);
+        job->outputs = NULL;
+        free(job->plan);
+        job->plan = NULL;
+    }
+    pthread_mutex_unlock(&job->mutex);
+
+    if (is_complete)
+    {
+        report_file(job->in_filename, job->exit, NULL);
+    }
+}
+
+static void commit_parts(BATCH_JOB *job)
+{
+    if (job->is_committing)
+    {
+        return;
+    }
+
+    job->is_committing = true;
+    while (job->exit == SUCCESS && job->committed_count < job->part_count
+           && job->outputs[job->committed_count].data != NULL)
+    {
+        PART_OUTPUT output = job->outputs[job->committed_count];
+        bool is_written;
+
+        // other threads store their parts meanwhile
+        pthread_mutex_unlock(&job->mutex);
+        if (job->outfile == NULL)
+        {
+            char out_filename[MAX_LENGTH_FILENAME];
+
+            get_out_filename(job->in_filename, out_filename);
+            job->outfile = fopen(out_filename, "wb");
+        }
+        is_written = job->outfile != NULL && fwrite(output.data, 1, output.size, job->outfile) == output.size;
+        free(output.data);
+        pthread_mutex_lock(&job->mutex);
+
+        job->outputs[job->committed_count].data = NULL;
+        job->committed_count++;
+        add_pending_parts(-1);
+        if (!is_written && job->exit == SUCCESS)
+        {
+            job->exit = IO_EXCEPTION;
+        }
+    }
+    job->is_committing = false;
+}
+
+static void add_pending_parts(long long delta)
+{
+    pthread_mutex_lock(&batch_mutex);
+    pending_parts += (unsigned long long) delta;
+    if (delta < 0)
+    {
+        pthread_cond_broadcast(&pending_cond);
+    }
+    pthread_mutex_unlock(&batch_mutex);
+}
+
+static void report_file(char *in_filename, EXIT exit, FILE_ANALYSIS *analysis)
+{
+    char out_filename[MAX_LENGTH_FILENAME];
+
+    pthread_mutex_lock(&batch_mutex);
+    if (exit != SUCCESS)
+    {
+        if (batch_exit == SUCCESS)
+        {
+            batch_exit = exit;
+        }
+        if (batch_arguments->in_count > 1)
+        {
+            fprintf(stderr, "Fehler bei der Bearbeitung von %s (Exit-Code %d)\n", in_filename, exit);
+        }
+    }
+    else if (analysis != NULL)
+    {
+        // whole reports only, so those of parallel workers do not interleave
+        print_analysis(in_filename, analysis, batch_arguments->is_json);
+    }
+    else if (batch_arguments->should_view_info)
+    {
+        get_out_filename(in_filename, out_filename);
+        print_further_information(in_filename, out_filename);
+    }
+    pthread_mutex_unlock(&batch_mutex);
+}
+
+static void get_out_filename(char *in_filename, char *out_filename)
+{
+    // explicitly named outfile is only possible for exactly one infile
+    if (batch_arguments->in_count == 1)
+    {
+        strncpy(out_filename, batch_arguments->out_filename, MAX_LENGTH_FILENAME);
+    }
+    else
+    {
+        get_default_out_filename(in_filename, batch_arguments->operation_mode, out_filename);
+    }
+}
+
+static unsigned long long get_part_count(char *in_filename)
+{
+    struct stat attribut;
+
+    if (stat(in_filename, &attribut) != 0 || !S_ISREG(attribut.st_mode) || attribut.st_size <= PART_SIZE)
+    {
+        return 1;
+    }
+    return ((unsigned long long) attribut.st_size + PART_SIZE - 1) / PART_SIZE;
+}
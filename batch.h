@@ -0,0 +1,53 @@
+/**
+ * @file
+ * Dieses Modul verarbeitet alle Eingabedateien eines Aufrufs mit einem Pool
+ * von Worker-Threads. Jeder Thread arbeitet mit seinen eigenen, über die
+ * Dateien hinweg wiederverwendeten Puffern und Tabellen.
+ *
+ * Jeder Worker beginnt mit einem zusammenhängenden Bereich der Dateien in
+ * seiner Deque. Ist sie leer, stiehlt er die hintere Hälfte der noch nicht
+ * begonnenen Dateien eines anderen Workers. Hat dieser nur noch eine Datei,
+ * hilft er ihm bei deren Teilen: Beim Komprimieren mit mehreren Threads
+ * werden große Dateien in Teile zerlegt, die unabhängig voneinander in den
+ * Speicher komprimiert und in ihrer Reihenfolge in die Ausgabedatei
+ * geschrieben werden. So bleiben alle Threads beschäftigt, bis die letzte
+ * Datei fertig ist.
+ *
+ * @author  Tim Ostermann
+ * @date    2020-12-05
+ */
+
+#ifndef HUFFMAN_BATCH_H
+#define HUFFMAN_BATCH_H
+
+#include "huffman_common.h"
+#include "arguments.h"
+
+/**
+ * Wählt Blockgröße und Anzahl der Threads so, dass der Speicher des
+ * Prozesses im Budget der Eingabeparameter bleibt. Die Anzahl der Threads
+ * wird in den Eingabeparametern gesetzt. Ohne Budget ändert sich nichts.
+ * @param arguments - Eingabeparameter des Konsolenaufrufs
+ * @return ARGUMENTS_EXCEPTION, falls das Budget nicht ausreicht
+ */
+extern EXIT apply_memory_budget(ARGUMENTS *arguments);
+
+/**
+ * Bestimmt die Anzahl der Worker-Threads: die angegebene Anzahl oder die
+ * der Prozessoren, höchstens eine je Eingabedatei bzw. je Teil der
+ * Eingabedateien beim Komprimieren.
+ * @param arguments - Eingabeparameter des Konsolenaufrufs
+ * @return Anzahl der Threads
+ */
+extern int get_thread_count(ARGUMENTS *arguments);
+
+/**
+ * Komprimiert bzw. dekomprimiert alle Eingabedateien. Die Namen der
+ * Ausgabedateien werden wie bei einer einzelnen Datei bestimmt.
+ * @param arguments - Eingabeparameter des Konsolenaufrufs
+ * @return SUCCESS, falls alle Dateien erfolgreich bearbeitet wurden, sonst
+ *         der Exit-Code der ersten fehlgeschlagenen Datei
+ */
+extern EXIT run_batch(ARGUMENTS *arguments);
+
+#endif //HUFFMAN_BATCH_H
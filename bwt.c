@@ -0,0 +1,552 @@
+#include "bwt.h"
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/**
+ * Symbol für die MTF-Werte 254 und 255, gefolgt von einem Symbol 0 bzw. 1
+ */
+#define HIGH_VALUE_SYMBOL 255
+
+/**
+ * Kleinster MTF-Wert, der über HIGH_VALUE_SYMBOL geschrieben wird
+ */
+#define HIGH_VALUE 254
+
+/**
+ * Zeichen des Blocks, um 1 erhöht und gefolgt von einer 0 als Ende; beim
+ * Dekodieren je Zeile die Folgezeile und das Zeichen
+ */
+static _Thread_local int *text_buffer;
+
+/**
+ * Suffix-Array des Blocks samt Ende
+ */
+static _Thread_local int *suffix_buffer;
+
+/**
+ * Letzte Spalte der sortierten Zeilen ohne die Zeile des Endes
+ */
+static _Thread_local unsigned char *last_column;
+
+/**
+ * Speicher für die Symbole eines Blocks
+ */
+static _Thread_local unsigned char *symbol_buffer;
+
+/**
+ * Größter Block, für den der Speicher reserviert ist
+ */
+static _Thread_local size_t capacity;
+
+/**
+ * Reserviert den Speicher für einen Block, falls noch nicht geschehen.
+ * @param block_size - Anzahl der Zeichen
+ * @param is_encoding - Gibt an, ob auch das Suffix-Array nötig ist
+ */
+static void reserve_buffers(size_t block_size, bool is_encoding);
+
+/**
+ * Baut das Suffix-Array eines Textes mit SA-IS auf. Der Text endet mit
+ * einem eindeutigen kleinsten Zeichen 0.
+ * @param text - Text
+ * @param suffixes - Ziel
+ * @param length - Länge des Textes samt Ende
+ * @param alphabet_size - größtes Zeichen des Textes
+ */
+static void sort_suffixes(const int *text, int *suffixes, int length, int alphabet_size);
+
+/**
+ * Bestimmt Anfang oder Ende der Bereiche je Zeichen im Suffix-Array.
+ * @param text - Text
+ * @param length - Länge des Textes
+ * @param buckets - Ziel, alphabet_size + 1 Einträge
+ * @param alphabet_size - größtes Zeichen des Textes
+ * @param is_end - Gibt an, ob das Ende statt des Anfangs bestimmt wird
+ */
+static void get_buckets(const int *text, int length, int *buckets, int alphabet_size, bool is_end);
+
+/**
+ * Sortiert die L-Suffixe anhand der bereits einsortierten Suffixe ein.
+ * @param text - Text
+ * @param suffixes - Suffix-Array
+ * @param types - Typ je Position, gesetzt für S
+ * @param buckets - Speicher für die Bereiche
+ * @param length - Länge des Textes
+ * @param alphabet_size - größtes Zeichen des Textes
+ */
+static void induce_l_suffixes(const int *text, int *suffixes, const unsigned char *types, int *buckets,
+                              int length, int alphabet_size);
+
+/**
+ * Sortiert die S-Suffixe anhand der bereits einsortierten Suffixe ein.
+ * @param text - Text
+ * @param suffixes - Suffix-Array
+ * @param types - Typ je Position, gesetzt für S
+ * @param buckets - Speicher für die Bereiche
+ * @param length - Länge des Textes
+ * @param alphabet_size - größtes Zeichen des Textes
+ */
+static void induce_s_suffixes(const int *text, int *suffixes, const unsigned char *types, int *buckets,
+                              int length, int alphabet_size);
+
+/**
+ * Gibt an, ob das Suffix einer Position vom Typ S ist, d.h. kleiner als
+ * das folgende.
+ * @param types - Typ je Position
+ * @param position - Position
+ * @return Wahrheitswert
+ */
+static inline bool is_s_type(const unsigned char *types, int position);
+
+/**
+ * Gibt an, ob eine Position ein S-Suffix ganz links in einer Folge von
+ * S-Suffixen ist (LMS).
+ * @param types - Typ je Position
+ * @param position - Position
+ * @return Wahrheitswert
+ */
+static inline bool is_lms(const unsigned char *types, int position);
+
+/**
+ * Schreibt die Länge eines Laufs von Nullen bijektiv zur Basis 2.
+ * @param run_length - Länge größer 0
+ * @param symbols - Ziel
+ * @param symbol_count - Anzahl der geschriebenen Symbole, wird erhöht
+ * @param max_count - größte Anzahl Symbole
+ * @return Wahrheitswert, ob die Symbole in den Speicher passen
+ */
+static bool write_run(size_t run_length, unsigned char *symbols, size_t *symbol_count, size_t max_count);
+
+extern bool bwt_encode(const unsigned char *block, size_t block_size, unsigned char **symbols,
+                       size_t *symbol_count, size_t *primary_index)
+{
+    unsigned char order[NUM_OF_SYMBOLS];
+    size_t run_length = 0;
+    size_t count = 0;
+
+    reserve_buffers(block_size, true);
+    *symbols = symbol_buffer;
+
+    // sort the suffixes of the block followed by an end smaller than every char
+    for (size_t i = 0; i < block_size; i++)
+    {
+        text_buffer[i] = block[i] + 1;
+    }
+    text_buffer[block_size] = 0;
+    sort_suffixes(text_buffer, suffix_buffer, (int) block_size + 1, NUM_OF_SYMBOLS);
+
+    // the char before each suffix forms the last column, the row of the whole block has the end there
+    for (size_t i = 0, j = 0; i <= block_size; i++)
+    {
+        if (suffix_buffer[i] == 0)
+        {
+            *primary_index = i;
+        }
+        else
+        {
+            last_column[j++] = block[suffix_buffer[i] - 1];
+        }
+    }
+
+    // move to front, runs of zeros are counted
+    for (int i = 0; i < NUM_OF_SYMBOLS; i++)
+    {
+        order[i] = (unsigned char) i;
+    }
+    for (size_t i = 0; i < block_size; i++)
+    {
+        unsigned char character = last_column[i];
+        unsigned int value = 0;
+
+        while (order[value] != character)
+        {
+            value++;
+        }
+        if (value == 0)
+        {
+            run_length++;
+            continue;
+        }
+        if (run_length > 0 && !write_run(run_length, symbol_buffer, &count, block_size))
+        {
+            return false;
+        }
+        run_length = 0;
+        memmove(order + 1, order, value);
+        order[0] = character;
+
+        if (count + (value >= HIGH_VALUE) >= block_size)
+        {
+            return false;
+        }
+        if (value < HIGH_VALUE)
+        {
+            symbol_buffer[count++] = (unsigned char) (value + 1);
+        }
+        else
+        {
+            symbol_buffer[count++] = HIGH_VALUE_SYMBOL;
+            symbol_buffer[count++] = (unsigned char) (value - HIGH_VALUE);
+        }
+    }
+    if (run_length > 0 && !write_run(run_length, symbol_buffer, &count, block_size))
+    {
+        return false;
+    }
+
+    *symbol_count = count;
+    return true;
+}
+
+extern unsigned char *bwt_get_symbol_buffer(size_t block_size)
+{
+    reserve_buffers(block_size, false);
+    return symbol_buffer;
+}
+
+extern EXIT bwt_decode(const unsigned char *symbols, size_t symbol_count, size_t primary_index,
+                       unsigned char *destination, size_t block_size)
+{
+    unsigned char order[NUM_OF_SYMBOLS];
+    int starts[NUM_OF_SYMBOLS] = {0};
+    size_t position = 0;
+    size_t run_length = 0;
+    size_t run_weight = 1;
+    size_t row = 0;
+
+    reserve_buffers(block_size, false);
+    if (primary_index == 0 || primary_index > block_size)
+    {
+        return COMPRESSION_EXCEPTION;
+    }
+
+    // undo the zero runs and the move to front
+    for (int i = 0; i < NUM_OF_SYMBOLS; i++)
+    {
+        order[i] = (unsigned char) i;
+    }
+    for (size_t i = 0; i <= symbol_count; i++)
+    {
+        unsigned int value;
+        unsigned char character;
+
+        if (i < symbol_count && symbols[i] <= BWT_RUN_B)
+        {
+            // a digit of the run length, weights grow by powers of 2
+            if (run_weight > block_size)
+            {
+                return COMPRESSION_EXCEPTION;
+            }
+            run_length += run_weight << symbols[i];
+            run_weight <<= 1;
+            continue;
+        }
+        if (run_length > block_size - position)
+        {
+            return COMPRESSION_EXCEPTION;
+        }
+        memset(last_column + position, order[0], run_length);
+        position += run_length;
+        run_length = 0;
+        run_weight = 1;
+        if (i == symbol_count)
+        {
+            break;
+        }
+
+        value = symbols[i] - 1u;
+        if (symbols[i] == HIGH_VALUE_SYMBOL)
+        {
+            if (++i == symbol_count || symbols[i] > 1)
+            {
+                return COMPRESSION_EXCEPTION;
+            }
+            value = HIGH_VALUE + symbols[i];
+        }
+        if (position == block_size)
+        {
+            return COMPRESSION_EXCEPTION;
+        }
+        character = order[value];
+        memmove(order + 1, order, value);
+        order[0] = character;
+        last_column[position++] = character;
+    }
+    if (position != block_size)
+    {
+        return COMPRESSION_EXCEPTION;
+    }
+
+    // each row is followed by the row of its suffix without the last char, stored with that char
+    for (size_t i = 0; i < block_size; i++)
+    {
+        starts[last_column[i]]++;
+    }
+    for (int i = 0, sum = 1; i < NUM_OF_SYMBOLS; i++)
+    {
+        int count = starts[i];
+        starts[i] = sum;
+        sum += count;
+    }
+    text_buffer[primary_index] = 0;
+    for (size_t i = 0; i <= block_size; i++)
+    {
+        if (i != primary_index)
+        {
+            unsigned char character = last_column[i < primary_index ? i : i - 1];
+            text_buffer[i] = starts[character]++ << 8 | character;
+        }
+    }
+
+    // walk backwards from the row of the end, which has to be reached last
+    for (size_t i = block_size; i > 0; i--)
+    {
+        int entry = text_buffer[row];
+        destination[i - 1] = (unsigned char) entry;
+        row = (size_t) (entry >> 8);
+    }
+    return row == primary_index ? SUCCESS : COMPRESSION_EXCEPTION;
+}
+
+extern unsigned long long bwt_get_memory(size_t block_size, bool is_encoding)
+{
+    unsigned long long memory = sizeof(int) * ((unsigned long long) block_size + 1) + 2ull * block_size;
+
+    if (is_encoding)
+    {
+        // the suffix array and the types of all recursion levels
+        memory += sizeof(int) * ((unsigned long long) block_size + 1) + block_size / 4 + NUM_OF_SYMBOLS * sizeof(int);
+    }
+    return memory;
+}
+
+extern void bwt_free(void)
+{
+    free(text_buffer);
+    text_buffer = NULL;
+    free(suffix_buffer);
+    suffix_buffer = NULL;
+    free(last_column);
+    last_column = NULL;
+    free(symbol_buffer);
+    symbol_buffer = NULL;
+    capacity = 0;
+}
+
+static void reserve_buffers(size_t block_size, bool is_encoding)
+{
+    if (block_size > capacity)
+    {
+        // a larger block needs new buffers for everything
+        bwt_free();
+        text_buffer = (int *) malloc(sizeof(int) * (block_size + 1));
+        last_column = (unsigned char *) malloc(block_size);
+        symbol_buffer = (unsigned char *) malloc(block_size);
+        capacity = block_size;
+    }
+    if (is_encoding && suffix_buffer == NULL)
+    {
+        suffix_buffer = (int *) malloc(sizeof(int) * (capacity + 1));
+    }
+    if (text_buffer == NULL || last_column == NULL || symbol_buffer == NULL || (is_encoding && suffix_buffer == NULL))
+    {
+        printf("Fehler bei der Speicherreservierung.");
+        exit(1);
+    }
+}
+
+static void sort_suffixes(const int *text, int *suffixes, int length, int alphabet_size)
+{
+    unsigned char *types = (unsigned char *) calloc((size_t) length / 8 + 1, 1);
+    int *buckets = (int *) malloc(sizeof(int) * ((size_t) alphabet_size + 1));
+    int *reduced_text;
+    int reduced_length = 0;
+    int name_count = 0;
+    int previous = -1;
+
+    if (types == NULL || buckets == NULL)
+    {
+        printf("Fehler bei der Speicherreservierung.");
+        exit(1);
+    }
+
+    // the end is S, the char before it L, every other type follows from the next char
+    types[(length - 1) / 8] |= (unsigned char) (1 << (length - 1) % 8);
+    for (int i = length - 3; i >= 0; i--)
+    {
+        if (text[i] < text[i + 1] || (text[i] == text[i + 1] && is_s_type(types, i + 1)))
+        {
+            types[i / 8] |= (unsigned char) (1 << i % 8);
+        }
+    }
+
+    // sort the lms substrings by inducing from their unsorted positions at the bucket ends
+    get_buckets(text, length, buckets, alphabet_size, true);
+    memset(suffixes, -1, sizeof(int) * (size_t) length);
+    for (int i = 1; i < length; i++)
+    {
+        if (is_lms(types, i))
+        {
+            suffixes[--buckets[text[i]]] = i;
+        }
+    }
+    induce_l_suffixes(text, suffixes, types, buckets, length, alphabet_size);
+    induce_s_suffixes(text, suffixes, types, buckets, length, alphabet_size);
+
+    // name the sorted lms substrings, equal ones get the same name
+    for (int i = 0; i < length; i++)
+    {
+        if (is_lms(types, suffixes[i]))
+        {
+            suffixes[reduced_length++] = suffixes[i];
+        }
+    }
+    memset(suffixes + reduced_length, -1, sizeof(int) * (size_t) (length - reduced_length));
+    for (int i = 0; i < reduced_length; i++)
+    {
+        int position = suffixes[i];
+        bool is_different = false;
+
+        for (int j = 0; j < length; j++)
+        {
+            if (previous == -1 || text[position + j] != text[previous + j]
+                || is_s_type(types, position + j) != is_s_type(types, previous + j))
+            {
+                is_different = true;
+                break;
+            }
+            if (j > 0 && (is_lms(types, position + j) || is_lms(types, previous + j)))
+            {
+                break;
+            }
+        }
+        if (is_different)
+        {
+            name_count++;
+            previous = position;
+        }
+        // lms positions are at least 2 apart, so half of them fit behind the sorted ones
+        suffixes[reduced_length + position / 2] = name_count - 1;
+    }
+    for (int i = length - 1, j = length - 1; i >= reduced_length; i--)
+    {
+        if (suffixes[i] >= 0)
+        {
+            suffixes[j--] = suffixes[i];
+        }
+    }
+
+    // sort the suffixes of the names, recursively unless all names differ
+    reduced_text = suffixes + length - reduced_length;
+    if (name_count < reduced_length)
+    {
+        sort_suffixes(reduced_text, suffixes, reduced_length, name_count - 1);
+    }
+    else
+    {
+        for (int i = 0; i < reduced_length; i++)
+        {
+            suffixes[reduced_text[i]] = i;
+        }
+    }
+
+    // put the sorted lms suffixes at their bucket ends and induce all others from them
+    for (int i = 1, j = 0; i < length; i++)
+    {
+        if (is_lms(types, i))
+        {
+            reduced_text[j++] = i;
+        }
+    }
+    for (int i = 0; i < reduced_length; i++)
+    {
+        suffixes[i] = reduced_text[suffixes[i]];
+    }
+    memset(suffixes + reduced_length, -1, sizeof(int) * (size_t) (length - reduced_length));
+    get_buckets(text, length, buckets, alphabet_size, true);
+    for (int i = reduced_length - 1; i >= 0; i--)
+    {
+        int position = suffixes[i];
+        suffixes[i] = -1;
+        suffixes[--buckets[text[position]]] = position;
+    }
+    induce_l_suffixes(text, suffixes, types, buckets, length, alphabet_size);
+    induce_s_suffixes(text, suffixes, types, buckets, length, alphabet_size);
+
+    free(buckets);
+    free(types);
+}
+
+static void get_buckets(const int *text, int length, int *buckets, int alphabet_size, bool is_end)
+{
+    int sum = 0;
+
+    memset(buckets, 0, sizeof(int) * ((size_t) alphabet_size + 1));
+    for (int i = 0; i < length; i++)
+    {
+        buckets[text[i]]++;
+    }
+    for (int i = 0; i <= alphabet_size; i++)
+    {
+        sum += buckets[i];
+        buckets[i] = is_end ? sum : sum - buckets[i];
+    }
+}
+
+static void induce_l_suffixes(const int *text, int *suffixes, const unsigned char *types, int *buckets,
+                              int length, int alphabet_size)
+{
+    get_buckets(text, length, buckets, alphabet_size, false);
+    for (int i = 0; i < length; i++)
+    {
+        int position = suffixes[i] - 1;
+        if (position >= 0 && !is_s_type(types, position))
+        {
+            suffixes[buckets[text[position]]++] = position;
+        }
+    }
+}
+
+static void induce_s_suffixes(const int *text, int *suffixes, const unsigned char *types, int *buckets,
+                              int length, int alphabet_size)
+{
+    get_buckets(text, length, buckets, alphabet_size, true);
+    for (int i = length - 1; i >= 0; i--)
+    {
+        int position = suffixes[i] - 1;
+        if (position >= 0 && is_s_type(types, position))
+        {
+            suffixes[--buckets[text[position]]] = position;
+        }
+    }
+}
+
+static inline bool is_s_type(const unsigned char *types, int position)
+{
+    return (types[position / 8] >> position % 8 & 1) != 0;
+}
+
+static inline bool is_lms(const unsigned char *types, int position)
+{
+    return position > 0 && is_s_type(types, position) && !is_s_type(types, position - 1);
+}
+
+static bool write_run(size_t run_length, unsigned char *symbols, size_t *symbol_count, size_t max_count)
+{
+    // bijective base 2: digit 1 is RUN_A, digit 2 is RUN_B, least significant first
+    run_length--;
+    while (true)
+    {
+        if (*symbol_count == max_count)
+        {
+            return false;
+        }
+        symbols[(*symbol_count)++] = run_length & 1 ? BWT_RUN_B : BWT_RUN_A;
+        if (run_length < 2)
+        {
+            return true;
+        }
+        run_length = (run_length - 2) / 2;
+    }
+}
@@ -0,0 +1,80 @@
+/**
+ * @file
+ * Dieses Modul implementiert eine Burrows-Wheeler-Transformation (BWT) mit
+ * anschließender Move-to-front-Kodierung (MTF) und Lauflängenkodierung der
+ * Nullen, wie sie bzip2 verwendet. Die Transformation sortiert die Zeichen
+ * eines Blocks nach ihrem Folgetext, sodass gleiche Zeichen gehäuft
+ * auftreten; MTF macht daraus überwiegend kleine Werte und Nullen.
+ *
+ * Das Suffix-Array wird mit SA-IS in linearer Zeit aufgebaut. Läufe von
+ * Nullen werden bijektiv zur Basis 2 über die Symbole BWT_RUN_A und
+ * BWT_RUN_B geschrieben, ein MTF-Wert v als v + 1. Das Symbol 255 steht für
+ * die Werte 254 und 255 und wird von einem Symbol 0 bzw. 1 gefolgt.
+ *
+ * @author  Tim Ostermann
+ * @date    2020-12-05
+ */
+
+#ifndef HUFFMAN_BWT_H
+#define HUFFMAN_BWT_H
+
+#include "huffman_common.h"
+#include <stddef.h>
+
+/**
+ * Symbol für eine Eins der Länge eines Laufs von Nullen
+ */
+#define BWT_RUN_A 0
+
+/**
+ * Symbol für eine Zwei der Länge eines Laufs von Nullen
+ */
+#define BWT_RUN_B 1
+
+/**
+ * Transformiert einen Block in Symbole. Es werden höchstens so viele
+ * Symbole geschrieben, wie der Block Zeichen hat.
+ * @param block - Anfang des Blocks
+ * @param block_size - Anzahl der Zeichen, höchstens MAX_BLOCK_SIZE
+ * @param symbols - Übergabeparameter für die Symbole, der Speicher gehört dem Thread
+ * @param symbol_count - Übergabeparameter für die Anzahl der Symbole
+ * @param primary_index - Übergabeparameter für die Zeile des ursprünglichen Blocks
+ * @return Wahrheitswert, ob die Symbole in den Speicher passen
+ */
+extern bool bwt_encode(const unsigned char *block, size_t block_size, unsigned char **symbols,
+                       size_t *symbol_count, size_t *primary_index);
+
+/**
+ * Liefert einen Speicherbereich des Threads für die Symbole eines Blocks.
+ * @param block_size - Anzahl der Zeichen, höchstens MAX_BLOCK_SIZE
+ * @return Speicherbereich für block_size Symbole
+ */
+extern unsigned char *bwt_get_symbol_buffer(size_t block_size);
+
+/**
+ * Setzt einen Block aus seinen Symbolen zusammen.
+ * @param symbols - Symbole
+ * @param symbol_count - Anzahl der Symbole
+ * @param primary_index - Zeile des ursprünglichen Blocks
+ * @param destination - Ziel
+ * @param block_size - Anzahl der Zeichen des Blocks
+ * @return COMPRESSION_EXCEPTION, falls die Symbole nicht zum Block passen
+ */
+extern EXIT bwt_decode(const unsigned char *symbols, size_t symbol_count, size_t primary_index,
+                       unsigned char *destination, size_t block_size);
+
+/**
+ * Liefert den Speicher, den ein Thread für die Transformation höchstens
+ * belegt.
+ * @param block_size - Größe des Blockspeichers
+ * @param is_encoding - Gibt an, ob auch Blöcke transformiert werden
+ * @return Anzahl Bytes
+ */
+extern unsigned long long bwt_get_memory(size_t block_size, bool is_encoding);
+
+/**
+ * Gibt den Speicher der Transformation im aufrufenden Thread frei.
+ */
+extern void bwt_free(void);
+
+#endif //HUFFMAN_BWT_H
@@ -0,0 +1,111 @@
+#include "checksum.h"
+#include <pthread.h>
+
+/**
+ * Generatorpolynom (bitweise gespiegelt)
+ */
+#define POLYNOMIAL 0xEDB88320u
+
+/**
+ * Tabelle der Prüfsummen aller Bytewerte
+ */
+static unsigned int crc_table[256];
+
+/**
+ * Reste von x^(2^k) modulo Generatorpolynom, gespiegelt wie die Prüfsummen
+ */
+static unsigned int power_table[32];
+
+/**
+ * Sorgt dafür, dass die Tabelle genau einmal berechnet wird
+ */
+static pthread_once_t crc_table_once = PTHREAD_ONCE_INIT;
+
+/**
+ * Berechnet die Tabelle der Prüfsummen aller Bytewerte und die der Potenzen.
+ */
+static void init_crc_table(void);
+
+/**
+ * Multipliziert zwei Polynome modulo Generatorpolynom.
+ * @param a - erster Faktor, gespiegelt
+ * @param b - zweiter Faktor, gespiegelt
+ * @return Produkt, gespiegelt
+ */
+static unsigned int multiply_polynomials(unsigned int a, unsigned int b);
+
+extern unsigned int checksum_update_char(unsigned int crc, unsigned char c)
+{
+    pthread_once(&crc_table_once, init_crc_table);
+    return crc_table[(crc ^ c) & 0xFF] ^ (crc >> 8);
+}
+
+extern unsigned int checksum_update(unsigned int crc, const unsigned char *data, size_t length)
+{
+    pthread_once(&crc_table_once, init_crc_table);
+    for (size_t i = 0; i < length; i++)
+    {
+        crc = crc_table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return crc;
+}
+
+extern unsigned int checksum_combine(unsigned int crc, unsigned int part_crc, unsigned long long part_length)
+{
+    // x^0 in the mirrored representation
+    unsigned int shift = 1u << 31;
+
+    pthread_once(&crc_table_once, init_crc_table);
+
+    // the crc is linear: skip the part's 8 * part_length bits with x^(8 * part_length),
+    // the part's own initial value is already in its crc
+    for (unsigned int k = 3; part_length > 0; part_length >>= 1, k++)
+    {
+        if (part_length & 1)
+        {
+            shift = multiply_polynomials(power_table[k & 31], shift);
+        }
+    }
+    return multiply_polynomials(shift, crc ^ CHECKSUM_INIT) ^ part_crc;
+}
+
+extern unsigned int checksum_final(unsigned int crc)
+{
+    return crc ^ 0xFFFFFFFFu;
+}
+
+static void init_crc_table(void)
+{
+    for (unsigned int i = 0; i < 256; i++)
+    {
+        unsigned int crc = i;
+        for (int bit = 0; bit < 8; bit++)
+        {
+            crc = (crc & 1) ? (crc >> 1) ^ POLYNOMIAL : crc >> 1;
+        }
+        crc_table[i] = crc;
+    }
+
+    // x^1, then square repeatedly
+    power_table[0] = 1u << 30;
+    for (int k = 1; k < 32; k++)
+    {
+        power_table[k] = multiply_polynomials(power_table[k - 1], power_table[k - 1]);
+    }
+}
+
+static unsigned int multiply_polynomials(unsigned int a, unsigned int b)
+{
+    unsigned int product = 0;
+
+    // the highest bit stands for x^0, every step multiplies b by x
+    for (unsigned int mask = 1u << 31; mask != 0; mask >>= 1)
+    {
+        if (a & mask)
+        {
+            product ^= b;
+        }
+        b = (b & 1) ? (b >> 1) ^ POLYNOMIAL : b >> 1;
+    }
+    return product;
+}
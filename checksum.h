@@ -0,0 +1,55 @@
+/**
+ * @file
+ * Dieses Modul stellt die Berechnung von CRC-32-Prüfsummen (IEEE 802.3)
+ * zur Verfügung.
+ *
+ * @author  Tim Ostermann
+ * @date    2020-12-05
+ */
+
+#ifndef HUFFMAN_CHECKSUM_H
+#define HUFFMAN_CHECKSUM_H
+
+#include <stddef.h>
+
+/**
+ * Startwert einer Prüfsumme
+ */
+#define CHECKSUM_INIT 0xFFFFFFFFu
+
+/**
+ * Aktualisiert eine Prüfsumme um ein Zeichen.
+ * @param crc - bisherige Prüfsumme
+ * @param c - hinzuzufügendes Zeichen
+ * @return aktualisierte Prüfsumme
+ */
+extern unsigned int checksum_update_char(unsigned int crc, unsigned char c);
+
+/**
+ * Aktualisiert eine Prüfsumme um einen Speicherbereich.
+ * @param crc - bisherige Prüfsumme
+ * @param data - Anfang des Speicherbereichs
+ * @param length - Länge des Speicherbereichs in Bytes
+ * @return aktualisierte Prüfsumme
+ */
+extern unsigned int checksum_update(unsigned int crc, const unsigned char *data, size_t length);
+
+/**
+ * Setzt eine Prüfsumme um einen Speicherbereich fort, dessen Prüfsumme
+ * getrennt ab CHECKSUM_INIT berechnet wurde. So können Teile einer Datei
+ * unabhängig voneinander geprüft werden.
+ * @param crc - bisherige Prüfsumme
+ * @param part_crc - nicht abgeschlossene Prüfsumme des Speicherbereichs
+ * @param part_length - Länge des Speicherbereichs in Bytes
+ * @return aktualisierte Prüfsumme
+ */
+extern unsigned int checksum_combine(unsigned int crc, unsigned int part_crc, unsigned long long part_length);
+
+/**
+ * Schließt die Berechnung einer Prüfsumme ab.
+ * @param crc - bisherige Prüfsumme
+ * @return endgültige Prüfsumme
+ */
+extern unsigned int checksum_final(unsigned int crc);
+
+#endif //HUFFMAN_CHECKSUM_H
@@ -0,0 +1,652 @@
+// memfd_create
+#define _GNU_SOURCE
+
+#include "daemon.h"
+#include "batch.h"
+#include "huffman.h"
+#include "node.h"
+#include <errno.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/sendfile.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+/**
+ * Maximale Länge einer Anfrage einschließlich Zeilenende
+ */
+#define MAX_LENGTH_REQUEST (2 * MAX_LENGTH_FILENAME + 32)
+
+/**
+ * Maximale Anzahl übergebener, noch nicht verwendeter Dateideskriptoren
+ * einer Verbindung
+ */
+#define MAX_PASSED_FDS 16
+
+/**
+ * Anzahl der Verbindungen, die auf ihre Annahme warten können
+ */
+#define DAEMON_BACKLOG 64
+
+/**
+ * Größe des Puffers, über den Nutzdaten einer Anfrage empfangen werden
+ */
+#define TRANSFER_SIZE 65536
+
+/**
+ * Wartezeit in Millisekunden, bevor ein Worker nach einem Fehler beim
+ * Annehmen einer Verbindung, etwa ohne freie Dateideskriptoren, erneut
+ * annimmt
+ */
+#define ACCEPT_RETRY_DELAY 100
+
+/**
+ * Zustand einer Verbindung
+ */
+typedef struct
+{
+    /**
+     * Socket der Verbindung
+     */
+    int socket;
+
+    /**
+     * Empfangene, noch nicht verarbeitete Bytes
+     */
+    char buffer[MAX_LENGTH_REQUEST];
+
+    /**
+     * Position des ersten nicht verarbeiteten Bytes
+     */
+    size_t position;
+
+    /**
+     * Füllstand des Puffers
+     */
+    size_t filling_level;
+
+    /**
+     * Übergebene Dateideskriptoren in Reihenfolge ihres Empfangs
+     */
+    int fds[MAX_PASSED_FDS];
+
+    /**
+     * Anzahl der übergebenen Dateideskriptoren
+     */
+    int fd_count;
+} CONNECTION;
+
+/**
+ * Socket, an dem der Dienst Verbindungen annimmt
+ */
+static int listen_socket = -1;
+
+/**
+ * Eingabeparameter des laufenden Aufrufs
+ */
+static ARGUMENTS *daemon_arguments;
+
+/**
+ * Schützt die Bildschirmausgabe
+ */
+static pthread_mutex_t daemon_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ * Arbeitsfunktion eines Worker-Threads: nimmt Verbindungen an und bearbeitet
+ * deren Anfragen. Die Puffer und Tabellen des Codecs legt der Worker nach
+ * dem Binden an seinen NUMA-Knoten selbst an, sie bleiben dabei erhalten.
+ * @param worker - Nummer des Worker-Threads ab 0
+ * @return NULL
+ */
+static void *serve(void *worker);
+
+/**
+ * Bearbeitet alle Anfragen einer Verbindung, bis der Client sie schließt
+ * oder sich nicht an das Protokoll hält.
+ * @param connection - Verbindung
+ */
+static void serve_connection(CONNECTION *connection);
+
+/**
+ * Bearbeitet eine Anfrage und sendet die Antwort.
+ * @param connection - Verbindung
+ * @param request - Anfrage ohne Zeilenende
+ * @return IO_EXCEPTION, falls die Verbindung nicht weiter verwendet werden kann
+ */
+static EXIT process_request(CONNECTION *connection, char *request);
+
+/**
+ * Bearbeitet eine Anfrage mit Nutzdaten: empfängt diese in eine anonyme
+ * Datei, (de-)komprimiert sie in eine weitere und sendet das Ergebnis.
+ * @param connection - Verbindung
+ * @param level - Komprimierungslevel, 0 für Dekomprimierung
+ * @param size - Anzahl der Bytes der Nutzdaten
+ * @return IO_EXCEPTION, falls die Verbindung nicht weiter verwendet werden kann
+ */
+static EXIT process_inline_request(CONNECTION *connection, int level, unsigned long long size);
+
+/**
+ * Empfängt weitere Bytes und übergebene Dateideskriptoren.
+ * @param connection - Verbindung
+ * @return IO_EXCEPTION, falls die Verbindung geschlossen wurde
+ */
+static EXIT receive(CONNECTION *connection);
+
+/**
+ * Empfängt die nächste Anfrage.
+ * @param connection - Verbindung
+ * @param request - Ziel, MAX_LENGTH_REQUEST Bytes groß
+ * @return IO_EXCEPTION, falls keine vollständige Anfrage folgt
+ */
+static EXIT receive_request(CONNECTION *connection, char *request);
+
+/**
+ * Empfängt Nutzdaten und schreibt sie in eine Datei.
+ * @param connection - Verbindung
+ * @param fd - Dateideskriptor der Datei
+ * @param size - Anzahl der Bytes
+ * @return IO_EXCEPTION, falls die Nutzdaten nicht vollständig empfangen
+ *         wurden, UNKNOWN_EXCEPTION, falls sie empfangen, aber nicht
+ *         vollständig in die Datei geschrieben wurden
+ */
+static EXIT receive_payload(CONNECTION *connection, int fd, unsigned long long size);
+
+/**
+ * Sendet eine Antwortzeile.
+ * @param connection - Verbindung
+ * @param exit - Exit-Code der Anfrage
+ * @param size - Größe des folgenden Ergebnisses, -1 für Anfragen ohne Ergebnis
+ * @return IO_EXCEPTION, falls nicht gesendet werden konnte
+ */
+static EXIT send_response(CONNECTION *connection, EXIT exit, long long size);
+
+/**
+ * Bestimmt den Dateinamen eines Feldes der Anfrage. "-" steht für den
+ * nächsten übergebenen Dateideskriptor, der über /proc/self/fd geöffnet wird.
+ * @param connection - Verbindung
+ * @param field - Feld der Anfrage
+ * @param filename - Ziel, MAX_LENGTH_FILENAME Bytes groß
+ * @param fd - Ziel für den verwendeten Dateideskriptor, -1 falls keiner
+ * @return ARGUMENTS_EXCEPTION, falls kein Dateideskriptor übergeben wurde
+ */
+static EXIT get_request_filename(CONNECTION *connection, char *field, char *filename, int *fd);
+
+/**
+ * Liest einen Komprimierungslevel aus einem Feld der Anfrage.
+ * @param field - Feld der Anfrage oder NULL
+ * @return Level, 0 falls ungültig
+ */
+static int parse_level(char *field);
+
+extern EXIT run_daemon(ARGUMENTS *arguments)
+{
+    struct sockaddr_un address = {.sun_family = AF_UNIX};
+    struct stat attribut;
+    sigset_t signals;
+    pthread_t *workers;
+    int threads = get_thread_count(arguments);
+    int started = 0;
+    int signal_number;
+
+    if (strlen(arguments->socket_filename) >= sizeof(address.sun_path))
+    {
+        return ARGUMENTS_EXCEPTION;
+    }
+    strcpy(address.sun_path, arguments->socket_filename);
+
+    // replace a socket left behind by an earlier daemon, but never another file
+    if (lstat(address.sun_path, &attribut) == 0)
+    {
+        if (!S_ISSOCK(attribut.st_mode) || unlink(address.sun_path) != 0)
+        {
+            return IO_EXCEPTION;
+        }
+    }
+
+    listen_socket = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (listen_socket == -1)
+    {
+        return IO_EXCEPTION;
+    }
+    // requests may name any file the daemon can access, so only its owner may connect
+    if (bind(listen_socket, (struct sockaddr *) &address, sizeof(address)) != 0
+        || chmod(address.sun_path, 0600) != 0
+        || listen(listen_socket, DAEMON_BACKLOG) != 0)
+    {
+        close(listen_socket);
+        unlink(address.sun_path);
+        return IO_EXCEPTION;
+    }
+
+    // the workers inherit the mask, so only the main thread receives termination signals
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &signals, NULL);
+    // a client closing its connection early must not terminate the daemon
+    signal(SIGPIPE, SIG_IGN);
+
+    daemon_arguments = arguments;
+    workers = (pthread_t *) malloc(sizeof(pthread_t) * (size_t) threads);
+    if (workers == NULL)
+    {
+        printf("Fehler bei der Speicherreservierung.");
+        exit(1);
+    }
+    while (started < threads && pthread_create(workers + started, NULL, serve, (void *) (intptr_t) started) == 0)
+    {
+        pthread_detach(workers[started]);
+        started++;
+    }
+    free(workers);
+
+    if (started == 0)
+    {
+        close(listen_socket);
+        unlink(address.sun_path);
+        return UNKNOWN_EXCEPTION;
+    }
+
+    if (arguments->should_view_info)
+    {
+        pthread_mutex_lock(&daemon_mutex);
+        printf(" - Dienst wartet an %s mit %d Threads\n", address.sun_path, started);
+        print_node_placement(started);
+        fflush(stdout);
+        pthread_mutex_unlock(&daemon_mutex);
+    }
+
+    // requests in progress are cut off when the process ends
+    sigwait(&signals, &signal_number);
+    unlink(address.sun_path);
+    return SUCCESS;
+}
+
+static void *serve(void *worker)
+{
+    CONNECTION connection;
+
+    // buffers and tables of the worker are created on its node with the first request
+    bind_to_node((int) (intptr_t) worker);
+
+    for (;;)
+    {
+        connection.socket = accept4(listen_socket, NULL, NULL, SOCK_CLOEXEC);
+        if (connection.socket == -1)
+        {
+            struct timespec delay = {0, ACCEPT_RETRY_DELAY * 1000000L};
+
+            // a connection gone before its acceptance is retried at once, anything else
+            // like a lack of descriptors would last and must not keep the worker spinning
+            if (errno != EINTR && errno != ECONNABORTED)
+            {
+                if (daemon_arguments->should_view_info)
+                {
+                    pthread_mutex_lock(&daemon_mutex);
+                    printf(" - Verbindung nicht angenommen: %s\n", strerror(errno));
+                    fflush(stdout);
+                    pthread_mutex_unlock(&daemon_mutex);
+                }
+                nanosleep(&delay, NULL);
+            }
+            continue;
+        }
+
+        connection.position = 0;
+        connection.filling_level = 0;
+        connection.fd_count = 0;
+        serve_connection(&connection);
+
+        for (int i = 0; i < connection.fd_count; i++)
+        {
+            close(connection.fds[i]);
+        }
+        close(connection.socket);
+    }
+
+    return NULL;
+}
+
+static void serve_connection(CONNECTION *connection)
+{
+    char request[MAX_LENGTH_REQUEST];
+
+    while (receive_request(connection, request) == SUCCESS
+           && process_request(connection, request) == SUCCESS)
+    {
+    }
+}
+
+static EXIT process_request(CONNECTION *connection, char *request)
+{
+    char *fields[5];
+    char *rest = NULL;
+    char in_filename[MAX_LENGTH_FILENAME];
+    char out_filename[MAX_LENGTH_FILENAME];
+    int in_fd = -1;
+    int out_fd = -1;
+    int field_count = 0;
+    int level = 0;
+    EXIT exit = SUCCESS;
+
+    for (char *field = strtok_r(request, " ", &rest); field != NULL && field_count < 5;
+         field = strtok_r(NULL, " ", &rest))
+    {
+        fields[field_count++] = field;
+    }
+
+    if (field_count == 0 || strlen(fields[0]) != 1)
+    {
+        // out of sync with the client, payloads would be read as requests
+        send_response(connection, ARGUMENTS_EXCEPTION, -1);
+        return IO_EXCEPTION;
+    }
+
+    // inline requests, the payload follows the request
+    if (fields[0][0] == 'C' || fields[0][0] == 'D')
+    {
+        char *end = NULL;
+        char *size_field = fields[0][0] == 'C' ? (field_count == 3 ? fields[2] : NULL)
+                                               : (field_count == 2 ? fields[1] : NULL);
+        unsigned long long size = 0;
+
+        if (size_field != NULL && size_field[0] >= '0' && size_field[0] <= '9')
+        {
+            size = strtoull(size_field, &end, 10);
+        }
+        if (end == NULL || *end != '\0')
+        {
+            send_response(connection, ARGUMENTS_EXCEPTION, -1);
+            return IO_EXCEPTION;
+        }
+
+        level = fields[0][0] == 'C' ? parse_level(fields[1]) : 0;
+        if (fields[0][0] == 'C' && level == 0)
+        {
+            // the payload has to be read anyway to stay in sync
+            exit = receive_payload(connection, -1, size);
+            return exit == SUCCESS ? send_response(connection, ARGUMENTS_EXCEPTION, 0) : exit;
+        }
+        return process_inline_request(connection, level, size);
+    }
+
+    // requests naming files
+    if (fields[0][0] == 'c' && field_count == 4)
+    {
+        level = parse_level(fields[1]);
+        exit = level == 0 ? ARGUMENTS_EXCEPTION : SUCCESS;
+    }
+    else if (fields[0][0] != 'd' || field_count != 3)
+    {
+        exit = ARGUMENTS_EXCEPTION;
+    }
+
+    if (exit == SUCCESS)
+    {
+        exit = get_request_filename(connection, fields[field_count - 2], in_filename, &in_fd);
+    }
+    if (exit == SUCCESS)
+    {
+        exit = get_request_filename(connection, fields[field_count - 1], out_filename, &out_fd);
+    }
+    if (exit == SUCCESS)
+    {
+        exit = level > 0 ? compress(in_filename, out_filename, level) : decompress(in_filename, out_filename);
+    }
+
+    if (in_fd != -1)
+    {
+        close(in_fd);
+    }
+    if (out_fd != -1)
+    {
+        close(out_fd);
+    }
+
+    if (daemon_arguments->should_view_info)
+    {
+        pthread_mutex_lock(&daemon_mutex);
+        printf(" - Anfrage %c: Exit-Code %d\n", fields[0][0], exit);
+        fflush(stdout);
+        pthread_mutex_unlock(&daemon_mutex);
+    }
+    return send_response(connection, exit, -1);
+}
+
+static EXIT process_inline_request(CONNECTION *connection, int level, unsigned long long size)
+{
+    char in_filename[MAX_LENGTH_FILENAME];
+    char out_filename[MAX_LENGTH_FILENAME];
+    struct stat attribut;
+    int in_fd = memfd_create("huffman-in", MFD_CLOEXEC);
+    int out_fd = memfd_create("huffman-out", MFD_CLOEXEC);
+    off_t offset = 0;
+    EXIT exit;
+
+    exit = receive_payload(connection, in_fd, size);
+    if (exit != SUCCESS || in_fd == -1 || out_fd == -1)
+    {
+        if (in_fd != -1)
+        {
+            close(in_fd);
+        }
+        if (out_fd != -1)
+        {
+            close(out_fd);
+        }
+        // without the complete payload the connection is out of sync, a short file is never encoded
+        return exit == IO_EXCEPTION ? exit : send_response(connection, UNKNOWN_EXCEPTION, 0);
+    }
+
+    // the codec works on filenames, the anonymous files are reopened through /proc
+    snprintf(in_filename, MAX_LENGTH_FILENAME, "/proc/self/fd/%d", in_fd);
+    snprintf(out_filename, MAX_LENGTH_FILENAME, "/proc/self/fd/%d", out_fd);
+    exit = level > 0 ? compress(in_filename, out_filename, level) : decompress(in_filename, out_filename);
+    close(in_fd);
+
+    if (exit == SUCCESS && fstat(out_fd, &attribut) != 0)
+    {
+        exit = IO_EXCEPTION;
+    }
+
+    if (daemon_arguments->should_view_info)
+    {
+        pthread_mutex_lock(&daemon_mutex);
+        printf(" - Anfrage %c: Exit-Code %d\n", level > 0 ? 'C' : 'D', exit);
+        fflush(stdout);
+        pthread_mutex_unlock(&daemon_mutex);
+    }
+
+    if (exit != SUCCESS)
+    {
+        close(out_fd);
+        return send_response(connection, exit, 0);
+    }
+
+    exit = send_response(connection, SUCCESS, (long long) attribut.st_size);
+    while (exit == SUCCESS && offset < attribut.st_size)
+    {
+        if (sendfile(connection->socket, out_fd, &offset, (size_t) (attribut.st_size - offset)) <= 0)
+        {
+            exit = IO_EXCEPTION;
+        }
+    }
+    close(out_fd);
+    return exit;
+}
+
+static EXIT receive(CONNECTION *connection)
+{
+    union
+    {
+        struct cmsghdr header;
+        char space[CMSG_SPACE(sizeof(int) * MAX_PASSED_FDS)];
+    } control;
+    struct iovec vector;
+    struct msghdr message = {0};
+    ssize_t received;
+
+    // move pending bytes to the front
+    memmove(connection->buffer, connection->buffer + connection->position,
+            connection->filling_level - connection->position);
+    connection->filling_level -= connection->position;
+    connection->position = 0;
+    if (connection->filling_level == MAX_LENGTH_REQUEST)
+    {
+        return IO_EXCEPTION;
+    }
+
+    vector.iov_base = connection->buffer + connection->filling_level;
+    vector.iov_len = MAX_LENGTH_REQUEST - connection->filling_level;
+    message.msg_iov = &vector;
+    message.msg_iovlen = 1;
+    message.msg_control = control.space;
+    message.msg_controllen = sizeof(control.space);
+
+    received = recvmsg(connection->socket, &message, MSG_CMSG_CLOEXEC);
+    if (received <= 0)
+    {
+        return IO_EXCEPTION;
+    }
+    connection->filling_level += (size_t) received;
+
+    for (struct cmsghdr *header = CMSG_FIRSTHDR(&message); header != NULL; header = CMSG_NXTHDR(&message, header))
+    {
+        if (header->cmsg_level == SOL_SOCKET && header->cmsg_type == SCM_RIGHTS)
+        {
+            int count = (int) ((header->cmsg_len - CMSG_LEN(0)) / sizeof(int));
+            for (int i = 0; i < count; i++)
+            {
+                int fd;
+                memcpy(&fd, CMSG_DATA(header) + i * sizeof(int), sizeof(int));
+                if (connection->fd_count < MAX_PASSED_FDS)
+                {
+                    connection->fds[connection->fd_count++] = fd;
+                }
+                else
+                {
+                    close(fd);
+                }
+            }
+        }
+    }
+    return SUCCESS;
+}
+
+static EXIT receive_request(CONNECTION *connection, char *request)
+{
+    char *end;
+
+    while ((end = memchr(connection->buffer + connection->position, '\n',
+                         connection->filling_level - connection->position)) == NULL)
+    {
+        if (receive(connection) != SUCCESS)
+        {
+            return IO_EXCEPTION;
+        }
+    }
+
+    *end = '\0';
+    strcpy(request, connection->buffer + connection->position);
+    connection->position = (size_t) (end - connection->buffer) + 1;
+    return SUCCESS;
+}
+
+static EXIT receive_payload(CONNECTION *connection, int fd, unsigned long long size)
+{
+    unsigned char transfer[TRANSFER_SIZE];
+    bool is_written = true;
+
+    // bytes received together with the request come first
+    while (size > 0 && connection->position < connection->filling_level)
+    {
+        size_t count = connection->filling_level - connection->position;
+        if (count > size)
+        {
+            count = (size_t) size;
+        }
+        if (fd != -1 && write(fd, connection->buffer + connection->position, count) != (ssize_t) count)
+        {
+            fd = -1;
+            is_written = false;
+        }
+        connection->position += count;
+        size -= count;
+    }
+
+    while (size > 0)
+    {
+        ssize_t received = recv(connection->socket, transfer, size < TRANSFER_SIZE ? (size_t) size : TRANSFER_SIZE, 0);
+        if (received <= 0)
+        {
+            return IO_EXCEPTION;
+        }
+        // keep receiving after a failed write, so the connection stays in sync
+        if (fd != -1 && write(fd, transfer, (size_t) received) != received)
+        {
+            fd = -1;
+            is_written = false;
+        }
+        size -= (unsigned long long) received;
+    }
+    return is_written ? SUCCESS : UNKNOWN_EXCEPTION;
+}
+
+static EXIT send_response(CONNECTION *connection, EXIT exit, long long size)
+{
+    char response[48];
+    int length = size < 0 ? snprintf(response, sizeof(response), "%d\n", exit)
+                          : snprintf(response, sizeof(response), "%d %lld\n", exit, size);
+
+    for (int sent = 0; sent < length;)
+    {
+        ssize_t count = send(connection->socket, response + sent, (size_t) (length - sent), MSG_NOSIGNAL);
+        if (count <= 0)
+        {
+            return IO_EXCEPTION;
+        }
+        sent += (int) count;
+    }
+    return SUCCESS;
+}
+
+static EXIT get_request_filename(CONNECTION *connection, char *field, char *filename, int *fd)
+{
+    *fd = -1;
+    if (strcmp(field, "-") != 0)
+    {
+        if (strlen(field) > MAX_LENGTH_FILENAME - 4)
+        {
+            return ARGUMENTS_EXCEPTION;
+        }
+        strcpy(filename, field);
+        return SUCCESS;
+    }
+
+    if (connection->fd_count == 0)
+    {
+        return ARGUMENTS_EXCEPTION;
+    }
+    *fd = connection->fds[0];
+    connection->fd_count--;
+    memmove(connection->fds, connection->fds + 1, sizeof(int) * (size_t) connection->fd_count);
+    snprintf(filename, MAX_LENGTH_FILENAME, "/proc/self/fd/%d", *fd);
+    return SUCCESS;
+}
+
+static int parse_level(char *field)
+{
+    if (field == NULL || strlen(field) != 1 || field[0] < '1' || field[0] > '9')
+    {
+        return 0;
+    }
+    return field[0] - '0';
+}
@@ -0,0 +1,41 @@
+/**
+ * @file
+ * Dieses Modul implementiert den Dienstmodus: Das Programm wartet an einem
+ * Unix-Domain-Socket auf Anfragen und bearbeitet sie mit einem Pool von
+ * Worker-Threads. Jeder Thread behält seine Puffer, Tabellen und Kerne über
+ * alle Anfragen hinweg, sodass Programmstart und Aufbau entfallen.
+ *
+ * Eine Verbindung kann beliebig viele Anfragen nacheinander stellen. Jede
+ * Anfrage ist eine Zeile, deren Felder durch ein Leerzeichen getrennt sind:
+ *  - "c <level> <infile> <outfile>": komprimiert eine Datei
+ *  - "d <infile> <outfile>": dekomprimiert eine Datei
+ *  - "C <level> <size>": komprimiert die folgenden size Bytes
+ *  - "D <size>": dekomprimiert die folgenden size Bytes
+ *
+ * Statt eines Dateinamens steht "-" für den nächsten mit der Anfrage
+ * übergebenen Dateideskriptor (SCM_RIGHTS). Dateinamen dürfen keine
+ * Leerzeichen enthalten und werden relativ zum Arbeitsverzeichnis des
+ * Dienstes aufgelöst.
+ *
+ * Die Antwort ist eine Zeile mit dem Exit-Code, bei "C" und "D" gefolgt von
+ * einem Leerzeichen und der Größe des Ergebnisses, das direkt danach folgt.
+ *
+ * @author  Tim Ostermann
+ * @date    2020-12-05
+ */
+
+#ifndef HUFFMAN_DAEMON_H
+#define HUFFMAN_DAEMON_H
+
+#include "huffman_common.h"
+#include "arguments.h"
+
+/**
+ * Startet den Dienst am Socket der Eingabeparameter und kehrt nur bei
+ * einem Fehler zurück. Ein vorhandener Socket gleichen Namens wird ersetzt.
+ * @param arguments - Eingabeparameter des Konsolenaufrufs
+ * @return Exit-Code
+ */
+extern EXIT run_daemon(ARGUMENTS *arguments);
+
+#endif //HUFFMAN_DAEMON_H
@@ -33,7 +33,7 @@
 /* ---------------------------------------------------------------------------
  * Funktion: frequency_create
  * ------------------------------------------------------------------------ */
-extern FREQUENCY *frequency_create(const unsigned char word, const int count)
+extern FREQUENCY *frequency_create(const unsigned int word, const long long count)
 {
     /* Speicher für die Struktur allokieren */
     FREQUENCY *p_frequency = malloc(sizeof (FREQUENCY));
@@ -70,7 +70,7 @@ extern void frequency_destroy(FREQUENCY **pp_frequency)
 /* ---------------------------------------------------------------------------
  * Funktion: frequency_get_word
  * ------------------------------------------------------------------------ */
-extern unsigned char frequency_get_word(const FREQUENCY *p_frequency)
+extern unsigned int frequency_get_word(const FREQUENCY *p_frequency)
 {
     if (p_frequency != NULL)
     {
@@ -81,9 +81,9 @@ extern unsigned char frequency_get_word(const FREQUENCY *p_frequency)
 /* ---------------------------------------------------------------------------
  * Funktion: frequency_get_count
  * ------------------------------------------------------------------------ */
-extern int frequency_get_count(const FREQUENCY *p_frequency)
+extern long long frequency_get_count(const FREQUENCY *p_frequency)
 {
-    int count = -1;
+    long long count = -1;
 
     if (p_frequency != NULL)
     {
@@ -97,7 +97,7 @@ extern int frequency_get_count(const FREQUENCY *p_frequency)
  * Funktion: frequency_set_word
  * ------------------------------------------------------------------------ */
 extern void frequency_set_word(FREQUENCY *p_frequency, 
-                               const unsigned char word)
+                               const unsigned int word)
 {
     if (p_frequency != NULL)
     {
@@ -109,7 +109,7 @@ extern void frequency_set_word(FREQUENCY *p_frequency,
  * Funktion: frequency_set_count
  * ------------------------------------------------------------------------ */
 extern void frequency_set_count(FREQUENCY *p_frequency, 
-                                const int count)
+                                const long long count)
 {
     if (p_frequency != NULL)
     {
@@ -155,13 +155,13 @@ extern char *frequency_get_string(const FREQUENCY *p_frequency)
         /* Inhalt der Struktur in String schreiben */
         if (p_frequency->word != '\0')
         {
-            printf("[%c: %d]",
+            printf("[%c: %lld]",
                      p_frequency->word, p_frequency->count);
         }
         else
         {
             snprintf(string, arity + 5 * sizeof(char),
-                     "[-: %d]", p_frequency->count);
+                     "[-: %lld]", p_frequency->count);
         }
     }
 
@@ -175,6 +175,6 @@ extern void frequency_print(const FREQUENCY *p_frequency)
 {
     if (p_frequency != NULL)
     {
-        printf("[%c: %d]", p_frequency->word, p_frequency->count);
+        printf("[%c: %lld]", p_frequency->word, p_frequency->count);
     }
 }
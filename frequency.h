@@ -23,13 +23,15 @@
 typedef struct
 {
     /**
-     * Komponente für das Wort
+     * Komponente für das Wort (Zeichen oder Sondersymbol oberhalb der
+     * Bytewerte, z.B. Escape-Symbol)
      */
-    unsigned char word;
+    unsigned int word;
     /**
-     * Komponente für die Anzahl der Wortvorkommen
+     * Komponente für die Anzahl der Wortvorkommen (64 Bit, damit auch
+     * Dateien größer als 4 GB gezählt werden können)
      */
-    int count;
+    long long count;
 } FREQUENCY;
 
 /* ===========================================================================
@@ -44,7 +46,7 @@ typedef struct
  * @param count     die abzulegende Häufigkeit
  * @return          die neu erzeugte Struktur
  */
-extern FREQUENCY *frequency_create(const unsigned char word, const int count);
+extern FREQUENCY *frequency_create(const unsigned int word, const long long count);
 
 /**
  * Löscht die Struktur und ihren Inhalt. Setzt den übergebenen Zeiger auf NULL.
@@ -61,7 +63,7 @@ extern void frequency_destroy(FREQUENCY **pp_frequency);
  *                      NULL, wenn keine Struktur übergeben wurde oder die
  *                      Struktur kein Wort enthült.
  */
-extern unsigned char frequency_get_word(const FREQUENCY *p_frequency);
+extern unsigned int frequency_get_word(const FREQUENCY *p_frequency);
 
 /**
  * Liefert die Häufigkeit der übergebenen Frequency-Struktur.
@@ -70,7 +72,7 @@ extern unsigned char frequency_get_word(const FREQUENCY *p_frequency);
  * @return              Häufigkeit der übergebenen Frequency-Struktur oder -1,
  *                      wenn keine Struktur übergeben wurde.
  */
-extern int frequency_get_count(const FREQUENCY *p_frequency);
+extern long long frequency_get_count(const FREQUENCY *p_frequency);
 
 /**
  * ändert das Wort der übergebenen Struktur. Ist das übergebene Wort gleich
@@ -80,7 +82,7 @@ extern int frequency_get_count(const FREQUENCY *p_frequency);
  * @param word          das einzutragende Wort
  */
 extern void frequency_set_word(FREQUENCY *p_frequency, 
-                               const unsigned char word);
+                               const unsigned int word);
 
 /**
  * ändert die Häufigkeit in der übergebenen Struktur.
@@ -89,7 +91,7 @@ extern void frequency_set_word(FREQUENCY *p_frequency,
  * @param count         - die einzutragende Häufigkeit
  */
 extern void frequency_set_count(FREQUENCY *p_frequency,
-                                const int count);
+                                const long long count);
 
 /**
  * Vergleicht zwei Frequency-Strukturen miteinander. Die Funktion liefert 0, 
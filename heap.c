@@ -0,0 +1,243 @@
+#include "heap.h"
+#include "huffman_common.h"
+#include <stdlib.h>
+#include <stdio.h>
+
+/**
+ * Implementierung des Heaps.
+ */
+typedef struct _HEAP
+{
+    /**
+     * Heap-Speicher
+     */
+    void **elements;
+
+    /**
+     * Funktion zum Vergleich zweier Heap-Elemente
+     */
+    HEAP_ELEM_COMP comp_elem_func;
+
+    /**
+     * Funktion zur Ausgabe eines Heap-Elements
+     */
+    HEAP_ELEM_PRINT print_elem_func;
+
+    /**
+     * Heap-Größe
+     */
+    int size;
+
+    /**
+     * Heap-Füllstand
+     */
+    int filling_level;
+} HEAP;
+
+/**
+ * Verschiebt ein Element so lange in Richtung Wurzel, bis die
+ * Heap-Eigenschaft wiederhergestellt ist.
+ * @param heap - der Heap
+ * @param index - Index des Elements
+ */
+static void sift_up(HEAP *heap, int index);
+
+/**
+ * Verschiebt ein Element so lange in Richtung Blätter, bis die
+ * Heap-Eigenschaft wiederhergestellt ist.
+ * @param heap - der Heap
+ * @param index - Index des Elements
+ */
+static void sift_down(HEAP *heap, int index);
+
+/**
+ * Vergrößert den Heap-Speicher auf mindestens die angegebene Größe.
+ * Der Speicher wird dabei mindestens verdoppelt.
+ * @param heap - der Heap
+ * @param size - benötigte Größe
+ */
+static void ensure_size(HEAP *heap, int size);
+
+/**
+ * Gibt die Unter-Baumstruktur ab einem bestimmten Element aus.
+ * @param heap - der Heap
+ * @param index - Index des Elements im Heap
+ * @param depth - Tiefe des Elements in Baumstruktur
+ */
+static void print_subtree(HEAP *heap, int index, int depth);
+
+extern HEAP *heap_create(HEAP_ELEM_COMP comp, HEAP_ELEM_PRINT print, int capacity)
+{
+    HEAP *heap = (HEAP *) malloc(sizeof(HEAP));
+
+    if (heap == NULL)
+    {
+        printf("Fehler bei der Speicherreservierung.");
+        exit(1);
+    }
+
+    // set comp and print function, init heap, set size and filling_level to initial values
+    heap->comp_elem_func = comp;
+    heap->print_elem_func = print;
+    heap->elements = NULL;
+    heap->size = 0;
+    heap->filling_level = 0;
+    ensure_size(heap, capacity > 0 ? capacity : NUM_OF_ELEMENTS);
+
+    return heap;
+}
+
+extern void heap_destroy(HEAP **heap)
+{
+    if (heap != NULL && *heap != NULL)
+    {
+        free((*heap)->elements);
+        free(*heap);
+        *heap = NULL;
+    }
+}
+
+extern void heap_build(HEAP *heap, void **elements, int count)
+{
+    ensure_size(heap, count);
+    for (int i = 0; i < count; i++)
+    {
+        heap->elements[i] = elements[i];
+    }
+    heap->filling_level = count;
+
+    // restore heap property bottom-up, starting at the last inner element
+    for (int index = (count - 2) / HEAP_ARITY; index >= 0 && count > 1; index--)
+    {
+        sift_down(heap, index);
+    }
+}
+
+extern void heap_insert(HEAP *heap, void *element)
+{
+    ensure_size(heap, heap->filling_level + 1);
+
+    // add element to heap and move it to right position
+    heap->elements[heap->filling_level] = element;
+    heap->filling_level++;
+    sift_up(heap, heap->filling_level - 1);
+}
+
+extern bool heap_extract_min(HEAP *heap, void **min_element)
+{
+    if (heap->filling_level == 0)
+    {
+        return false;
+    }
+
+    // extract first element, move last element to the root
+    *min_element = heap->elements[0];
+    heap->filling_level--;
+    if (heap->filling_level > 0)
+    {
+        heap->elements[0] = heap->elements[heap->filling_level];
+        sift_down(heap, 0);
+    }
+
+    return true;
+}
+
+extern int heap_get_size(HEAP *heap)
+{
+    return heap->filling_level;
+}
+
+extern void heap_print(HEAP *heap)
+{
+    if (heap->filling_level > 0)
+    {
+        print_subtree(heap, 0, 0);
+        printf("\n");
+    }
+}
+
+static void sift_up(HEAP *heap, int index)
+{
+    void *element = heap->elements[index];
+
+    while (index > 0)
+    {
+        int parent_index = (index - 1) / HEAP_ARITY;
+        if (heap->comp_elem_func(element, heap->elements[parent_index]) != -1)
+        {
+            break;
+        }
+        heap->elements[index] = heap->elements[parent_index];
+        index = parent_index;
+    }
+    heap->elements[index] = element;
+}
+
+static void sift_down(HEAP *heap, int index)
+{
+    void *element = heap->elements[index];
+
+    for (;;)
+    {
+        int first_child_index = HEAP_ARITY * index + 1;
+        int last_child_index = first_child_index + HEAP_ARITY;
+        int smallest_child_index = first_child_index;
+
+        if (first_child_index >= heap->filling_level)
+        {
+            break;
+        }
+        if (last_child_index > heap->filling_level)
+        {
+            last_child_index = heap->filling_level;
+        }
+
+        // find smallest child
+        for (int i = first_child_index + 1; i < last_child_index; i++)
+        {
+            if (heap->comp_elem_func(heap->elements[i], heap->elements[smallest_child_index]) == -1)
+            {
+                smallest_child_index = i;
+            }
+        }
+
+        if (heap->comp_elem_func(heap->elements[smallest_child_index], element) != -1)
+        {
+            break;
+        }
+        heap->elements[index] = heap->elements[smallest_child_index];
+        index = smallest_child_index;
+    }
+    heap->elements[index] = element;
+}
+
+static void ensure_size(HEAP *heap, int size)
+{
+    if (size > heap->size)
+    {
+        int new_size = heap->size * 2 > size ? heap->size * 2 : size;
+        heap->elements = realloc(heap->elements, (size_t) new_size * sizeof(void *));
+        if (heap->elements == NULL)
+        {
+            printf("Fehler bei der Speicherreservierung.");
+            exit(1);
+        }
+        heap->size = new_size;
+    }
+}
+
+static void print_subtree(HEAP *heap, int index, int depth)
+{
+    for (int i = 0; i < depth; i++)
+    {
+        printf("\t");
+    }
+    printf("|--");
+    heap->print_elem_func(heap->elements[index]);
+    printf("\n");
+
+    for (int i = HEAP_ARITY * index + 1; i <= HEAP_ARITY * index + HEAP_ARITY && i < heap->filling_level; i++)
+    {
+        print_subtree(heap, i, depth + 1);
+    }
+}
@@ -0,0 +1,195 @@
+/**
+ * @file
+ * Dieses Modul stellt einen d-ären Min-Heap (d = HEAP_ARITY) zur Verfügung.
+ * Jeder Heap wird über ein eigenes Handle angesprochen, sodass mehrere Heaps
+ * gleichzeitig (auch in verschiedenen Threads) verwendet werden können.
+ *
+ * Neben der generischen Variante mit Vergleichsfunktion erzeugt das Makro
+ * HEAP_DEFINE_TYPED() eine typisierte Variante, bei der der Vergleich direkt
+ * eingesetzt wird und die auf vom Aufrufer bereitgestelltem Speicher arbeitet.
+ *
+ * @author  Tim Ostermann
+ * @date    2020-12-05
+ */
+
+#ifndef HEAP_HEAP_H
+#define HEAP_HEAP_H
+
+#include <stdbool.h>
+
+/**
+ * Anzahl der Kindelemente je Element. Vier Kinder liegen meist in derselben
+ * Cache-Line und halbieren die Höhe gegenüber einem Binärheap.
+ */
+#define HEAP_ARITY 4
+
+/**
+ * Repräsentation eines Heaps
+ */
+typedef struct _HEAP HEAP;
+
+/**
+ * Typdefiniton Elementsvergleichsfunktion
+ */
+typedef int (*HEAP_ELEM_COMP) (void *elem1, void *elem2);
+
+/**
+ * Typdefiniton Elementsausgabefunktion
+ */
+typedef void (*HEAP_ELEM_PRINT) (void *elem);
+
+/**
+ * Erzeugt einen leeren Heap.
+ * @param comp - Elementsvergleichsfunktion, liefert -1, wenn das erste Element kleiner ist
+ * @param print - Elementsausgabefunktion
+ * @param capacity - Anzahl Elemente, für die vorab Speicher reserviert wird
+ * @return der neu erzeugte Heap
+ */
+extern HEAP *heap_create(HEAP_ELEM_COMP comp, HEAP_ELEM_PRINT print, int capacity);
+
+/**
+ * Gibt Speicher des Heaps frei und setzt den übergebenen Zeiger auf NULL.
+ * Die enthaltenen Elemente werden nicht freigegeben.
+ * @param heap - Zeiger auf den Heap
+ */
+extern void heap_destroy(HEAP **heap);
+
+/**
+ * Ersetzt den Inhalt des Heaps durch die übergebenen Elemente und stellt die
+ * Heap-Eigenschaft in O(n) her.
+ * @param heap - der Heap
+ * @param elements - einzufügende Elemente
+ * @param count - Anzahl der Elemente
+ */
+extern void heap_build(HEAP *heap, void **elements, int count);
+
+/**
+ * Fügt ein neues Element in den Heap ein und stellt Heap-Eigenschaft wieder her.
+ * @param heap - der Heap
+ * @param element - einzufügendes Element
+ */
+extern void heap_insert(HEAP *heap, void *element);
+
+/**
+ * Entfernt kleinstes Element des Heaps und stellt Heap-Eigenschaft wieder her.
+ * @param heap - der Heap
+ * @param min_element - Übergabeparameter für extrahiertes Element
+ * @return false, falls heap leer ist, sonst true
+ */
+extern bool heap_extract_min(HEAP *heap, void **min_element);
+
+/**
+ * Liefert die Anzahl der Elemente im Heap.
+ * @param heap - der Heap
+ * @return Anzahl der Elemente
+ */
+extern int heap_get_size(HEAP *heap);
+
+/**
+ * Gibt Heap auf dem Bildschirm aus.
+ * @param heap - der Heap
+ */
+extern void heap_print(HEAP *heap);
+
+/**
+ * Erzeugt einen typisierten d-ären Min-Heap NAME für Elemente vom Typ TYPE.
+ * LESS(a, b) muss ein Ausdruck sein, der genau dann wahr ist, wenn a kleiner
+ * als b ist. Der Heap arbeitet auf Speicher des Aufrufers und reserviert
+ * selbst keinen Speicher. Erzeugt werden:
+ *  - NAME##_init(heap, elements, capacity)
+ *  - NAME##_build(heap, count): stellt Heap-Eigenschaft für die ersten count
+ *    Elemente in O(n) her
+ *  - NAME##_insert(heap, element): false, falls der Speicher voll ist
+ *  - NAME##_extract_min(heap, &element): false, falls der Heap leer ist
+ */
+#define HEAP_DEFINE_TYPED(NAME, TYPE, LESS)                                         \
+typedef struct                                                                      \
+{                                                                                   \
+    TYPE *elements;                                                                 \
+    int capacity;                                                                   \
+    int filling_level;                                                              \
+} NAME;                                                                             \
+                                                                                    \
+static inline void NAME##_sift_down(NAME *heap, int index)                          \
+{                                                                                   \
+    TYPE element = heap->elements[index];                                           \
+    for (;;)                                                                        \
+    {                                                                               \
+        int first_child = HEAP_ARITY * index + 1;                                   \
+        int last_child = first_child + HEAP_ARITY;                                  \
+        int min_child = first_child;                                                \
+        if (first_child >= heap->filling_level)                                     \
+        {                                                                           \
+            break;                                                                  \
+        }                                                                           \
+        if (last_child > heap->filling_level)                                       \
+        {                                                                           \
+            last_child = heap->filling_level;                                       \
+        }                                                                           \
+        for (int child = first_child + 1; child < last_child; child++)              \
+        {                                                                           \
+            if (LESS(heap->elements[child], heap->elements[min_child]))             \
+            {                                                                       \
+                min_child = child;                                                  \
+            }                                                                       \
+        }                                                                           \
+        if (!LESS(heap->elements[min_child], element))                              \
+        {                                                                           \
+            break;                                                                  \
+        }                                                                           \
+        heap->elements[index] = heap->elements[min_child];                          \
+        index = min_child;                                                          \
+    }                                                                               \
+    heap->elements[index] = element;                                                \
+}                                                                                   \
+                                                                                    \
+static inline void NAME##_init(NAME *heap, TYPE *elements, int capacity)            \
+{                                                                                   \
+    heap->elements = elements;                                                      \
+    heap->capacity = capacity;                                                      \
+    heap->filling_level = 0;                                                        \
+}                                                                                   \
+                                                                                    \
+static inline void NAME##_build(NAME *heap, int count)                              \
+{                                                                                   \
+    heap->filling_level = count;                                                    \
+    for (int index = (count - 2) / HEAP_ARITY; index >= 0 && count > 1; index--)    \
+    {                                                                               \
+        NAME##_sift_down(heap, index);                                              \
+    }                                                                               \
+}                                                                                   \
+                                                                                    \
+static inline bool NAME##_insert(NAME *heap, TYPE element)                          \
+{                                                                                   \
+    int index = heap->filling_level;                                                \
+    if (index == heap->capacity)                                                    \
+    {                                                                               \
+        return false;                                                               \
+    }                                                                               \
+    heap->filling_level++;                                                          \
+    while (index > 0 && LESS(element, heap->elements[(index - 1) / HEAP_ARITY]))    \
+    {                                                                               \
+        heap->elements[index] = heap->elements[(index - 1) / HEAP_ARITY];           \
+        index = (index - 1) / HEAP_ARITY;                                           \
+    }                                                                               \
+    heap->elements[index] = element;                                                \
+    return true;                                                                    \
+}                                                                                   \
+                                                                                    \
+static inline bool NAME##_extract_min(NAME *heap, TYPE *min_element)                \
+{                                                                                   \
+    if (heap->filling_level == 0)                                                   \
+    {                                                                               \
+        return false;                                                               \
+    }                                                                               \
+    *min_element = heap->elements[0];                                               \
+    heap->filling_level--;                                                          \
+    if (heap->filling_level > 0)                                                    \
+    {                                                                               \
+        heap->elements[0] = heap->elements[heap->filling_level];                    \
+        NAME##_sift_down(heap, 0);                                                  \
+    }                                                                               \
+    return true;                                                                    \
+}
+
+#endif //HEAP_HEAP_H
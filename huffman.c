@@ -4,10 +4,20 @@
 #include "frequency.h"
 #include "btree.h"
 #include "btreenode.h"
-#include "binary_heap.h"
+#include "heap.h"
 #include "huffman_code.h"
+#include "checksum.h"
+#include "kernel.h"
+#include "ans.h"
+#include "lz.h"
+#include "bwt.h"
 #include <string.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <limits.h>
+#include <math.h>
+#include <pthread.h>
+#include <unistd.h>
 
 /**
  * Zeichen, um das der Huffman-Code erweitert wird, wenn man in der Baumstruktur "nach links" geht.
@@ -20,272 +30,2528 @@
 #define RIGHT_SIGN "0"
 
 /**
- * Frequencies der gelesenen Datei
+ * Element des Heaps, mit dem der optimale Baum aufgebaut wird
  */
-static FREQUENCY **frequencies;
+typedef struct
+{
+    /**
+     * Häufigkeit in der Wurzel des Baumes
+     */
+    long long count;
+
+    /**
+     * Teilbaum
+     */
+    BTREE *tree;
+} TREE_ELEMENT;
+
+/**
+ * Vergleicht zwei Heap-Elemente anhand der Häufigkeit in ihrer Wurzel
+ */
+#define TREE_ELEMENT_LESS(ELEM1, ELEM2) ((ELEM1).count < (ELEM2).count)
+
+HEAP_DEFINE_TYPED(TREE_HEAP, TREE_ELEMENT, TREE_ELEMENT_LESS)
+
+/**
+ * Kodierung eines Blocks, steht im Blockkopf über dem Bit für die
+ * Wiederverwendung der Tabelle
+ */
+typedef enum
+{
+    BLOCK_HUFFMAN = 0,
+    BLOCK_ANS = 1,
+    BLOCK_LZ = 2,
+    BLOCK_BWT = 3
+} BLOCK_MODE;
+
+/**
+ * Anzahl der Bits für die Kodierung eines Blocks im Blockkopf
+ */
+#define BLOCK_MODE_BITS 2
+
+/**
+ * Bit im Blockkopf über der Kodierung, das den ersten Block eines
+ * gefilterten Blockspeichers kennzeichnet
+ */
+#define BLOCK_FILTERED (1u << (BLOCK_MODE_BITS + 1))
+
+/**
+ * Anzahl der Bits im Blockkopf unter der Anzahl der Zeichen
+ */
+#define BLOCK_HEADER_BITS (BLOCK_MODE_BITS + 2)
+
+/**
+ * Burrows-Wheeler-Transformation eines Blocks samt gewählter Tabelle
+ */
+typedef struct
+{
+    /**
+     * Symbole nach MTF und Lauflängenkodierung
+     */
+    unsigned char *symbols;
+
+    /**
+     * Anzahl der Symbole
+     */
+    size_t symbol_count;
+
+    /**
+     * Zeile des ursprünglichen Blocks
+     */
+    size_t primary_index;
+
+    /**
+     * Häufigkeiten der Symbole
+     */
+    unsigned long long counts[NUM_OF_SYMBOLS];
+
+    /**
+     * Gibt an, ob die Symbole mit tANS statt Huffman-Codes kodiert werden
+     */
+    bool is_ans;
+
+    /**
+     * Normierte Häufigkeiten für tANS
+     */
+    unsigned short normalized[NUM_OF_SYMBOLS];
+} BWT_BLOCK;
+
+/**
+ * Abschnitt der Eingabedatei, den ein Thread beim parallelen Zählen der
+ * Häufigkeiten übernimmt
+ */
+typedef struct
+{
+    /**
+     * Anfang des Abschnitts
+     */
+    const unsigned char *data;
+
+    /**
+     * Anzahl der Zeichen
+     */
+    size_t size;
+
+    /**
+     * Gibt an, ob die Prüfsumme berechnet wird
+     */
+    bool has_crc;
+
+    /**
+     * Häufigkeiten der Zeichen des Abschnitts
+     */
+    unsigned long long counts[NUM_OF_SYMBOLS];
+
+    /**
+     * Prüfsumme des Abschnitts ab CHECKSUM_INIT
+     */
+    unsigned int crc;
+} COUNT_RANGE;
+
+/**
+ * Kleinste Anzahl Zeichen, die ein Thread beim parallelen Zählen übernimmt,
+ * damit sich das Starten des Threads lohnt
+ */
+#define COUNT_MIN_RANGE_SIZE 4194304
+
+/**
+ * Höchste Anzahl Threads beim parallelen Zählen
+ */
+#define COUNT_MAX_THREADS 64
+
+/**
+ * Anzahl der Ströme eines LZ77-Blocks: Literale sowie Codes der Anzahlen,
+ * Längen und Abstände
+ */
+#define LZ_STREAM_COUNT 4
+
+/**
+ * Höchster Komprimierungslevel, bei dem große Dateien in einem Durchlauf
+ * mit einer Tabelle aus einer Stichprobe komprimiert werden
+ */
+#define SAMPLE_MAX_LEVEL 1
+
+/**
+ * Anzahl der gleichmäßig über die Datei verteilten Abschnitte der Stichprobe
+ */
+#define SAMPLE_CHUNKS 64
+
+/**
+ * Größe eines Abschnitts der Stichprobe in Bytes
+ */
+#define SAMPLE_CHUNK_SIZE 65536
+
+/**
+ * Niedrigster Komprimierungslevel, ab dem Blöcke dort enden, wo sich die
+ * Verteilung der Zeichen ändert
+ */
+#define SPLIT_MIN_LEVEL 5
+
+/**
+ * Größe der Abschnitte, an deren Grenzen ein Block enden kann
+ */
+#define SPLIT_SEGMENT_SIZE 16384
+
+/**
+ * Niedrigster Komprimierungslevel, ab dem jeder Blockspeicher auch mit
+ * einer Burrows-Wheeler-Transformation versucht wird
+ */
+#define BWT_MIN_LEVEL 8
+
+/**
+ * Niedrigster Komprimierungslevel, ab dem ein Block mit tANS statt mit
+ * Huffman-Codes kodiert wird, wenn die Schätzung dafür spricht
+ */
+#define ANS_MIN_LEVEL 2
+
+/**
+ * Faktor, mit dem die geschätzte Länge einer tANS-Kodierung gewichtet wird.
+ * Die Schätzung ist für fast gleichverteilte Zeichen etwas zu niedrig, dort
+ * sind Huffman-Codes gleich gut und schneller.
+ */
+#define ANS_COST_FACTOR 1.002
+
+/**
+ * Anteil der geschätzten Bits ohne Filter, den ein automatisch gewählter
+ * Filter unterbieten muss. Filter verdecken Wiederholungen vor den
+ * späteren Stufen, deshalb muss sich ein Filter deutlich lohnen.
+ */
+#define FILTER_MIN_GAIN 0.97
+
+/**
+ * Höchste Summe der Häufigkeiten einer gelesenen Tabelle samt Escape-Symbol,
+ * sodass der Baum ohne Überlauf aufgebaut wird
+ */
+#define MAX_TABLE_COUNT ((unsigned long long) LLONG_MAX)
+
+/**
+ * Kleinste Anzahl Zeichen, ab der die Dekodiertabelle um Einträge mit
+ * mehreren Zeichen ergänzt wird. Deren Aufbau kostet etwa so viel wie das
+ * Dekodieren einiger tausend Zeichen.
+ */
+#define MULTI_MIN_CHAR_COUNT 32768
+
+/**
+ * Frequencies der gelesenen Datei, aufsteigend nach Zeichen, ggf. gefolgt
+ * vom Escape-Symbol
+ */
+static _Thread_local FREQUENCY *frequencies[NUM_OF_SYMBOLS + 1];
+
+/**
+ * Huffman-Code-Tabelle
+ */
+static _Thread_local HUFFMAN_CODE **huffman_code_table;
+
+/**
+ * Codelänge je Zeichen der Huffman-Code-Tabelle, 0 für nicht enthaltene
+ * Zeichen, zuletzt die des Escape-Symbols
+ */
+static _Thread_local unsigned short code_lengths[NUM_OF_SYMBOLS + 1];
+
+/**
+ * Größe des Blockspeichers und höchste Größe eines Blocks, für den jeweils
+ * entschieden wird, ob die Tabelle des vorherigen Blocks wiederverwendet
+ * oder eine neue Tabelle geschrieben wird; gilt für alle Threads
+ */
+static size_t codec_block_size = MAX_BLOCK_SIZE;
+
+/**
+ * Gibt an, ob der Speicher begrenzt ist; gilt für alle Threads
+ */
+static bool is_codec_bounded = false;
+
+/**
+ * Fenster der LZ77-Vorstufe, 0 falls abgeschaltet; gilt für alle Threads
+ */
+static size_t codec_window_size = 0;
+
+/**
+ * Filter der Komprimierung, FILTER_AUTO oder FILTER_NONE; gilt für alle Threads
+ */
+static unsigned int codec_filter = FILTER_NONE;
+
+/**
+ * Gibt an, ob alle Dateien mit der Tabelle aus set_codec_table() kodiert
+ * werden; gilt für alle Threads
+ */
+static bool has_codec_table = false;
+
+/**
+ * Häufigkeiten der Tabelle aus set_codec_table(); gilt für alle Threads
+ */
+static unsigned long long codec_table_counts[NUM_OF_SYMBOLS];
+
+/**
+ * Häufigkeit des Escape-Symbols der Tabelle aus set_codec_table(); gilt
+ * für alle Threads
+ */
+static unsigned long long codec_table_escape_count;
+
+/**
+ * Speicher für den aktuell zu kodierenden Block
+ */
+static _Thread_local unsigned char *block_buffer;
+
+/**
+ * Speicher für die gepackten Codes des aktuellen Blocks
+ */
+static _Thread_local unsigned char *packed_buffer;
+
+/**
+ * Speicher für einen gefilterten Blockspeicher, wird bei Bedarf reserviert
+ */
+static _Thread_local unsigned char *filter_buffer;
+
+/**
+ * Filter, den der nächste Blockkopf ankündigt, FILTER_NONE für keinen
+ */
+static _Thread_local unsigned int pending_filter;
+
+/**
+ * Anzahl der Zeichen, über die sich der angekündigte Filter erstreckt
+ */
+static _Thread_local size_t pending_filter_size;
+
+/**
+ * Codes der Huffman-Code-Tabelle für den Pack-Kern
+ */
+static _Thread_local ENCODE_TABLE *encode_table;
+
+/**
+ * Dekodiertabelle der Huffman-Code-Tabelle für den Dekodier-Kern
+ */
+static _Thread_local DECODE_TABLE *decode_table;
+
+/**
+ * Gibt an, ob die Kerne die Huffman-Code-Tabelle verarbeiten können, d.h.
+ * kein Code länger als KERNEL_MAX_CODE_LENGTH ist
+ */
+static _Thread_local bool has_kernel_tables;
+
+/**
+ * Gibt an, ob die aktuelle Tabelle eine tANS-Tabelle ist
+ */
+static _Thread_local bool is_ans_table;
+
+/**
+ * Normierte Häufigkeiten der aktuellen tANS-Tabelle
+ */
+static _Thread_local unsigned short ans_normalized[NUM_OF_SYMBOLS];
+
+/**
+ * Tabelle zum Kodieren mit tANS
+ */
+static _Thread_local ANS_ENCODE_TABLE *ans_encode_table;
+
+/**
+ * Tabelle zum Dekodieren mit tANS
+ */
+static _Thread_local ANS_DECODE_TABLE *ans_decode_table;
+
+/**
+ * Codelängen der vorgegebenen Tabelle einschließlich des Escape-Symbols
+ */
+static _Thread_local unsigned short given_code_lengths[NUM_OF_SYMBOLS + 1];
+
+/**
+ * Optimaler Binärbaum
+ */
+static _Thread_local BTREE *optimal_tree;
+
+/**
+ * Größe der Huffman-Code-Tabelle
+ */
+static _Thread_local unsigned int huff_size;
+
+/**
+ * Füllstand der Huffman-Code-Tabelle
+ */
+static _Thread_local unsigned int huff_filling_level;
+
+/**
+ * Füllstand der Frequencies
+ */
+static _Thread_local unsigned int freq_filling_level;
+
+/**
+ * Bestimmt die Huffman-Code-Tabelle.
+ * @param node - Knoten des Binärbaumes
+ * @param code - Speicher für den Huffman-Code, beginnend mit dem Code des Knotens
+ * @param length - Länge des Codes des Knotens
+ */
+static EXIT get_code_table(BTREE_NODE *node, char *code, unsigned int length);
+
+/**
+ * Dekodiert das nächste Zeichen aus der Eingabedatei.
+ * @return dekodiertes Zeichen oder -1, falls die Eingabedatei vorher endet
+ */
+static int decode_char(void);
+
+/**
+ * Zählt die Häufigkeiten eines eingeblendeten Speicherbereichs in
+ * Abschnitten, je einer pro Thread, und führt die Ergebnisse zusammen.
+ * @param data - Anfang des Speicherbereichs
+ * @param size - Anzahl der Zeichen
+ * @param counts - Häufigkeiten je Zeichen, werden erhöht
+ * @param crc - Zeiger auf fortzuschreibende Prüfsumme oder NULL
+ */
+static void count_mapped(const unsigned char *data, unsigned long long size, unsigned long long counts[],
+                         unsigned int *crc);
+
+/**
+ * Zählt die Häufigkeiten eines Abschnitts und berechnet seine Prüfsumme.
+ * Einstiegspunkt der Threads beim parallelen Zählen.
+ * @param range - Zeiger auf den Abschnitt (COUNT_RANGE)
+ * @return NULL
+ */
+static void *count_range(void *range);
+
+/**
+ * Liefert Index des Eintrags der Huffman-Code-Tabelle, dessen Zeichenkette dem Parameter-Code entspricht.
+ * @param code - Zeichenkette der gesuchten Huffman-Code-Tabelle
+ * @return -1 falls Huffman-Code-Tabelle keinen entsprechenden Eintrag hat, sonst den Index.
+ */
+static int get_code_table_index_by_code(char *code);
+
+/**
+ * Liefert Index des Eintrags der Huffman-Code-Tabelle, dessen Zeichen dem Parameter-Zeichen entspricht.
+ * @param next_char - Zeichen der gesuchten Huffman-Code-Tabelle
+ * @return -1 falls Huffman-Code-Tabelle keinen entsprechenden Eintrag hat, sonst den Index.
+ */
+static char *get_huffman_code_by_char(unsigned int next_char);
+
+/**
+ * Schreibt die Bits eines Huffman-Codes in die Ausgabedatei.
+ * @param code - Zeichenkette des Codes
+ */
+static void write_code(char *code);
+
+/**
+ * Zählt die Häufigkeiten einer Stichprobe aus SAMPLE_CHUNKS gleichmäßig
+ * über die Eingabedatei verteilten Abschnitten.
+ * @param counts - Häufigkeiten je Zeichen, werden erhöht
+ * @param in_size - Größe der Eingabedatei
+ * @return Häufigkeit des Escape-Symbols, 0 falls alle Zeichen vorkommen
+ */
+static unsigned long long sample_frequencies(unsigned long long counts[], unsigned long long in_size);
+
+/**
+ * Wählt die Tabelle für einen Block: Die aktuelle Tabelle wird
+ * wiederverwendet, wenn der Block damit höchstens so viele Bits belegt wie
+ * mit einer neuen Tabelle samt deren Kopf. Ist sie schon günstiger als die
+ * Entropie des Blocks, wird keine neue Tabelle aufgebaut. Eine neue Tabelle
+ * ist eine tANS-Tabelle, falls erlaubt und laut Schätzung kürzer.
+ * @param counts - Häufigkeiten des Blocks
+ * @param table_counts - Häufigkeiten der aktuellen Tabelle, werden bei einer
+ * neuen Tabelle überschrieben
+ * @param has_table - Gibt an, ob bereits eine Tabelle aufgebaut ist
+ * @param is_ans_allowed - Gibt an, ob eine tANS-Tabelle gewählt werden darf
+ * @param is_reused - Übergabeparameter, ob die aktuelle Tabelle wiederverwendet wird
+ * @return Exit-Code
+ */
+static EXIT select_code_table(const unsigned long long counts[], unsigned long long table_counts[], bool has_table,
+                              bool is_ans_allowed, bool *is_reused);
+
+/**
+ * Wählt die Tabelle eines Blocks bei vorgegebener Tabelle (--table-from):
+ * die vorgegebene, solange sie samt Escape-Codes nicht länger kodiert als
+ * eine eigene Tabelle des Blocks, sonst die eigene.
+ * @param plan - Angaben zur Eingabedatei mit der vorgegebenen Tabelle
+ * @param counts - Häufigkeiten des Blocks
+ * @param table_counts - Häufigkeiten der aktuellen Tabelle, werden bei einer
+ * neuen Tabelle überschrieben
+ * @param has_table - Gibt an, ob bereits eine Tabelle aufgebaut ist
+ * @param is_ans_allowed - Gibt an, ob eine eigene tANS-Tabelle gewählt werden darf
+ * @param is_reused - Übergabeparameter, ob die aktuelle Tabelle wiederverwendet wird
+ * @param is_given - Gibt an, ob die aktuelle Tabelle die vorgegebene ist, wird aktualisiert
+ * @return Exit-Code
+ */
+static EXIT select_given_table(const COMPRESS_PLAN *plan, const unsigned long long counts[],
+                               unsigned long long table_counts[], bool has_table, bool is_ans_allowed,
+                               bool *is_reused, bool *is_given);
+
+/**
+ * Liefert die Länge der Huffman-Kodierung von Häufigkeiten mit der
+ * aktuellen Huffman-Code-Tabelle.
+ * @param counts - Häufigkeiten je Zeichen
+ * @return Anzahl Bits, unendlich, falls ein Zeichen in der Tabelle fehlt
+ */
+static double get_huffman_bits(const unsigned long long counts[]);
+
+/**
+ * Bestimmt, wie viele Zeichen vom Anfang eines Speicherbereichs einen Block
+ * bilden. Der Bereich wird in Abschnitte von SPLIT_SEGMENT_SIZE Zeichen
+ * geteilt; der Block endet vor dem ersten Abschnitt, für den sich eine
+ * eigene Tabelle laut Entropie samt Tabellenkopf lohnt.
+ * @param block - Anfang des Speicherbereichs
+ * @param block_size - Größe des Speicherbereichs
+ * @param counts - Übergabeparameter für die Häufigkeiten des Blocks
+ * @return Anzahl der Zeichen des Blocks
+ */
+static size_t get_split_size(const unsigned char *block, size_t block_size, unsigned long long counts[]);
+
+/**
+ * Zählt die Häufigkeiten der Zeichen eines Speicherbereichs.
+ * @param block - Anfang des Speicherbereichs
+ * @param block_size - Anzahl der Zeichen
+ * @param counts - Häufigkeiten je Zeichen, werden erhöht
+ */
+static void count_block(const unsigned char *block, size_t block_size, unsigned long long counts[]);
+
+/**
+ * Liefert die Größe einer neuen Tabelle im Blockkopf in Bits.
+ * @param counts - Häufigkeiten je Zeichen
+ * @return Anzahl Bits
+ */
+static unsigned long long get_table_bits(const unsigned long long counts[]);
+
+/**
+ * Liefert die Entropie der Häufigkeiten in Bits, eine untere Schranke für
+ * die Länge jeder Huffman-Kodierung.
+ * @param counts - Häufigkeiten je Zeichen
+ * @return Anzahl Bits
+ */
+static double get_entropy_bits(const unsigned long long counts[]);
+
+/**
+ * Überträgt die Huffman-Code-Tabelle in die Tabellen der Kerne und prüft
+ * dabei die Kraft-Ungleichung, auf die sich die Dekodierung verlässt.
+ * @return COMPRESSION_EXCEPTION, falls die Codes keinen Präfixcode bilden
+ */
+static EXIT build_kernel_tables(void);
+
+/**
+ * Dekodiert gepackte Codes mit der aktuellen Huffman-Code-Tabelle. Für
+ * genügend Zeichen wird die Dekodiertabelle vorher um Einträge mit mehreren
+ * Zeichen ergänzt, die dann auch für folgende Blöcke mit derselben Tabelle
+ * gelten.
+ * @param source - gepackte Codes
+ * @param source_size - Anzahl der Bytes der gepackten Codes
+ * @param destination - Ziel
+ * @param char_count - Anzahl zu dekodierender Zeichen
+ * @return Exit-Code
+ */
+static EXIT unpack_codes(const unsigned char *source, size_t source_size, unsigned char *destination,
+                         size_t char_count);
+
+/**
+ * Kodiert einen Block mit der aktuellen Tabelle in die Ausgabedatei: die
+ * Anzahl der Bytes der gepackten Codes, dann die Codes.
+ * @param block - Zeichen des Blocks
+ * @param block_size - Anzahl der Zeichen
+ */
+static void encode_block(const unsigned char *block, size_t block_size);
+
+/**
+ * Kodiert einen Blockspeicher als einen Block aus LZ77-Sequenzen oder
+ * mit Burrows-Wheeler-Transformation, falls er damit kürzer wird als laut
+ * Entropie seiner Zeichen samt Tabelle. Die Huffman-Code-Tabelle wird
+ * dabei in jedem Fall ersetzt.
+ * @param block - Zeichen des Blockspeichers
+ * @param block_size - Anzahl der Zeichen
+ * @param plane_size - Größe der Ebenen eines aufgeteilten Blockspeichers, sonst 0
+ * @param level - Komprimierungslevel
+ * @param is_encoded - Übergabeparameter, ob der Block kodiert wurde
+ * @return Exit-Code
+ */
+static EXIT encode_transformed_block(const unsigned char *block, size_t block_size, size_t plane_size, int level,
+                                     bool *is_encoded);
+
+/**
+ * Zerlegt einen Blockspeicher in LZ77-Sequenzen und kodiert ihn so in die
+ * Ausgabedatei, falls er damit weniger Bits belegt als angegeben.
+ * @param block - Zeichen des Blockspeichers
+ * @param block_size - Anzahl der Zeichen
+ * @param level - Komprimierungslevel
+ * @param max_bits - Anzahl Bits, die unterboten werden muss
+ * @param is_encoded - Übergabeparameter, ob der Block kodiert wurde
+ * @return Exit-Code
+ */
+static EXIT encode_lz_block(const unsigned char *block, size_t block_size, int level, double max_bits,
+                            bool *is_encoded);
+
+/**
+ * Transformiert einen Blockspeicher und wählt die Tabelle für die Symbole.
+ * @param block - Zeichen des Blockspeichers
+ * @param block_size - Anzahl der Zeichen
+ * @param transform - Ziel
+ * @return Anzahl Bits der Kodierung, unendlich, falls nicht kodierbar
+ */
+static double prepare_bwt_block(const unsigned char *block, size_t block_size, BWT_BLOCK *transform);
+
+/**
+ * Kodiert einen transformierten Blockspeicher in die Ausgabedatei.
+ * @param block_size - Anzahl der Zeichen
+ * @param transform - Transformation samt Tabelle
+ * @return Exit-Code
+ */
+static EXIT write_bwt_block(size_t block_size, BWT_BLOCK *transform);
+
+/**
+ * Liefert die Ströme von LZ77-Sequenzen.
+ * @param sequences - Sequenzen
+ * @param streams - Übergabeparameter für den Anfang je Strom
+ * @param stream_sizes - Übergabeparameter für die Anzahl der Zeichen je Strom
+ */
+static void get_lz_streams(const LZ_SEQUENCES *sequences, unsigned char *streams[], size_t stream_sizes[]);
+
+/**
+ * Dekodiert einen LZ77-Block aus der Eingabedatei.
+ * @param block - Ziel
+ * @param block_size - Anzahl der Zeichen
+ * @return Exit-Code
+ */
+static EXIT decode_lz_block(unsigned char *block, size_t block_size);
+
+/**
+ * Dekodiert einen Block mit Burrows-Wheeler-Transformation aus der
+ * Eingabedatei.
+ * @param block - Ziel
+ * @param block_size - Anzahl der Zeichen
+ * @return Exit-Code
+ */
+static EXIT decode_bwt_block(unsigned char *block, size_t block_size);
+
+/**
+ * Kodiert ein Zeichen, nicht enthaltene Zeichen über das Escape-Symbol.
+ * @param next_char - zu kodierendes Zeichen
+ */
+static void encode_char(unsigned char next_char);
+
+/**
+ * Dekodiert die Blöcke der Eingabedatei. Jeder Block bringt entweder eine
+ * neue Tabelle mit oder verwendet die des vorherigen Blocks.
+ * @param destination - eingeblendete Ausgabedatei oder NULL für gepufferte Ausgabe
+ * @param char_count - Anzahl zu dekodierender Zeichen
+ * @return Exit-Code
+ */
+static EXIT decode_blocks(unsigned char *destination, unsigned long long char_count);
+
+/**
+ * Schreibt einen Blockkopf in die Ausgabedatei. Ist ein Filter angekündigt,
+ * folgen ihm der Filter und die Anzahl der Zeichen, über die er sich
+ * erstreckt; die Ankündigung ist danach erledigt.
+ * @param block_size - Anzahl der Zeichen des Blocks
+ * @param mode - Kodierung des Blocks
+ * @param is_reused - Gibt an, ob die Tabelle des vorherigen Blocks wiederverwendet wird
+ */
+static void write_block_header(size_t block_size, BLOCK_MODE mode, bool is_reused);
+
+/**
+ * Wählt für einen Blockspeicher den Filter, mit dem seine Zeichen laut
+ * Entropie samt Tabellen am wenigsten Bits belegen.
+ * @param block - Zeichen des Blockspeichers
+ * @param block_size - Anzahl der Zeichen
+ * @return Filter oder FILTER_NONE
+ */
+static unsigned int select_filter(const unsigned char *block, size_t block_size);
+
+/**
+ * Liefert die Größe des nächsten Abschnitts eines Blockspeichers, über den
+ * sich ein Block höchstens erstreckt: die Ebene, in der er beginnt, oder
+ * den Rest des Blockspeichers. Zeichen hinter der letzten Ebene gehören zu
+ * ihr.
+ * @param offset - Anfang des Abschnitts
+ * @param buffer_size - Anzahl der Zeichen des Blockspeichers
+ * @param plane_size - Größe der Ebenen, 0 für einen nicht aufgeteilten Blockspeicher
+ * @return Anzahl der Zeichen
+ */
+static size_t get_segment_size(size_t offset, size_t buffer_size, size_t plane_size);
+
+/**
+ * Liefert den Speicher des Threads für einen gefilterten Blockspeicher und
+ * reserviert ihn, falls noch nicht geschehen.
+ * @return Speicherbereich mit Platz für einen Blockspeicher
+ */
+static unsigned char *get_filter_buffer(void);
+
+/**
+ * Liefert die Anzahl der Bytes, die write_varint() für einen Wert schreibt.
+ * @param value - Wert
+ * @return Anzahl Bytes
+ */
+static unsigned int get_varint_size(unsigned long long value);
+
+/**
+ * Reserviert die Huffman-Code-Tabelle und den Blockspeicher des Threads,
+ * falls noch nicht geschehen. Der Speicher wird für alle weiteren Dateien
+ * des Threads wiederverwendet.
+ */
+static void init_codec(void);
+
+/**
+ * Reserviert die Kodier- und Dekodiertabellen des Threads, falls noch nicht
+ * geschehen. Der Thread beschreibt sie selbst zuerst, so liegen sie auf dem
+ * NUMA-Knoten, an den er gebunden ist.
+ */
+static void init_code_tables(void);
+
+/**
+ * Gibt den Code der zuletzt bearbeiteten Datei frei und schließt Ein- und
+ * Ausgabedatei.
+ */
+static void release_codec(void);
+
+/**
+ * Bestimmt die Angaben zu allen Teilen der geöffneten Eingabedatei.
+ * @param level - Komprimierungslevel
+ * @param plan - Übergabeparameter für die Angaben
+ * @return Wahrheitswert, ob eine Stichprobe genommen wurde; die
+ *         Leseposition steht dann an beliebiger Stelle
+ */
+static bool plan_infile(int level, COMPRESS_PLAN *plan);
+
+/**
+ * Kodiert Zeichen ab der Leseposition der Eingabedatei in Blöcken in die
+ * Ausgabe. Ab Offset 0 wird zuerst der Dateikopf geschrieben.
+ * @param plan - Angaben zu allen Teilen der Eingabedatei
+ * @param offset - Offset der Leseposition in der Eingabedatei
+ * @param size - Anzahl der zu kodierenden Zeichen
+ * @param level - Komprimierungslevel
+ * @return Exit-Code
+ */
+static EXIT encode_range(const COMPRESS_PLAN *plan, unsigned long long offset, unsigned long long size, int level);
+
+extern EXIT compress(char *in_filename, char *out_filename, int level)
+{
+    COMPRESS_PLAN plan;
+    EXIT exit;
+
+    init_codec();
+    is_ans_table = false;
+    pending_filter = FILTER_NONE;
+
+    if (open_infile(in_filename) != SUCCESS || open_outfile(out_filename) != SUCCESS)
+    {
+        release_codec();
+        return IO_EXCEPTION;
+    }
+
+    if (plan_infile(level, &plan))
+    {
+        seek_infile(0);
+    }
+    exit = encode_range(&plan, 0, plan.in_size, level);
+
+    release_codec();
+
+    return exit;
+}
+
+extern EXIT plan_compression(char *in_filename, int level, COMPRESS_PLAN *plan)
+{
+    init_codec();
+
+    if (open_infile(in_filename) != SUCCESS)
+    {
+        return IO_EXCEPTION;
+    }
+    plan_infile(level, plan);
+    close_infile();
+
+    return SUCCESS;
+}
+
+extern EXIT compress_part(char *in_filename, const COMPRESS_PLAN *plan, unsigned long long offset,
+                          unsigned long long size, int level, unsigned char **data, size_t *data_size)
+{
+    EXIT exit = IO_EXCEPTION;
+
+    init_codec();
+    is_ans_table = false;
+    pending_filter = FILTER_NONE;
+
+    // the infile must not have changed since the plan, else the parts would not fit together
+    if (open_infile(in_filename) == SUCCESS && get_infile_size() == plan->in_size
+        && seek_infile(offset) == SUCCESS && open_outfile_memory() == SUCCESS)
+    {
+        exit = encode_range(plan, offset, size, level);
+    }
+
+    release_code_table();
+    close_infile();
+    close_outfile_memory(data, data_size);
+    if (exit != SUCCESS)
+    {
+        free(*data);
+        *data = NULL;
+        *data_size = 0;
+    }
+
+    return exit;
+}
+
+static bool plan_infile(int level, COMPRESS_PLAN *plan)
+{
+    plan->in_size = get_infile_size();
+    memset(plan->fixed_counts, 0, sizeof(plan->fixed_counts));
+    plan->escape_count = 0;
+
+    // a given table needs neither counting nor sampling
+    if (has_codec_table)
+    {
+        plan->is_fixed = true;
+        memcpy(plan->fixed_counts, codec_table_counts, sizeof(plan->fixed_counts));
+        plan->escape_count = codec_table_escape_count;
+        return false;
+    }
+
+    // large file at a low level: one table from a sample for all blocks, unless matches are searched or chars filtered
+    plan->is_fixed = codec_window_size == 0 && codec_filter == FILTER_NONE && level <= SAMPLE_MAX_LEVEL
+                       && plan->in_size > (unsigned long long) SAMPLE_CHUNKS * SAMPLE_CHUNK_SIZE;
+    if (plan->is_fixed)
+    {
+        plan->escape_count = sample_frequencies(plan->fixed_counts, plan->in_size);
+    }
+    return plan->is_fixed;
+}
+
+static EXIT encode_range(const COMPRESS_PLAN *plan, unsigned long long offset, unsigned long long size, int level)
+{
+    unsigned long long counts[NUM_OF_SYMBOLS] = {0};
+    unsigned long long table_counts[NUM_OF_SYMBOLS];
+    bool has_table = false;
+    bool is_given = plan->is_fixed;
+    EXIT exit = SUCCESS;
+
+    memcpy(table_counts, plan->fixed_counts, sizeof(table_counts));
+
+    if (offset == 0)
+    {
+        // write file identification, format version and size
+        write_char(MAGIC[0]);
+        write_char(MAGIC[1]);
+        write_char(FORMAT_VERSION);
+        write_varint(plan->in_size);
+    }
+    else if (plan->is_fixed && !has_codec_table)
+    {
+        // the last block of the part before ends with the same table
+        exit = build_code_table(table_counts, plan->escape_count);
+        has_table = true;
+    }
+
+    // the blocks are read in order, possibly by a stage of their own
+    stream_infile(size);
+
+    for (unsigned long long remaining = size; remaining > 0 && exit == SUCCESS;)
+    {
+        size_t buffer_size = remaining < codec_block_size ? (size_t) remaining : codec_block_size;
+        unsigned char *buffer = block_buffer;
+        unsigned int filter;
+        size_t plane_size = 0;
+
+        if (read_chars(block_buffer, buffer_size) != buffer_size)
+        {
+            // infile got shorter since its size was written
+            exit = IO_EXCEPTION;
+            break;
+        }
+        remaining -= buffer_size;
+
+        // the next buffer is read from disk while this one is counted and encoded in cache
+        prefetch_infile(remaining < codec_block_size ? remaining : codec_block_size);
+
+        // filter the buffer into its own memory, the header of its first block announces the filter
+        filter = codec_filter == FILTER_AUTO ? select_filter(block_buffer, buffer_size) : codec_filter;
+        if (filter != FILTER_NONE)
+        {
+            buffer = get_filter_buffer();
+            get_kernels()->filter(block_buffer, buffer_size, filter, buffer);
+            if (filter & FILTER_SHUFFLE)
+            {
+                plane_size = buffer_size >> (filter & FILTER_LANE_MASK);
+            }
+            pending_filter = filter;
+            pending_filter_size = buffer_size;
+        }
+
+        // the whole buffer as one block of sequences or transformed, if that is shorter, unless the table is fixed
+        if ((codec_window_size > 0 || level >= BWT_MIN_LEVEL) && !plan->is_fixed)
+        {
+            bool is_encoded;
+
+            exit = encode_transformed_block(buffer, buffer_size, plane_size, level, &is_encoded);
+            if (exit != SUCCESS || is_encoded)
+            {
+                // no table is left behind for the next block
+                has_table = false;
+                is_ans_table = false;
+                continue;
+            }
+
+            // the current huffman table was replaced while sizing the block
+            if (has_table && !is_ans_table)
+            {
+                exit = build_code_table(table_counts, 0);
+            }
+        }
+
+        for (size_t block_offset = 0; block_offset < buffer_size && exit == SUCCESS;)
+        {
+            size_t block_size = get_segment_size(block_offset, buffer_size, plane_size);
+            bool is_reused = has_table;
+
+            if (!plan->is_fixed)
+            {
+                // at high levels, end the block where the distribution shifts
+                if (level >= SPLIT_MIN_LEVEL)
+                {
+                    block_size = get_split_size(buffer + block_offset, block_size, counts);
+                }
+                else
+                {
+                    memset(counts, 0, sizeof(counts));
+                    count_block(buffer + block_offset, block_size, counts);
+                }
+                exit = select_code_table(counts, table_counts, has_table, level >= ANS_MIN_LEVEL, &is_reused);
+            }
+            else if (has_codec_table)
+            {
+                // a given table may not fit the block at all, the block is in memory to check that
+                memset(counts, 0, sizeof(counts));
+                count_block(buffer + block_offset, block_size, counts);
+                exit = select_given_table(plan, counts, table_counts, has_table, level >= ANS_MIN_LEVEL, &is_reused,
+                                          &is_given);
+            }
+            else if (!has_table)
+            {
+                exit = build_code_table(table_counts, plan->escape_count);
+            }
+
+            write_block_header(block_size, is_ans_table ? BLOCK_ANS : BLOCK_HUFFMAN, is_reused);
+            if (!is_reused)
+            {
+                write_frequencies(table_counts);
+                write_varint(is_given ? plan->escape_count : 0);
+            }
+            has_table = true;
+
+            encode_block(buffer + block_offset, block_size);
+            block_offset += block_size;
+        }
+    }
+
+
+    return exit;
+}
+
+extern EXIT analyze(char *in_filename, int level, FILE_ANALYSIS *analysis)
+{
+    unsigned long long counts[NUM_OF_SYMBOLS];
+    unsigned long long table_counts[NUM_OF_SYMBOLS] = {0};
+    unsigned long long file_counts[NUM_OF_SYMBOLS] = {0};
+    unsigned long long code_bits = 0;
+    double entropy_sum = 0;
+    double squared_entropy_sum = 0;
+    bool has_table = false;
+    EXIT exit = SUCCESS;
+
+    init_codec();
+    is_ans_table = false;
+    memset(analysis, 0, sizeof(*analysis));
+
+    if (open_infile(in_filename) != SUCCESS)
+    {
+        release_codec();
+        return IO_EXCEPTION;
+    }
+
+    // file identification, format version and size
+    analysis->char_count = get_infile_size();
+    analysis->huffman_size = 3 + get_varint_size(analysis->char_count);
+    analysis->min_block_entropy = analysis->char_count > 0 ? 8 : 0;
+
+    for (unsigned long long remaining = analysis->char_count; remaining > 0 && exit == SUCCESS;)
+    {
+        size_t buffer_size = remaining < codec_block_size ? (size_t) remaining : codec_block_size;
+
+        if (read_chars(block_buffer, buffer_size) != buffer_size)
+        {
+            exit = IO_EXCEPTION;
+            break;
+        }
+        remaining -= buffer_size;
+
+        for (size_t offset = 0; offset < buffer_size && exit == SUCCESS;)
+        {
+            size_t block_size = buffer_size - offset;
+            unsigned long long bit_count = 0;
+            double entropy;
+            bool is_reused;
+
+            if (level >= SPLIT_MIN_LEVEL)
+            {
+                block_size = get_split_size(block_buffer + offset, block_size, counts);
+            }
+            else
+            {
+                memset(counts, 0, sizeof(counts));
+                count_block(block_buffer + offset, block_size, counts);
+            }
+
+            // tANS sizes are only estimated, so the analysis sticks to huffman codes
+            exit = select_code_table(counts, table_counts, has_table, false, &is_reused);
+            has_table = true;
+            for (int i = 0; i < NUM_OF_SYMBOLS; i++)
+            {
+                bit_count += counts[i] * code_lengths[i];
+                file_counts[i] += counts[i];
+            }
+
+            // block header, the table unless reused, packed size and packed codes
+            analysis->huffman_size += get_varint_size((unsigned long long) block_size << BLOCK_HEADER_BITS | is_reused)
+                                      + (is_reused ? 0 : get_table_bits(table_counts) / 8)
+                                      + get_varint_size((bit_count + 7) / 8) + (bit_count + 7) / 8;
+            code_bits += bit_count;
+
+            entropy = get_entropy_bits(counts) / (double) block_size;
+            entropy_sum += entropy * (double) block_size;
+            squared_entropy_sum += entropy * entropy * (double) block_size;
+            if (entropy < analysis->min_block_entropy)
+            {
+                analysis->min_block_entropy = entropy;
+            }
+            if (entropy > analysis->max_block_entropy)
+            {
+                analysis->max_block_entropy = entropy;
+            }
+            analysis->block_count++;
+            analysis->reused_count += is_reused;
+            offset += block_size;
+        }
+    }
+
+    if (analysis->char_count > 0)
+    {
+        double mean = entropy_sum / (double) analysis->char_count;
+        double variance = squared_entropy_sum / (double) analysis->char_count - mean * mean;
+
+        analysis->entropy = get_entropy_bits(file_counts) / (double) analysis->char_count;
+        analysis->average_code_length = (double) code_bits / (double) analysis->char_count;
+        analysis->block_entropy_deviation = variance > 0 ? sqrt(variance) : 0;
+    }
+
+    release_codec();
+
+    return exit;
+}
+
+extern EXIT decompress(char *in_filename, char *out_filename)
+{
+    unsigned long long char_count;
+    unsigned char *destination;
+    bool is_mapped;
+    EXIT exit;
+
+    init_codec();
+    is_ans_table = false;
+
+    if (open_infile(in_filename) != SUCCESS)
+    {
+        release_codec();
+        return IO_EXCEPTION;
+    }
+
+    // check file identification and format version
+    if (!has_next_char() || read_char() != MAGIC[0]
+        || !has_next_char() || read_char() != MAGIC[1]
+        || !has_next_char() || read_char() != FORMAT_VERSION)
+    {
+        release_codec();
+        return COMPRESSION_EXCEPTION;
+    }
+    char_count = read_varint();
+    if (has_varint_error())
+    {
+        release_codec();
+        return COMPRESSION_EXCEPTION;
+    }
+
+    // decode directly into the preallocated and mapped outfile, if possible
+    is_mapped = open_outfile_mapped(out_filename, char_count, &destination) == SUCCESS;
+    if (!is_mapped && open_outfile(out_filename) != SUCCESS)
+    {
+        release_codec();
+        return IO_EXCEPTION;
+    }
+
+    exit = decode_blocks(is_mapped ? destination : NULL, char_count);
+
+    // a broken file must not leave an outfile of the size its header claims
+    if (exit != SUCCESS)
+    {
+        discard_outfile_mapped();
+    }
+    close_outfile_mapped();
+    release_codec();
+
+    return exit;
+}
+
+extern void count_frequencies(unsigned long long counts[], unsigned int *crc)
+{
+    const unsigned char *data;
+    unsigned long long size;
+
+    // count straight from the page cache, unless memory is bounded: the mapped pages would stay resident
+    if (!is_codec_bounded && map_infile_rest(&data, &size) == SUCCESS)
+    {
+        count_mapped(data, size, counts, crc);
+        unmap_infile();
+        return;
+    }
+
+    while (has_next_char())
+    {
+        unsigned char next_char = read_char();
+        counts[next_char]++;
+        if (crc != NULL)
+        {
+            *crc = checksum_update_char(*crc, next_char);
+        }
+    }
+}
+
+extern void write_frequencies(const unsigned long long counts[])
+{
+    unsigned int symbol_count = 0;
+
+    for (int i = 0; i < NUM_OF_SYMBOLS; i++)
+    {
+        symbol_count += counts[i] > 0;
+    }
+
+    // write number of frequencies
+    write_varint(symbol_count);
+
+    // write the frequencies' character and count
+    for (int i = 0; i < NUM_OF_SYMBOLS; i++)
+    {
+        if (counts[i] > 0)
+        {
+            write_char((unsigned char) i);
+            write_varint(counts[i]);
+        }
+    }
+}
+
+extern EXIT read_frequencies(unsigned long long counts[], unsigned long long *char_count)
+{
+    unsigned long long sum = 0;
+    unsigned long long symbol_count = read_varint();
+    int previous = -1;
+
+    memset(counts, 0, sizeof(unsigned long long) * NUM_OF_SYMBOLS);
+    if (symbol_count > NUM_OF_SYMBOLS)
+    {
+        return COMPRESSION_EXCEPTION;
+    }
+
+    for (unsigned int i = 0; i < symbol_count; i++)
+    {
+        unsigned char character;
+
+        if (!has_next_char())
+        {
+            return COMPRESSION_EXCEPTION;
+        }
+        character = read_char();
+        counts[character] = read_varint();
+
+        // chars are written in ascending order, which also rules out duplicates
+        if ((int) character <= previous || counts[character] == 0 || counts[character] > MAX_TABLE_COUNT - sum)
+        {
+            return COMPRESSION_EXCEPTION;
+        }
+        previous = character;
+        sum += counts[character];
+    }
+
+    if (has_varint_error())
+    {
+        return COMPRESSION_EXCEPTION;
+    }
+    if (char_count != NULL)
+    {
+        *char_count = sum;
+    }
+    return SUCCESS;
+}
+
+extern EXIT build_code_table(const unsigned long long counts[], unsigned long long escape_count)
+{
+    init_code_tables();
+    release_code_table();
+    memset(code_lengths, 0, sizeof(code_lengths));
+
+    TREE_ELEMENT elements[NUM_OF_SYMBOLS + 1];
+    TREE_HEAP heap;
+    TREE_ELEMENT min_element1;
+    TREE_ELEMENT min_element2;
+    char code[NUM_OF_SYMBOLS + 2];
+
+    // fill heap with btrees of frequencies at once
+    TREE_HEAP_init(&heap, elements, NUM_OF_SYMBOLS + 1);
+    for (unsigned int i = 0; i <= NUM_OF_SYMBOLS; i++)
+    {
+        unsigned long long count = i == ESCAPE_SYMBOL ? escape_count : counts[i];
+        if (count > 0)
+        {
+            frequencies[freq_filling_level] = frequency_create(i, (long long) count);
+            elements[freq_filling_level].count = (long long) count;
+            elements[freq_filling_level].tree = btree_new(frequencies[freq_filling_level], (DESTROY_DATA_FCT) frequency_destroy, (PRINT_DATA_FCT) frequency_print);
+            freq_filling_level++;
+        }
+    }
+    TREE_HEAP_build(&heap, (int) freq_filling_level);
+
+    while (TREE_HEAP_extract_min(&heap, &min_element1) && TREE_HEAP_extract_min(&heap, &min_element2))
+    {
+        // merge minimal trees and insert merged tree back in the heap
+        TREE_ELEMENT merged = {
+                .count = min_element1.count + min_element2.count,
+                .tree = btree_merge(min_element1.tree, min_element2.tree,
+                                    frequency_create('\0', min_element1.count + min_element2.count))
+        };
+        TREE_HEAP_insert(&heap, merged);
+    }
+    optimal_tree = freq_filling_level > 0 ? min_element1.tree : NULL;
+
+    // fill code table with codes, an empty file has no codes
+    if (freq_filling_level > 0 && get_code_table(btree_get_root(optimal_tree), code, 0) == COMPRESSION_EXCEPTION)
+    {
+        return COMPRESSION_EXCEPTION;
+    }
+    return build_kernel_tables();
+}
+
+extern void encode_infile(void)
+{
+    while (has_next_char())
+    {
+        encode_char(read_char());
+    }
+}
+
+extern EXIT decode_file(char *out_filename, unsigned long long char_count, unsigned int *crc)
+{
+    unsigned char *destination;
+    EXIT exit;
+
+    // the decoded size is known, so decode directly into the preallocated and mapped outfile,
+    // unless memory is bounded: the mapped pages would stay resident until the end
+    if (!is_codec_bounded && open_outfile_mapped(out_filename, char_count, &destination) == SUCCESS)
+    {
+        exit = decode_memory(destination, char_count, crc);
+        if (exit != SUCCESS)
+        {
+            discard_outfile_mapped();
+        }
+        close_outfile_mapped();
+        return exit;
+    }
+
+    // fall back to buffered output, e.g. for pipes
+    if (open_outfile(out_filename) != SUCCESS)
+    {
+        return IO_EXCEPTION;
+    }
+    exit = decode_outfile(char_count, crc);
+    close_outfile();
+    return exit;
+}
+
+extern EXIT decode_memory(unsigned char *destination, unsigned long long char_count, unsigned int *crc)
+{
+    for (unsigned long long i = 0; i < char_count; i++)
+    {
+        int character = decode_char();
+        if (character == -1)
+        {
+            // infile ended before all characters were decoded
+            return COMPRESSION_EXCEPTION;
+        }
+        destination[i] = (unsigned char) character;
+    }
+
+    if (crc != NULL)
+    {
+        *crc = checksum_update(*crc, destination, (size_t) char_count);
+    }
+    return SUCCESS;
+}
+
+extern EXIT decode_outfile(unsigned long long char_count, unsigned int *crc)
+{
+    for (; char_count > 0; char_count--)
+    {
+        int character = decode_char();
+        if (character == -1)
+        {
+            // infile ended before all characters were decoded
+            return COMPRESSION_EXCEPTION;
+        }
+
+        write_char((unsigned char) character);
+        if (crc != NULL)
+        {
+            *crc = checksum_update_char(*crc, (unsigned char) character);
+        }
+    }
+    return SUCCESS;
+}
+
+extern void set_codec_memory(size_t block_size, bool is_bounded)
+{
+    codec_block_size = block_size;
+    is_codec_bounded = is_bounded;
+}
+
+extern void set_codec_window(size_t window_size)
+{
+    codec_window_size = window_size;
+}
+
+extern void set_codec_filter(unsigned int filter)
+{
+    codec_filter = filter;
+}
+
+extern EXIT set_codec_table(char *table_filename)
+{
+    unsigned long long table_count = 0;
+    unsigned int symbol_count = 0;
+    EXIT exit = COMPRESSION_EXCEPTION;
+
+    if (open_infile(table_filename) != SUCCESS)
+    {
+        release_codec();
+        return IO_EXCEPTION;
+    }
+
+    // the first block always brings its own table, unless it is one of sequences or transformed
+    if (has_next_char() && read_char() == MAGIC[0]
+        && has_next_char() && read_char() == MAGIC[1]
+        && has_next_char() && read_char() == FORMAT_VERSION)
+    {
+        unsigned long long char_count = read_varint();
+        unsigned long long block_header = char_count > 0 ? read_varint() : 0;
+        BLOCK_MODE mode = (BLOCK_MODE) (block_header >> 1 & ((1u << BLOCK_MODE_BITS) - 1));
+
+        // a filtered block's table fits the filtered chars only
+        if (!has_varint_error() && char_count > 0 && !(block_header & (BLOCK_FILTERED | 1))
+            && (mode == BLOCK_HUFFMAN || mode == BLOCK_ANS)
+            && read_frequencies(codec_table_counts, &table_count) == SUCCESS)
+        {
+            codec_table_escape_count = read_varint();
+            if (!has_varint_error() && codec_table_escape_count <= MAX_TABLE_COUNT - table_count)
+            {
+                exit = SUCCESS;
+            }
+        }
+    }
+    release_codec();
+
+    if (exit != SUCCESS)
+    {
+        return exit;
+    }
+
+    // chars missing in the table are escaped, about once in 65536 chars like with a sample
+    for (int i = 0; i < NUM_OF_SYMBOLS; i++)
+    {
+        symbol_count += codec_table_counts[i] > 0;
+    }
+    if (symbol_count < NUM_OF_SYMBOLS && codec_table_escape_count == 0)
+    {
+        codec_table_escape_count = table_count >> 16 > 0 ? table_count >> 16 : 1;
+    }
+    has_codec_table = true;
+
+    return SUCCESS;
+}
+
+extern unsigned long long get_codec_memory(size_t block_size, int level)
+{
+    // any file may hold filtered blocks, blocks of sequences or transformed blocks,
+    // but only encoding them needs the search structures
+    return 2 * (unsigned long long) block_size + get_packed_bound(block_size) + CODEC_THREAD_MEMORY
+           + lz_get_memory(block_size, level > 0 && codec_window_size > 0)
+           + bwt_get_memory(block_size, level >= BWT_MIN_LEVEL) + get_io_memory();
+}
+
+extern void free_codec(void)
+{
+    release_code_table();
+    free(huffman_code_table);
+    huffman_code_table = NULL;
+    huff_size = 0;
+    free(block_buffer);
+    block_buffer = NULL;
+    free(packed_buffer);
+    packed_buffer = NULL;
+    free(filter_buffer);
+    filter_buffer = NULL;
+    free(encode_table);
+    encode_table = NULL;
+    free(decode_table);
+    decode_table = NULL;
+    free(ans_encode_table);
+    ans_encode_table = NULL;
+    free(ans_decode_table);
+    ans_decode_table = NULL;
+    lz_free();
+    bwt_free();
+    free_io();
+}
+
+extern void release_code_table(void)
+{
+    // the tree's leaves hold the frequencies, so destroying it frees them as well
+    btree_destroy(&optimal_tree, true);
+    freq_filling_level = 0;
+
+    for (int i = 0; i < huff_filling_level; i++)
+    {
+        huffman_code_destroy(*(huffman_code_table + i));
+    }
+    huff_filling_level = 0;
+}
+
+static void init_codec(void)
+{
+    if (huffman_code_table == NULL)
+    {
+        huff_size = NUM_OF_ELEMENTS;
+        huffman_code_table = (HUFFMAN_CODE **) malloc(sizeof(HUFFMAN_CODE *) * (size_t) huff_size);
+    }
+    if (block_buffer == NULL)
+    {
+        block_buffer = (unsigned char *) malloc(codec_block_size);
+        packed_buffer = (unsigned char *) malloc(get_packed_bound(codec_block_size));
+    }
+    if (huffman_code_table == NULL || block_buffer == NULL || packed_buffer == NULL)
+    {
+        printf("Fehler bei der Speicherreservierung.");
+        exit(1);
+    }
+    init_code_tables();
+}
+
+static void init_code_tables(void)
+{
+    if (encode_table != NULL)
+    {
+        return;
+    }
+
+    encode_table = (ENCODE_TABLE *) malloc(sizeof(ENCODE_TABLE));
+    decode_table = (DECODE_TABLE *) malloc(sizeof(DECODE_TABLE));
+    ans_encode_table = (ANS_ENCODE_TABLE *) malloc(sizeof(ANS_ENCODE_TABLE));
+    ans_decode_table = (ANS_DECODE_TABLE *) malloc(sizeof(ANS_DECODE_TABLE));
+    if (encode_table == NULL || decode_table == NULL || ans_encode_table == NULL || ans_decode_table == NULL)
+    {
+        printf("Fehler bei der Speicherreservierung.");
+        exit(1);
+    }
+
+    // touch every page here, static tls would be zeroed by the thread that created this one
+    memset(encode_table, 0, sizeof(ENCODE_TABLE));
+    memset(decode_table, 0, sizeof(DECODE_TABLE));
+    memset(ans_encode_table, 0, sizeof(ANS_ENCODE_TABLE));
+    memset(ans_decode_table, 0, sizeof(ANS_DECODE_TABLE));
+}
+
+static void release_codec(void)
+{
+    release_code_table();
+    close_infile();
+    close_outfile();
+}
+
+static void count_mapped(const unsigned char *data, unsigned long long size, unsigned long long counts[],
+                         unsigned int *crc)
+{
+    COUNT_RANGE ranges[COUNT_MAX_THREADS];
+    pthread_t workers[COUNT_MAX_THREADS];
+    long processors = sysconf(_SC_NPROCESSORS_ONLN);
+    unsigned long long range_count = size / COUNT_MIN_RANGE_SIZE;
+    unsigned long long offset = 0;
+    int started = 1;
+
+    if (range_count > (unsigned long long) processors)
+    {
+        range_count = processors > 0 ? (unsigned long long) processors : 1;
+    }
+    if (range_count > COUNT_MAX_THREADS)
+    {
+        range_count = COUNT_MAX_THREADS;
+    }
+    if (range_count == 0)
+    {
+        range_count = 1;
+    }
+
+    for (unsigned long long i = 0; i < range_count; i++)
+    {
+        unsigned long long end = size / range_count * (i + 1) + (i + 1 == range_count ? size % range_count : 0);
+
+        ranges[i].data = data + offset;
+        ranges[i].size = (size_t) (end - offset);
+        ranges[i].has_crc = crc != NULL;
+        offset = end;
+    }
+
+    // the first range is counted here, if a thread cannot be started, its range as well
+    while (started < (int) range_count && pthread_create(workers + started, NULL, count_range, ranges + started) == 0)
+    {
+        started++;
+    }
+    count_range(ranges);
+    for (int i = started; i < (int) range_count; i++)
+    {
+        count_range(ranges + i);
+    }
+
+    for (int i = 0; i < (int) range_count; i++)
+    {
+        if (i > 0 && i < started)
+        {
+            pthread_join(workers[i], NULL);
+        }
+        for (int c = 0; c < NUM_OF_SYMBOLS; c++)
+        {
+            counts[c] += ranges[i].counts[c];
+        }
+        if (crc != NULL)
+        {
+            *crc = checksum_combine(*crc, ranges[i].crc, ranges[i].size);
+        }
+    }
+}
+
+static void *count_range(void *range)
+{
+    COUNT_RANGE *part = (COUNT_RANGE *) range;
+
+    memset(part->counts, 0, sizeof(part->counts));
+    get_kernels()->histogram(part->data, part->size, part->counts);
+    if (part->has_crc)
+    {
+        part->crc = checksum_update(CHECKSUM_INIT, part->data, part->size);
+    }
+    return NULL;
+}
+
+static int decode_char(void)
+{
+    char code[NUM_OF_SYMBOLS + 2];
+    unsigned int length = 0;
+    int index;
+    while (length <= NUM_OF_SYMBOLS && has_next_bit())
+    {
+        // get bit and add to code
+        code[length++] = read_bit() == BIT0 ? '0' : '1';
+        code[length] = '\0';
+
+        index = get_code_table_index_by_code(code);
+        if (index != -1)
+        {
+            // get code's char
+            unsigned int character = huffman_code_get_character(*(huffman_code_table + index));
+
+            if (character == ESCAPE_SYMBOL)
+            {
+                // escaped char follows as plain bits
+                character = 0;
+                for (int i = 0; i < 8; i++)
+                {
+                    if (!has_next_bit())
+                    {
+                        return -1;
+                    }
+                    character = (character << 1) | (read_bit() == BIT1);
+                }
+            }
+            return (int) character;
+        }
+    }
+    return -1;
+}
+
+static EXIT select_code_table(const unsigned long long counts[], unsigned long long table_counts[], bool has_table,
+                              bool is_ans_allowed, bool *is_reused)
+{
+    unsigned short normalized[NUM_OF_SYMBOLS];
+    double reuse_bits = HUGE_VAL;
+    double huffman_bits;
+    double ans_bits = HUGE_VAL;
+    double table_bits = (double) get_table_bits(counts);
+
+    // a char missing in the current table rules out reusing it
+    if (has_table)
+    {
+        reuse_bits = is_ans_table ? ans_get_bits(counts, ans_normalized) * ANS_COST_FACTOR : get_huffman_bits(counts);
+    }
+
+    // no code beats the entropy, so a cheap enough current table needs no new one
+    *is_reused = reuse_bits <= get_entropy_bits(counts) + table_bits;
+    if (*is_reused)
+    {
+        return SUCCESS;
+    }
+
+    if (build_code_table(counts, 0) != SUCCESS)
+    {
+        return COMPRESSION_EXCEPTION;
+    }
+    huffman_bits = get_huffman_bits(counts);
+    if (is_ans_allowed && ans_normalize(counts, normalized) == SUCCESS)
+    {
+        ans_bits = ans_get_bits(counts, normalized) * ANS_COST_FACTOR;
+    }
+
+    *is_reused = reuse_bits <= (ans_bits < huffman_bits ? ans_bits : huffman_bits) + table_bits;
+    if (*is_reused)
+    {
+        // the current table still wins, a huffman table has to be built again
+        return is_ans_table ? SUCCESS : build_code_table(table_counts, 0);
+    }
+
+    is_ans_table = ans_bits < huffman_bits;
+    if (is_ans_table)
+    {
+        memcpy(ans_normalized, normalized, sizeof(ans_normalized));
+        ans_build_encode_table(ans_normalized, ans_encode_table);
+    }
+    memcpy(table_counts, counts, sizeof(unsigned long long) * NUM_OF_SYMBOLS);
+    return SUCCESS;
+}
+
+static EXIT select_given_table(const COMPRESS_PLAN *plan, const unsigned long long counts[],
+                               unsigned long long table_counts[], bool has_table, bool is_ans_allowed,
+                               bool *is_reused, bool *is_given)
+{
+    bool was_given = has_table && *is_given;
+    double given_bits = was_given ? 0 : (double) get_table_bits(plan->fixed_counts);
+    double own_bits;
+
+    // the first block of a range builds the given table, its lengths price all blocks after
+    if (!has_table)
+    {
+        if (build_code_table(plan->fixed_counts, plan->escape_count) != SUCCESS)
+        {
+            return COMPRESSION_EXCEPTION;
+        }
+        memcpy(given_code_lengths, code_lengths, sizeof(given_code_lengths));
+    }
+    for (int i = 0; i < NUM_OF_SYMBOLS; i++)
+    {
+        if (counts[i] > 0)
+        {
+            // a missing char costs the escape code and the char itself
+            unsigned int length = given_code_lengths[i] > 0 ? given_code_lengths[i]
+                                  : given_code_lengths[ESCAPE_SYMBOL] > 0 ? given_code_lengths[ESCAPE_SYMBOL] + 8u : 0;
+            given_bits += length > 0 ? (double) (counts[i] * length) : HUGE_VAL;
+        }
+    }
+
+    // an own table of the current block may be reused, the given one is no candidate there
+    if (select_code_table(counts, table_counts, has_table && !was_given, is_ans_allowed, is_reused) != SUCCESS)
+    {
+        return COMPRESSION_EXCEPTION;
+    }
+    own_bits = is_ans_table ? ans_get_bits(counts, ans_normalized) * ANS_COST_FACTOR : get_huffman_bits(counts);
+    if (!*is_reused)
+    {
+        own_bits += (double) get_table_bits(counts);
+    }
+
+    *is_given = given_bits <= own_bits;
+    if (!*is_given)
+    {
+        return SUCCESS;
+    }
+
+    // back to the given table, written again unless it was the current one
+    *is_reused = was_given;
+    is_ans_table = false;
+    memcpy(table_counts, plan->fixed_counts, sizeof(unsigned long long) * NUM_OF_SYMBOLS);
+    return build_code_table(plan->fixed_counts, plan->escape_count);
+}
+
+static double get_huffman_bits(const unsigned long long counts[])
+{
+    double bits = 0;
+
+    for (int i = 0; i < NUM_OF_SYMBOLS; i++)
+    {
+        if (counts[i] > 0)
+        {
+            if (code_lengths[i] == 0)
+            {
+                return HUGE_VAL;
+            }
+            bits += (double) (counts[i] * code_lengths[i]);
+        }
+    }
+    return bits;
+}
+
+static size_t get_split_size(const unsigned char *block, size_t block_size, unsigned long long counts[])
+{
+    unsigned long long segment_counts[NUM_OF_SYMBOLS];
+    unsigned long long joined_counts[NUM_OF_SYMBOLS];
+    size_t split_size = 0;
+
+    memset(counts, 0, sizeof(unsigned long long) * NUM_OF_SYMBOLS);
+    while (split_size < block_size)
+    {
+        size_t segment_size = block_size - split_size < SPLIT_SEGMENT_SIZE ? block_size - split_size : SPLIT_SEGMENT_SIZE;
+
+        memset(segment_counts, 0, sizeof(segment_counts));
+        count_block(block + split_size, segment_size, segment_counts);
+
+        if (split_size > 0)
+        {
+            // split if two tables (the second with its header) beat one shared table
+            for (int i = 0; i < NUM_OF_SYMBOLS; i++)
+            {
+                joined_counts[i] = counts[i] + segment_counts[i];
+            }
+            if (get_entropy_bits(counts) + get_entropy_bits(segment_counts) + (double) get_table_bits(segment_counts)
+                < get_entropy_bits(joined_counts))
+            {
+                break;
+            }
+        }
+
+        for (int i = 0; i < NUM_OF_SYMBOLS; i++)
+        {
+            counts[i] += segment_counts[i];
+        }
+        split_size += segment_size;
+    }
+    return split_size;
+}
+
+static void count_block(const unsigned char *block, size_t block_size, unsigned long long counts[])
+{
+    get_kernels()->histogram(block, block_size, counts);
+}
+
+static unsigned long long get_table_bits(const unsigned long long counts[])
+{
+    unsigned int symbol_count = 0;
+    unsigned long long table_size = 0;
+
+    // frequencies and escape count as written by compress()
+    for (int i = 0; i < NUM_OF_SYMBOLS; i++)
+    {
+        if (counts[i] > 0)
+        {
+            symbol_count++;
+            table_size += 1 + get_varint_size(counts[i]);
+        }
+    }
+    table_size += get_varint_size(symbol_count) + 1;
+    return table_size * 8;
+}
+
+static double get_entropy_bits(const unsigned long long counts[])
+{
+    unsigned long long char_count = 0;
+    double entropy_bits = 0;
+
+    for (int i = 0; i < NUM_OF_SYMBOLS; i++)
+    {
+        char_count += counts[i];
+    }
+    for (int i = 0; i < NUM_OF_SYMBOLS; i++)
+    {
+        if (counts[i] > 0)
+        {
+            entropy_bits += (double) counts[i] * log2((double) char_count / (double) counts[i]);
+        }
+    }
+    return entropy_bits;
+}
+
+static EXIT build_kernel_tables(void)
+{
+    unsigned int escape_code = 0;
+    unsigned int escape_length = code_lengths[ESCAPE_SYMBOL];
+    unsigned long long kraft_sum = 0;
+
+    memset(encode_table->lengths, 0, sizeof(encode_table->lengths));
+    memset(decode_table->entries, 0, sizeof(decode_table->entries));
+    decode_table->long_count = 0;
+    decode_table->has_multi_entries = false;
+    has_kernel_tables = escape_length == 0 || escape_length + 8 <= KERNEL_MAX_CODE_LENGTH;
+
+    for (unsigned int i = 0; i < huff_filling_level && has_kernel_tables; i++)
+    {
+        unsigned int symbol = huffman_code_get_character(huffman_code_table[i]);
+        char *code = huffman_code_get_code(huffman_code_table[i]);
+        unsigned int length = (unsigned int) strlen(code);
+        unsigned int value = 0;
+
+        if (length > KERNEL_MAX_CODE_LENGTH)
+        {
+            has_kernel_tables = false;
+            break;
+        }
+        for (unsigned int j = 0; j < length; j++)
+        {
+            value = value << 1 | (code[j] == '1');
+        }
+        kraft_sum += 1ull << (KERNEL_MAX_CODE_LENGTH - length);
+
+        if (symbol == ESCAPE_SYMBOL)
+        {
+            escape_code = value;
+        }
+        else
+        {
+            encode_table->codes[symbol] = value;
+            encode_table->lengths[symbol] = (unsigned char) length;
+        }
+
+        if (length <= DECODE_LOOKUP_BITS)
+        {
+            // every index starting with the code decodes to the symbol
+            unsigned int first = value << (DECODE_LOOKUP_BITS - length);
+            for (unsigned int j = 0; j < 1u << (DECODE_LOOKUP_BITS - length); j++)
+            {
+                decode_table->entries[first + j].symbol = (unsigned short) symbol;
+                decode_table->entries[first + j].length = (unsigned char) length;
+            }
+        }
+        else
+        {
+            decode_table->long_codes[decode_table->long_count] = value;
+            decode_table->long_entries[decode_table->long_count].symbol = (unsigned short) symbol;
+            decode_table->long_entries[decode_table->long_count].length = (unsigned char) length;
+            decode_table->long_count++;
+        }
+    }
+
+    // a code covering more than all bit patterns would let the lookup entries overlap
+    if (has_kernel_tables && kraft_sum > 1ull << KERNEL_MAX_CODE_LENGTH)
+    {
+        return COMPRESSION_EXCEPTION;
+    }
+
+    // chars missing in a sampled table are packed as escape code followed by the char
+    for (unsigned int symbol = 0; symbol < NUM_OF_SYMBOLS && escape_length > 0; symbol++)
+    {
+        if (encode_table->lengths[symbol] == 0)
+        {
+            encode_table->codes[symbol] = escape_code << 8 | symbol;
+            encode_table->lengths[symbol] = (unsigned char) (escape_length + 8);
+        }
+    }
+    return SUCCESS;
+}
+
+static void encode_block(const unsigned char *block, size_t block_size)
+{
+    unsigned long long counts[NUM_OF_SYMBOLS] = {0};
+    unsigned long long bit_count = 0;
+
+    if (is_ans_table)
+    {
+        size_t packed_size = ans_encode(block, block_size, ans_encode_table, packed_buffer);
+        write_varint(packed_size);
+        write_chars(packed_buffer, packed_size);
+        return;
+    }
+    if (has_kernel_tables)
+    {
+        size_t packed_size = get_kernels()->pack(block, block_size, encode_table, packed_buffer);
+        write_varint(packed_size);
+        write_chars(packed_buffer, packed_size);
+        return;
+    }
+
+    // codes too long for the kernels: size the block in advance, then write bit by bit
+    count_block(block, block_size, counts);
+    for (int i = 0; i < NUM_OF_SYMBOLS; i++)
+    {
+        bit_count += counts[i] * (code_lengths[i] > 0 ? code_lengths[i] : code_lengths[ESCAPE_SYMBOL] + 8u);
+    }
+    write_varint((bit_count + 7) / 8);
+
+    for (size_t i = 0; i < block_size; i++)
+    {
+        encode_char(block[i]);
+    }
+    align_out();
+}
+
+static void encode_char(unsigned char next_char)
+{
+    // get code for char
+    char *next_code = get_huffman_code_by_char(next_char);
+
+    if (*next_code != '\0')
+    {
+        write_code(next_code);
+    }
+    else
+    {
+        // char not in table (sampled table): escape code followed by the char's bits
+        write_code(get_huffman_code_by_char(ESCAPE_SYMBOL));
+        for (int i = 7; i >= 0; i--)
+        {
+            write_bit((next_char >> i) & 1 ? BIT1 : BIT0);
+        }
+    }
+}
+
+static EXIT decode_blocks(unsigned char *destination, unsigned long long char_count)
+{
+    unsigned long long counts[NUM_OF_SYMBOLS];
+    unsigned long long decoded_count = 0;
+    unsigned long long filter_start = 0;
+    unsigned long long filter_end = 0;
+    unsigned int filter = FILTER_NONE;
+    bool has_table = false;
+
+    while (decoded_count < char_count)
+    {
+        unsigned long long block_header = read_varint();
+        unsigned long long block_size = block_header >> BLOCK_HEADER_BITS;
+        BLOCK_MODE mode = (BLOCK_MODE) (block_header >> 1 & ((1u << BLOCK_MODE_BITS) - 1));
+        bool is_ans = mode == BLOCK_ANS;
+        bool is_filtered;
+        unsigned char *block;
+        unsigned long long packed_size;
+        EXIT exit;
+
+        if (has_varint_error() || block_size == 0 || block_size > codec_block_size
+            || block_size > char_count - decoded_count
+            || (block_header & 1 && (mode >= BLOCK_LZ || !has_table || is_ans != is_ans_table)))
+        {
+            return COMPRESSION_EXCEPTION;
+        }
+
+        // a filter spans whole blocks and starts behind the previous one
+        if (block_header & BLOCK_FILTERED)
+        {
+            unsigned long long filter_size;
+
+            if (decoded_count < filter_end || !has_next_char())
+            {
+                return COMPRESSION_EXCEPTION;
+            }
+            filter = (unsigned int) read_char();
+            filter_size = read_varint();
+            if (has_varint_error() || !is_valid_filter(filter) || filter_size < block_size || filter_size > codec_block_size
+                || filter_size > char_count - decoded_count)
+            {
+                return COMPRESSION_EXCEPTION;
+            }
+            filter_start = decoded_count;
+            filter_end = decoded_count + filter_size;
+        }
+        is_filtered = decoded_count < filter_end;
+        if (is_filtered && block_size > filter_end - decoded_count)
+        {
+            return COMPRESSION_EXCEPTION;
+        }
 
-/**
- * Huffman-Code-Tabelle
- */
-static HUFFMAN_CODE **huffman_code_table;
+        // filtered chars are collected until the filter can be undone into the destination
+        if (is_filtered)
+        {
+            block = get_filter_buffer() + (decoded_count - filter_start);
+        }
+        else
+        {
+            block = destination != NULL ? destination + decoded_count : block_buffer;
+        }
 
-/**
- * Optimaler Binärbaum
- */
-static BTREE *optimal_tree;
+        if (mode == BLOCK_LZ || mode == BLOCK_BWT)
+        {
+            exit = mode == BLOCK_LZ ? decode_lz_block(block, (size_t) block_size)
+                                    : decode_bwt_block(block, (size_t) block_size);
+            if (exit != SUCCESS)
+            {
+                return exit;
+            }
+            if (destination == NULL && !is_filtered)
+            {
+                write_chars(block, (size_t) block_size);
+            }
 
-/**
- * Größe der Huffman-Code-Tabelle
- */
-static unsigned int huff_size;
+            // the block replaced the table, the next block brings its own
+            has_table = false;
+            is_ans_table = false;
+        }
+        else
+        {
+            // a reused table is still built, otherwise read and build the block's own
+            if (!(block_header & 1))
+            {
+                unsigned long long table_count;
+                unsigned long long escape_count;
 
-/**
- * Füllstand der Huffman-Code-Tabelle
- */
-static unsigned int huff_filling_level;
+                if (read_frequencies(counts, &table_count) != SUCCESS)
+                {
+                    return COMPRESSION_EXCEPTION;
+                }
+                escape_count = read_varint();
+                if (has_varint_error() || escape_count > MAX_TABLE_COUNT - table_count)
+                {
+                    return COMPRESSION_EXCEPTION;
+                }
+                if (is_ans)
+                {
+                    // tANS tables come from counted blocks and never escape chars
+                    exit = escape_count == 0 ? ans_normalize(counts, ans_normalized) : COMPRESSION_EXCEPTION;
+                    if (exit == SUCCESS)
+                    {
+                        ans_build_decode_table(ans_normalized, ans_decode_table);
+                    }
+                }
+                else
+                {
+                    exit = build_code_table(counts, escape_count);
+                }
+                if (exit != SUCCESS)
+                {
+                    return exit;
+                }
+                is_ans_table = is_ans;
+                has_table = true;
+            }
 
-/**
- * Größe der Frequencies
- */
-static unsigned int freq_size;
+            packed_size = read_varint();
+            if (has_varint_error())
+            {
+                return COMPRESSION_EXCEPTION;
+            }
+            if (is_ans_table || has_kernel_tables)
+            {
+                // read the packed codes at once and decode them from memory
+                if (packed_size > (is_ans_table ? ans_get_bound((size_t) block_size)
+                                                : get_packed_bound((size_t) block_size))
+                    || read_chars(packed_buffer, (size_t) packed_size) != packed_size)
+                {
+                    return COMPRESSION_EXCEPTION;
+                }
+                if (is_ans_table)
+                {
+                    // the decoder loads 8 bytes at a time, up to 7 behind the stream
+                    memset(packed_buffer + packed_size, 0, 8);
+                    exit = ans_decode(packed_buffer, (size_t) packed_size, ans_decode_table, block,
+                                      (size_t) block_size);
+                }
+                else
+                {
+                    exit = unpack_codes(packed_buffer, (size_t) packed_size, block, (size_t) block_size);
+                }
+                if (exit == SUCCESS && destination == NULL && !is_filtered)
+                {
+                    write_chars(block, (size_t) block_size);
+                }
+            }
+            else
+            {
+                exit = destination != NULL || is_filtered ? decode_memory(block, block_size, NULL)
+                                                          : decode_outfile(block_size, NULL);
+                align_in();
+            }
+            if (exit != SUCCESS)
+            {
+                return exit;
+            }
+        }
+        decoded_count += block_size;
 
-/**
- * Füllstand der Frequencies
- */
-static unsigned int freq_filling_level;
+        if (is_filtered && decoded_count == filter_end)
+        {
+            size_t filter_size = (size_t) (filter_end - filter_start);
 
-/**
- * Bestimmt die Huffman-Code-Tabelle.
- * @param node - Knoten des Binärbaumes
- * @param code - Huffman-Code
- */
-static EXIT get_code_table(BTREE_NODE *node, char *code);
+            if (destination != NULL)
+            {
+                get_kernels()->unfilter(filter_buffer, filter_size, filter, destination + filter_start);
+            }
+            else
+            {
+                get_kernels()->unfilter(filter_buffer, filter_size, filter, block_buffer);
+                write_chars(block_buffer, filter_size);
+            }
+        }
+        if (destination != NULL && decoded_count >= filter_end)
+        {
+            // decoded pages stay in the page cache, but need not stay resident
+            trim_outfile_mapped(decoded_count);
+        }
+    }
+    return SUCCESS;
+}
 
-/**
- * Liefert Index des Eintrags der Huffman-Code-Tabelle, dessen Zeichenkette dem Parameter-Code entspricht.
- * @param code - Zeichenkette der gesuchten Huffman-Code-Tabelle
- * @return -1 falls Huffman-Code-Tabelle keinen entsprechenden Eintrag hat, sonst den Index.
- */
-static int get_code_table_index_by_code(char *code);
+static EXIT unpack_codes(const unsigned char *source, size_t source_size, unsigned char *destination,
+                         size_t char_count)
+{
+    if (!decode_table->has_multi_entries && char_count >= MULTI_MIN_CHAR_COUNT)
+    {
+        build_multi_entries(decode_table);
+    }
+    return get_kernels()->unpack(source, source_size, decode_table, destination, char_count);
+}
 
-/**
- * Liefert Index des Eintrags der Huffman-Code-Tabelle, dessen Zeichen dem Parameter-Zeichen entspricht.
- * @param next_char - Zeichen der gesuchten Huffman-Code-Tabelle
- * @return -1 falls Huffman-Code-Tabelle keinen entsprechenden Eintrag hat, sonst den Index.
- */
-static char *get_huffman_code_by_char(unsigned char next_char);
+static EXIT encode_transformed_block(const unsigned char *block, size_t block_size, size_t plane_size, int level,
+                                     bool *is_encoded)
+{
+    unsigned long long counts[NUM_OF_SYMBOLS];
+    BWT_BLOCK transform;
+    double plain_bits = 0;
+    double bwt_bits = HUGE_VAL;
+    EXIT exit;
 
-/**
- * Liefert Index der Frequencies, dessen Zeichen dem Parameter-Zeichen entspricht.
- * @param pp_frequency - Frequencies
- * @param next_char - Zeichen der gesuchten Frequencies
- * @return -1 falls Frequencies keinen entsprechenden Eintrag hat, sonst den Index.
- */
-static int get_frequency_index_by_char(FREQUENCY **pp_frequency, unsigned char next_char);
+    *is_encoded = false;
 
-/**
- * Vergleicht zwei Binärbäume anhand der Häufigkeit in ihrer Wurzel.
- * Es wird vorausgesetzt, dass der Wert der Wurzel des Baumes vom Typ FREQUENCY ist.
- * @param btree1 - erster zu vergleichender Binärbaum
- * @param btree2 - zweiter zu vergleichender Binärbaum
- * @return -1, wenn der der erste Baum eine geringere Häufigkeit in der Wurzel hat, sonst 1
- */
-static int compare_btrees_by_frequency(BTREE *btree1, BTREE *btree2);
+    // estimate the plain blocks the way compress() would split them
+    for (size_t offset = 0, size; offset < block_size; offset += size)
+    {
+        size = get_segment_size(offset, block_size, plane_size);
+        if (level >= SPLIT_MIN_LEVEL)
+        {
+            size = get_split_size(block + offset, size, counts);
+        }
+        else
+        {
+            memset(counts, 0, sizeof(counts));
+            count_block(block + offset, size, counts);
+        }
+        plain_bits += get_entropy_bits(counts) + (double) get_table_bits(counts);
+    }
 
-extern EXIT compress(char *in_filename, char *out_filename)
-{
-    freq_size = NUM_OF_ELEMENTS;
-    frequencies = (FREQUENCY **) malloc((sizeof(FREQUENCY *) * (size_t) freq_size));
-    huffman_code_table = (HUFFMAN_CODE **) malloc(sizeof(HUFFMAN_CODE *) * (size_t) NUM_OF_ELEMENTS);
-    freq_filling_level = 0;
+    // the transform is sized first, sequences have to beat both
+    if (level >= BWT_MIN_LEVEL)
+    {
+        bwt_bits = prepare_bwt_block(block, block_size, &transform);
+    }
+    if (codec_window_size > 0)
+    {
+        exit = encode_lz_block(block, block_size, level, bwt_bits < plain_bits ? bwt_bits : plain_bits, is_encoded);
+        if (exit != SUCCESS || *is_encoded)
+        {
+            return exit;
+        }
+    }
 
-    if (open_infile(in_filename) != SUCCESS || open_outfile(out_filename) != SUCCESS)
+    if (bwt_bits >= plain_bits)
     {
-        return IO_EXCEPTION;
+        return SUCCESS;
     }
+    *is_encoded = true;
+    return write_bwt_block(block_size, &transform);
+}
 
-    int index = -1;
-    // get and store frequencies
-    while (has_next_char())
+static EXIT encode_lz_block(const unsigned char *block, size_t block_size, int level, double max_bits,
+                            bool *is_encoded)
+{
+    unsigned long long stream_counts[LZ_STREAM_COUNT][NUM_OF_SYMBOLS];
+    unsigned char *streams[LZ_STREAM_COUNT];
+    size_t stream_sizes[LZ_STREAM_COUNT];
+    LZ_SEQUENCES sequences;
+    size_t extra_size;
+    unsigned long long lz_size;
+
+    *is_encoded = false;
+    lz_parse(block, block_size, level, codec_window_size, &sequences);
+    get_lz_streams(&sequences, streams, stream_sizes);
+    extra_size = (size_t) ((sequences.extra_bit_count + 7) / 8);
+
+    // exact size of the sequences: the streams' tables without escape count, their packed codes and the extra bits
+    lz_size = get_varint_size(sequences.literal_count) + get_varint_size(sequences.sequence_count)
+              + get_varint_size(extra_size) + extra_size;
+    for (int i = 0; i < LZ_STREAM_COUNT; i++)
     {
-        unsigned char next_char = read_char();
-        index = get_frequency_index_by_char(frequencies, next_char);
+        unsigned long long bit_count = 0;
 
-        if (index != -1)
+        memset(stream_counts[i], 0, sizeof(stream_counts[i]));
+        if (stream_sizes[i] == 0)
         {
-            // increase frequency
-            frequency_set_count((*(frequencies + index)),
-                                frequency_get_count(*(frequencies + index)) + 1);
+            continue;
         }
-        else
+        count_block(streams[i], stream_sizes[i], stream_counts[i]);
+        if (build_code_table(stream_counts[i], 0) != SUCCESS)
         {
-            if (freq_filling_level == freq_size)
-            {
-                // increase frequency memory
-                freq_size += NUM_OF_ELEMENTS;
-                frequencies = (FREQUENCY **) realloc(frequencies, (size_t) (sizeof(FREQUENCY *) *freq_size));
-            }
+            return COMPRESSION_EXCEPTION;
+        }
+        if (!has_kernel_tables)
+        {
+            return SUCCESS;
+        }
+        for (int j = 0; j < NUM_OF_SYMBOLS; j++)
+        {
+            bit_count += stream_counts[i][j] * code_lengths[j];
+        }
+        lz_size += get_table_bits(stream_counts[i]) / 8 - 1 + get_varint_size((bit_count + 7) / 8) + (bit_count + 7) / 8;
+    }
 
-            // create and store new frequency
-            *(frequencies + freq_filling_level) = frequency_create(next_char, 1);
-            freq_filling_level++;
+    if ((double) (lz_size * 8) >= max_bits)
+    {
+        return SUCCESS;
+    }
+
+    write_block_header(block_size, BLOCK_LZ, false);
+    write_varint(sequences.literal_count);
+    write_varint(sequences.sequence_count);
+    for (int i = 0; i < LZ_STREAM_COUNT; i++)
+    {
+        size_t packed_size;
+
+        if (stream_sizes[i] == 0)
+        {
+            continue;
+        }
+        if (build_code_table(stream_counts[i], 0) != SUCCESS)
+        {
+            return COMPRESSION_EXCEPTION;
         }
+        write_frequencies(stream_counts[i]);
+        packed_size = get_kernels()->pack(streams[i], stream_sizes[i], encode_table, packed_buffer);
+        write_varint(packed_size);
+        write_chars(packed_buffer, packed_size);
     }
+    write_varint(extra_size);
+    write_chars(sequences.extra_bits, extra_size);
+
+    *is_encoded = true;
+    return SUCCESS;
+}
+
+static double prepare_bwt_block(const unsigned char *block, size_t block_size, BWT_BLOCK *transform)
+{
+    double huffman_bits = HUGE_VAL;
+    double ans_bits = HUGE_VAL;
+    double bits;
 
-    // build optimal tree with heap
-    heap_init((HEAP_ELEM_COMP) compare_btrees_by_frequency, (HEAP_ELEM_PRINT) btree_print);
+    if (!bwt_encode(block, block_size, &transform->symbols, &transform->symbol_count, &transform->primary_index))
+    {
+        return HUGE_VAL;
+    }
+    memset(transform->counts, 0, sizeof(transform->counts));
+    count_block(transform->symbols, transform->symbol_count, transform->counts);
 
-    // fill heap with btrees of frequencies
-    for (int i = 0; i < freq_filling_level; i++)
+    // the symbols are mostly small, so tANS often beats huffman codes here
+    if (build_code_table(transform->counts, 0) != SUCCESS)
+    {
+        return HUGE_VAL;
+    }
+    if (has_kernel_tables)
+    {
+        huffman_bits = get_huffman_bits(transform->counts);
+    }
+    if (ans_normalize(transform->counts, transform->normalized) == SUCCESS)
     {
-        heap_insert(btree_new(*(frequencies + i), (DESTROY_DATA_FCT) frequency_destroy, (PRINT_DATA_FCT) frequency_print));
+        ans_bits = ans_get_bits(transform->counts, transform->normalized) * ANS_COST_FACTOR;
     }
+    transform->is_ans = ans_bits < huffman_bits;
+    bits = transform->is_ans ? ans_bits : huffman_bits;
 
-    // write number of frequencies
-    write_int(freq_filling_level);
+    // primary index, number of symbols with the tANS flag, table without escape count and packed size
+    return bits + 8.0 * (get_varint_size(transform->primary_index)
+                         + get_varint_size((unsigned long long) transform->symbol_count << 1)
+                         + get_table_bits(transform->counts) / 8 - 1 + get_varint_size((unsigned long long) (bits / 8)));
+}
 
-    // write the frequencies' character and count
-    for (int j = 0; j < freq_filling_level; j++)
+static EXIT write_bwt_block(size_t block_size, BWT_BLOCK *transform)
+{
+    size_t packed_size;
+
+    write_block_header(block_size, BLOCK_BWT, false);
+    write_varint(transform->primary_index);
+    write_varint((unsigned long long) transform->symbol_count << 1 | transform->is_ans);
+    write_frequencies(transform->counts);
+
+    if (transform->is_ans)
+    {
+        ans_build_encode_table(transform->normalized, ans_encode_table);
+        packed_size = ans_encode(transform->symbols, transform->symbol_count, ans_encode_table, packed_buffer);
+    }
+    else
     {
-        write_char((*(frequencies + j))->word);
-        write_int((*(frequencies + j))->count);
+        // the table may have been replaced while sizing sequences
+        if (build_code_table(transform->counts, 0) != SUCCESS)
+        {
+            return COMPRESSION_EXCEPTION;
+        }
+        packed_size = get_kernels()->pack(transform->symbols, transform->symbol_count, encode_table, packed_buffer);
     }
+    write_varint(packed_size);
+    write_chars(packed_buffer, packed_size);
+    return SUCCESS;
+}
 
-    BTREE *min_element1 = NULL;
-    BTREE *min_element2 = NULL;
-    while (heap_extract_min((void **)&min_element1) && heap_extract_min((void **)&min_element2))
+static void get_lz_streams(const LZ_SEQUENCES *sequences, unsigned char *streams[], size_t stream_sizes[])
+{
+    streams[0] = sequences->literals;
+    stream_sizes[0] = sequences->literal_count;
+    streams[1] = sequences->run_codes;
+    streams[2] = sequences->length_codes;
+    streams[3] = sequences->distance_codes;
+    for (int i = 1; i < LZ_STREAM_COUNT; i++)
     {
-        // merge minimal trees and insert merged tree back in the heap
-        heap_insert(btree_merge(min_element1, min_element2,
-                    frequency_create('\0',
-                            ((FREQUENCY *)(btreenode_get_data(btree_get_root(min_element1))))->count
-                            + ((FREQUENCY *)(btreenode_get_data(btree_get_root(min_element2))))->count)));
+        stream_sizes[i] = sequences->sequence_count;
     }
-    optimal_tree = min_element1;
+}
 
-    // fill code table with codes
-    huff_filling_level = 0;
-    huff_size = NUM_OF_ELEMENTS;
-    if (get_code_table(btree_get_root(optimal_tree), "") == COMPRESSION_EXCEPTION)
+static EXIT decode_lz_block(unsigned char *block, size_t block_size)
+{
+    unsigned long long counts[NUM_OF_SYMBOLS];
+    unsigned char *streams[LZ_STREAM_COUNT];
+    size_t stream_sizes[LZ_STREAM_COUNT];
+    LZ_SEQUENCES sequences;
+    unsigned long long extra_size;
+
+    lz_get_buffers(block_size, &sequences);
+    sequences.literal_count = (size_t) read_varint();
+    sequences.sequence_count = (size_t) read_varint();
+    if (has_varint_error() || sequences.literal_count > block_size
+        || sequences.sequence_count > lz_get_max_sequences(block_size))
     {
         return COMPRESSION_EXCEPTION;
     }
+    get_lz_streams(&sequences, streams, stream_sizes);
 
-    // read infile and write huffman-codes as bits
-    close_infile();
-    open_infile(in_filename);
-
-    while (has_next_char())
+    // every stream has its own table, its codes are unpacked at once
+    for (int i = 0; i < LZ_STREAM_COUNT; i++)
     {
-        // get code for char
-        unsigned char next_char = read_char();
-        char *next_code = get_huffman_code_by_char(next_char);
+        unsigned long long packed_size;
 
-        // write code's bits
-        for (int i = 0; i < strlen(next_code); i++)
+        if (stream_sizes[i] == 0)
         {
-            if (next_code[i] == '1')
-            {
-                write_bit(BIT1);
-            }
-            else
-            {
-                write_bit(BIT0);
-            }
+            continue;
+        }
+        if (read_frequencies(counts, NULL) != SUCCESS || build_code_table(counts, 0) != SUCCESS || !has_kernel_tables)
+        {
+            return COMPRESSION_EXCEPTION;
+        }
+        packed_size = read_varint();
+        if (has_varint_error() || packed_size > get_packed_bound(stream_sizes[i])
+            || read_chars(packed_buffer, (size_t) packed_size) != packed_size
+            || unpack_codes(packed_buffer, (size_t) packed_size, streams[i], stream_sizes[i]) != SUCCESS)
+        {
+            return COMPRESSION_EXCEPTION;
         }
     }
 
-    close_infile();
-    close_outfile();
+    extra_size = read_varint();
+    if (has_varint_error() || extra_size > lz_get_extra_bound(block_size)
+        || read_chars(sequences.extra_bits, (size_t) extra_size) != extra_size)
+    {
+        return COMPRESSION_EXCEPTION;
+    }
 
-    return SUCCESS;
+    // the values are read 8 bytes at a time, up to 7 behind the extra bits
+    memset(sequences.extra_bits + extra_size, 0, 8);
+    return lz_decode(&sequences, (size_t) extra_size, block, block_size);
 }
 
-extern EXIT decompress(char *in_filename, char *out_filename)
+static EXIT decode_bwt_block(unsigned char *block, size_t block_size)
 {
-    huffman_code_table = (HUFFMAN_CODE **) malloc(sizeof(HUFFMAN_CODE *) * (size_t) NUM_OF_ELEMENTS);
-    unsigned int char_count = 0;
+    unsigned long long counts[NUM_OF_SYMBOLS];
+    unsigned char *symbols = bwt_get_symbol_buffer(block_size);
+    unsigned long long primary_index = read_varint();
+    unsigned long long symbol_header = read_varint();
+    unsigned long long symbol_count = symbol_header >> 1;
+    bool is_ans = (symbol_header & 1) != 0;
+    unsigned long long packed_size;
+    EXIT exit;
 
-    if (open_infile(in_filename) != SUCCESS || open_outfile(out_filename) != SUCCESS)
+    if (has_varint_error() || symbol_count == 0 || symbol_count > block_size
+        || read_frequencies(counts, NULL) != SUCCESS)
     {
-        return IO_EXCEPTION;
+        return COMPRESSION_EXCEPTION;
     }
 
-    // read frequencies and insert in heap
-    heap_init((HEAP_ELEM_COMP) compare_btrees_by_frequency, (HEAP_ELEM_PRINT) btree_print);
-    freq_size = read_int();
-    frequencies = (FREQUENCY **) malloc((size_t) (sizeof(FREQUENCY *) * (size_t) freq_size));
-
-    for (int i = 0; i < freq_size; i++)
+    if (is_ans)
     {
-        unsigned char character = read_char();
-        unsigned int count = read_int();
-        char_count += count;
-        *(frequencies + i) = frequency_create(character, count);
-        heap_insert(btree_new(*(frequencies + i), (DESTROY_DATA_FCT) frequency_destroy, (PRINT_DATA_FCT) frequency_print));
+        exit = ans_normalize(counts, ans_normalized);
+        if (exit == SUCCESS)
+        {
+            ans_build_decode_table(ans_normalized, ans_decode_table);
+        }
     }
-
-    BTREE *min_element1 = NULL;
-    BTREE *min_element2 = NULL;
-    while (heap_extract_min((void **)&min_element1) && heap_extract_min((void **)&min_element2))
+    else
     {
-        // merge minimal trees and insert merged tree back in the heap
-        heap_insert(btree_merge(min_element1, min_element2,
-                                frequency_create('\0',
-                                                 ((FREQUENCY *)(btreenode_get_data(btree_get_root(min_element1))))->count
-                                                 + ((FREQUENCY *)(btreenode_get_data(btree_get_root(min_element2))))->count)));
+        exit = build_code_table(counts, 0) == SUCCESS && has_kernel_tables ? SUCCESS : COMPRESSION_EXCEPTION;
+    }
+    if (exit != SUCCESS)
+    {
+        return exit;
     }
-    optimal_tree = min_element1;
 
-    // fill code table with codes
-    huff_filling_level = 0;
-    huff_size = NUM_OF_ELEMENTS;
-    if (get_code_table(btree_get_root(optimal_tree), "") == COMPRESSION_EXCEPTION)
+    packed_size = read_varint();
+    if (has_varint_error() || packed_size > (is_ans ? ans_get_bound((size_t) symbol_count) : get_packed_bound((size_t) symbol_count))
+        || read_chars(packed_buffer, (size_t) packed_size) != packed_size)
     {
         return COMPRESSION_EXCEPTION;
     }
+    if (is_ans)
+    {
+        // the decoder loads 8 bytes at a time, up to 7 behind the stream
+        memset(packed_buffer + packed_size, 0, 8);
+        exit = ans_decode(packed_buffer, (size_t) packed_size, ans_decode_table, symbols, (size_t) symbol_count);
+    }
+    else
+    {
+        exit = unpack_codes(packed_buffer, (size_t) packed_size, symbols, (size_t) symbol_count);
+    }
+    if (exit != SUCCESS)
+    {
+        return exit;
+    }
+    return bwt_decode(symbols, (size_t) symbol_count, (size_t) primary_index, block, block_size);
+}
 
-    char *code = malloc(sizeof(char));
-    code[0] = '\0';
-    int code_size = 1;
-    int index;
-    while (has_next_bit())
+static void write_block_header(size_t block_size, BLOCK_MODE mode, bool is_reused)
+{
+    // number of chars, then filter flag, mode and reuse flag in the lowest bits
+    write_varint((unsigned long long) block_size << BLOCK_HEADER_BITS
+                 | (pending_filter != FILTER_NONE ? BLOCK_FILTERED : 0) | (unsigned long long) mode << 1 | is_reused);
+    if (pending_filter != FILTER_NONE)
     {
-        // get bit and add to code
-        BIT next_bit = read_bit();
+        write_char((unsigned char) pending_filter);
+        write_varint(pending_filter_size);
+        pending_filter = FILTER_NONE;
+    }
+}
+
+static unsigned int select_filter(const unsigned char *block, size_t block_size)
+{
+    // delta for counters and integers, xor for floats, each on its own or with byte planes
+    static const unsigned int candidates[] = {
+            FILTER_DELTA, FILTER_DELTA | 1, FILTER_DELTA | 2, FILTER_DELTA | 3,
+            FILTER_XOR | 2, FILTER_XOR | 3,
+            FILTER_SHUFFLE | 1, FILTER_SHUFFLE | 2, FILTER_SHUFFLE | 3,
+            FILTER_DELTA | FILTER_SHUFFLE | 1, FILTER_DELTA | FILTER_SHUFFLE | 2, FILTER_DELTA | FILTER_SHUFFLE | 3,
+            FILTER_XOR | FILTER_SHUFFLE | 2, FILTER_XOR | FILTER_SHUFFLE | 3
+    };
+    unsigned long long counts[NUM_OF_SYMBOLS] = {0};
+    unsigned char *buffer = get_filter_buffer();
+    unsigned int best_filter = FILTER_NONE;
+    double best_bits;
+
+    count_block(block, block_size, counts);
+    best_bits = (get_entropy_bits(counts) + (double) get_table_bits(counts)) * FILTER_MIN_GAIN;
 
-        code = realloc(code, sizeof(char) * (size_t) code_size);
-        code[code_size - 1] = '\0';
+    for (size_t i = 0; i < sizeof(candidates) / sizeof(candidates[0]); i++)
+    {
+        size_t plane_size = candidates[i] & FILTER_SHUFFLE ? block_size >> (candidates[i] & FILTER_LANE_MASK) : 0;
+        double bits = 0;
 
-        if (next_bit == BIT0)
+        // byte planes get their own blocks, and so their own tables
+        get_kernels()->filter(block, block_size, candidates[i], buffer);
+        for (size_t offset = 0, size; offset < block_size; offset += size)
         {
-            code = strncat(code, "0", 2);
+            size = get_segment_size(offset, block_size, plane_size);
+            memset(counts, 0, sizeof(counts));
+            count_block(buffer + offset, size, counts);
+            bits += get_entropy_bits(counts) + (double) get_table_bits(counts);
         }
-        else
+        if (bits < best_bits)
         {
-            code = strncat(code, "1", 2);
+            best_filter = candidates[i];
+            best_bits = bits;
         }
+    }
+    return best_filter;
+}
 
-        code_size++;
-        index = get_code_table_index_by_code(code);
-        if (index != -1 && char_count > 0)
+static size_t get_segment_size(size_t offset, size_t buffer_size, size_t plane_size)
+{
+    size_t end;
+
+    if (plane_size == 0)
+    {
+        return buffer_size - offset;
+    }
+    end = (offset / plane_size + 1) * plane_size;
+    return end >= buffer_size || buffer_size - end < plane_size ? buffer_size - offset : end - offset;
+}
+
+static unsigned char *get_filter_buffer(void)
+{
+    if (filter_buffer == NULL)
+    {
+        filter_buffer = (unsigned char *) malloc(codec_block_size);
+        if (filter_buffer == NULL)
         {
-            // get and write code's char
-            char_count--;
-            write_char(huffman_code_get_character(*(huffman_code_table + index)));
-            code = realloc(code, sizeof(char));
-            code[0] = '\0';
-            code_size = 1;
+            printf("Fehler bei der Speicherreservierung.");
+            exit(1);
         }
     }
+    return filter_buffer;
+}
 
-    close_infile();
-    close_outfile();
+static unsigned int get_varint_size(unsigned long long value)
+{
+    unsigned int size = 1;
 
-    return SUCCESS;
+    while (value >= 0x80)
+    {
+        value >>= 7;
+        size++;
+    }
+    return size;
+}
+
+static void write_code(char *code)
+{
+    for (; *code != '\0'; code++)
+    {
+        write_bit(*code == '1' ? BIT1 : BIT0);
+    }
+}
+
+static unsigned long long sample_frequencies(unsigned long long counts[], unsigned long long in_size)
+{
+    unsigned long long sample_size = 0;
+    unsigned int symbol_count = 0;
+
+    for (int chunk = 0; chunk < SAMPLE_CHUNKS; chunk++)
+    {
+        // chunks start evenly strided, the last one ends at the end of the file
+        unsigned long long offset = (in_size - SAMPLE_CHUNK_SIZE) / (SAMPLE_CHUNKS - 1) * (unsigned long long) chunk;
+        size_t chunk_size = SAMPLE_CHUNK_SIZE;
+
+        // the block buffer may be smaller than a chunk
+        seek_infile(offset);
+        while (chunk_size > 0)
+        {
+            size_t size = read_chars(block_buffer, chunk_size < codec_block_size ? chunk_size : codec_block_size);
+            if (size == 0)
+            {
+                break;
+            }
+            count_block(block_buffer, size, counts);
+            sample_size += size;
+            chunk_size -= size;
+        }
+    }
+
+    for (int i = 0; i < NUM_OF_SYMBOLS; i++)
+    {
+        symbol_count += counts[i] > 0;
+    }
+
+    // chars missing in the sample are escaped, about once in 65536 chars
+    if (symbol_count == NUM_OF_SYMBOLS)
+    {
+        return 0;
+    }
+    return sample_size >> 16 > 0 ? sample_size >> 16 : 1;
 }
 
-static EXIT get_code_table(BTREE_NODE *node, char *code)
+static EXIT get_code_table(BTREE_NODE *node, char *code, unsigned int length)
 {
     if (node == NULL)
     {
@@ -294,23 +2560,17 @@ static EXIT get_code_table(BTREE_NODE *node, char *code)
 
     if (!btreenode_is_leaf(node))
     {
-        // proceed with left node
+        // proceed with left node, the code is extended in place
         if (btreenode_get_left(node) != NULL)
         {
-            char *new_code = malloc(((int) sizeof(char) * ((int) strlen(code) + 2)));
-            memset(new_code, 0, (int) strlen(code) + 1);
-            strncpy(new_code, code, strlen(code));
-            strncat(new_code, LEFT_SIGN, 2);
-            get_code_table(btreenode_get_left(node), new_code);
+            code[length] = LEFT_SIGN[0];
+            get_code_table(btreenode_get_left(node), code, length + 1);
         }
         // proceed with right node
         if (btreenode_get_right(node) != NULL)
         {
-            char *new_code = malloc(sizeof(char) * ((int) strlen(code) + 2));
-            memset(new_code, 0, (int) strlen(code) + 1);
-            strncpy(new_code, code, strlen(code));
-            strncat(new_code, RIGHT_SIGN, 2);
-            get_code_table(btreenode_get_right(node), new_code);
+            code[length] = RIGHT_SIGN[0];
+            get_code_table(btreenode_get_right(node), code, length + 1);
         }
     }
     else
@@ -323,14 +2583,16 @@ static EXIT get_code_table(BTREE_NODE *node, char *code)
         }
 
         // if root is a leaf
-        if (strlen(code) == 0)
+        if (length == 0)
         {
-            code = "1";
+            code[length++] = LEFT_SIGN[0];
         }
+        code[length] = '\0';
 
         // fill table with code
         if (DEBUG) printf("[%c -> %s]\n", ((FREQUENCY *)btreenode_get_data(node))->word, code);
         *(huffman_code_table + huff_filling_level) = huffman_code_create(((FREQUENCY *)btreenode_get_data(node))->word, code);
+        code_lengths[((FREQUENCY *)btreenode_get_data(node))->word] = (unsigned short) strlen(code);
         huff_filling_level++;
     }
 
@@ -350,7 +2612,7 @@ static int get_code_table_index_by_code(char *code)
     return -1;
 }
 
-static char *get_huffman_code_by_char(unsigned char next_char)
+static char *get_huffman_code_by_char(unsigned int next_char)
 {
     for (int i = 0; i < huff_filling_level; i++)
     {
@@ -361,25 +2623,3 @@ static char *get_huffman_code_by_char(unsigned char next_char)
     }
     return "";
 }
-
-static int get_frequency_index_by_char(FREQUENCY **pp_frequency, unsigned char next_char)
-{
-    if (pp_frequency != NULL)
-    {
-        for (int i = 0; i < freq_filling_level && *(pp_frequency + i) != NULL; i++)
-        {
-            if (frequency_get_word(*(pp_frequency + i)) == next_char)
-            {
-                return i;
-            }
-        }
-    }
-    return -1;
-}
-
-static int compare_btrees_by_frequency(BTREE *btree1, BTREE *btree2)
-{
-    return ((FREQUENCY *) btreenode_get_data(btree_get_root(btree1)))->count < ((FREQUENCY *)btreenode_get_data(btree_get_root(btree2)))->count
-        ? -1
-        : 1;
-}
\ No newline at end of file
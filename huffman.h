@@ -1,7 +1,10 @@
 /**
  * @file
  *
- * Dieses Modul implementiert (momentan) Test-Methoden.
+ * Dieses Modul implementiert die Huffman-Komprimierung und -Dekomprimierung
+ * einzelner Dateien sowie die Bausteine (Häufigkeiten zählen, Code-Tabelle
+ * aufbauen, kodieren, dekodieren), aus denen weitere Dateiformate
+ * zusammengesetzt werden.
  *
  * @author  Tim Ostermann
  * @date    2020-12-05
@@ -11,14 +14,201 @@
 #define HUFFMAN_HUFFMAN_H
 
 #include "huffman_common.h"
+#include <stddef.h>
+
+/**
+ * Kennung am Anfang jeder komprimierten Datei
+ */
+#define MAGIC "HC"
+
+/**
+ * Version des Dateiformats (8: Blockspeicher wahlweise gefiltert)
+ */
+#define FORMAT_VERSION 8
+
+/**
+ * Filter der Komprimierung, der je Blockspeicher den kürzesten Filter oder
+ * keinen wählt
+ */
+#define FILTER_AUTO 0x100
+
+/**
+ * Symbol für Zeichen, die in einer Tabelle aus einer Stichprobe fehlen.
+ * Auf seinen Code folgen die 8 Bits des Zeichens.
+ */
+#define ESCAPE_SYMBOL NUM_OF_SYMBOLS
+
+/**
+ * Höchste Anzahl Zeichen eines Blocks. Die Dekomprimierung benötigt stets
+ * einen Blockspeicher dieser Größe.
+ */
+#define MAX_BLOCK_SIZE 262144
+
+/**
+ * Kleinste Größe des Blockspeichers bei der Komprimierung
+ */
+#define MIN_BLOCK_SIZE 16384
+
+/**
+ * Speicher eines Threads neben Block- und Packspeicher (Stack, Ein- und
+ * Ausgabepuffer, Code- und Dekodiertabellen, Baum)
+ */
+#define CODEC_THREAD_MEMORY 524288
+
+/**
+ * Ergebnis der Analyse einer Datei
+ */
+typedef struct
+{
+    /**
+     * Anzahl der Zeichen
+     */
+    unsigned long long char_count;
+
+    /**
+     * Entropie der Häufigkeiten über die ganze Datei in Bits je Zeichen
+     */
+    double entropy;
+
+    /**
+     * Größe der Datei, die compress() mit Huffman-Codes schreibt, samt aller
+     * Köpfe und Tabellen in Bytes
+     */
+    unsigned long long huffman_size;
+
+    /**
+     * Mittlere Codelänge der Huffman-Codes in Bits je Zeichen
+     */
+    double average_code_length;
+
+    /**
+     * Anzahl der Blöcke
+     */
+    unsigned long long block_count;
+
+    /**
+     * Anzahl der Blöcke, die die Tabelle des vorherigen Blocks wiederverwenden
+     */
+    unsigned long long reused_count;
+
+    /**
+     * Kleinste und größte Entropie eines Blocks in Bits je Zeichen
+     */
+    double min_block_entropy;
+    double max_block_entropy;
+
+    /**
+     * Standardabweichung der Entropie der Blöcke in Bits je Zeichen,
+     * gewichtet mit ihrer Anzahl Zeichen
+     */
+    double block_entropy_deviation;
+} FILE_ANALYSIS;
+
+/**
+ * Gemeinsame Angaben zu allen Teilen einer Eingabedatei, die mit
+ * compress_part() unabhängig voneinander komprimiert werden
+ */
+typedef struct
+{
+    /**
+     * Größe der Eingabedatei, steht im Dateikopf
+     */
+    unsigned long long in_size;
+
+    /**
+     * Gibt an, ob alle Blöcke eine feste Tabelle verwenden: die aus der
+     * Stichprobe oder die aus set_codec_table()
+     */
+    bool is_fixed;
+
+    /**
+     * Häufigkeiten der festen Tabelle
+     */
+    unsigned long long fixed_counts[NUM_OF_SYMBOLS];
+
+    /**
+     * Häufigkeit des Escape-Symbols der festen Tabelle
+     */
+    unsigned long long escape_count;
+} COMPRESS_PLAN;
 
 /**
  * Implementierung der Huffman-Komprimierung.
+ * Nach Kennung, Version und Größe folgen Blöcke. Jeder Block beginnt an
+ * einer Byte-Grenze mit der Anzahl seiner Zeichen, gefolgt von der Art der
+ * Kodierung in zwei Bits (Huffman-Codes, tANS oder LZ77) und einem Bit, ob
+ * die Tabelle des vorherigen Blocks wiederverwendet wird; sonst folgen die
+ * Häufigkeiten der neuen Tabelle und die des Escape-Symbols.
+ * Danach folgen die Anzahl der Bytes der gepackten Codes und die Codes.
+ * Ein weiteres Bit über der Art der Kodierung kennzeichnet den ersten Block
+ * eines gefilterten Blockspeichers (siehe set_codec_filter()); direkt hinter
+ * der Anzahl folgen dann der Filter und die Anzahl der Zeichen, über die er
+ * sich erstreckt. Aufgeteilte Ebenen bekommen eigene Blöcke.
+ * Ab Level 2 wird tANS gewählt, wenn der Block damit laut Schätzung
+ * kürzer wird, was bei sehr ungleich verteilten Zeichen der Fall ist.
+ * Mit einem Fenster (siehe set_codec_window()) wird jeder Blockspeicher
+ * zuerst in LZ77-Sequenzen zerlegt. Ist das kürzer, folgen die Anzahl der
+ * Literale und Sequenzen, für Literale und die drei Arten von Codes je
+ * Häufigkeiten, Anzahl der Bytes und gepackte Codes, zuletzt die Anzahl
+ * der Bytes der unkodierten Bits und die Bits.
+ * Ab Level 8 wird jeder Blockspeicher außerdem mit einer Burrows-Wheeler-
+ * Transformation samt MTF und Lauflängenkodierung versucht. Ist das am
+ * kürzesten, folgen die Zeile des ursprünglichen Blocks, die Anzahl der
+ * Symbole mit einem Bit für tANS, die Häufigkeiten, die Anzahl der Bytes
+ * der Kodierung und die Kodierung. Solche Blöcke verwenden wie LZ77-Blöcke
+ * keine Tabelle wieder und hinterlassen keine.
+ * Bis Level SAMPLE_MAX_LEVEL verwenden große Dateien für alle Blöcke eine
+ * Tabelle aus einer Stichprobe, fehlende Zeichen werden über das
+ * Escape-Symbol kodiert.
+ * Nach set_codec_table() verwenden ebenso alle Blöcke die übernommene
+ * Tabelle, unabhängig vom Level.
  * @param in_filename - Name der Eingabedatei
  * @param out_filename - Name der Ausgabedatei
+ * @param level - Komprimierungslevel
+ * @return Exit-Code
+ */
+extern EXIT compress(char *in_filename, char *out_filename, int level);
+
+/**
+ * Bereitet die Komprimierung einer Eingabedatei in Teilen vor: Bestimmt
+ * ihre Größe und nimmt wie compress() ggf. die Stichprobe.
+ * @param in_filename - Name der Eingabedatei
+ * @param level - Komprimierungslevel
+ * @param plan - Übergabeparameter für die Angaben zu allen Teilen
+ * @return Exit-Code
+ */
+extern EXIT plan_compression(char *in_filename, int level, COMPRESS_PLAN *plan);
+
+/**
+ * Komprimiert einen Teil einer Eingabedatei in den Speicher. Hintereinander
+ * geschrieben ergeben die Teile eine Datei wie von compress(): Der Teil ab
+ * Offset 0 beginnt mit dem Dateikopf, jeder andere mit einem Block, der
+ * seine Tabelle mitbringt oder die gemeinsame Tabelle der Stichprobe
+ * wiederverwendet. Nur an den Grenzen der Teile können Tabellen mehr
+ * geschrieben werden als von compress().
+ * @param in_filename - Name der Eingabedatei
+ * @param plan - Angaben aus plan_compression()
+ * @param offset - Offset des Teils in der Eingabedatei
+ * @param size - Anzahl der Zeichen des Teils
+ * @param level - Komprimierungslevel
+ * @param data - Zeiger auf die Ausgabe, mit free() freizugeben; NULL bei Fehler
+ * @param data_size - Anzahl der Bytes der Ausgabe
+ * @return Exit-Code
+ */
+extern EXIT compress_part(char *in_filename, const COMPRESS_PLAN *plan, unsigned long long offset,
+                          unsigned long long size, int level, unsigned char **data, size_t *data_size);
+
+/**
+ * Analysiert eine Datei, ohne sie zu komprimieren: Die Blöcke werden wie
+ * von compress() gebildet und ihre Tabellen gewählt, aber nur Häufigkeiten
+ * gezählt und Codelängen aufgebaut. Die Größe gilt für reine Huffman-Codes
+ * ohne Stichprobe, tANS, Filter und Vorstufen, und ist dann exakt.
+ * @param in_filename - Name der Eingabedatei
+ * @param level - Komprimierungslevel, bestimmt die Aufteilung in Blöcke
+ * @param analysis - Übergabeparameter für das Ergebnis
  * @return Exit-Code
  */
-extern EXIT compress(char *in_filename, char *out_filename);
+extern EXIT analyze(char *in_filename, int level, FILE_ANALYSIS *analysis);
 
 /**
  * Implementierung der Huffman-Dekomprimierung.
@@ -28,4 +218,136 @@ extern EXIT compress(char *in_filename, char *out_filename);
  */
 extern EXIT decompress(char *in_filename, char *out_filename);
 
+/**
+ * Zählt die Häufigkeiten der restlichen Zeichen der Eingabedatei.
+ * @param counts - Häufigkeiten je Zeichen, werden erhöht
+ * @param crc - Zeiger auf fortzuschreibende Prüfsumme oder NULL
+ */
+extern void count_frequencies(unsigned long long counts[], unsigned int *crc);
+
+/**
+ * Schreibt die Häufigkeiten (Anzahl Zeichen, dann Zeichen und Anzahl je
+ * vorkommendem Zeichen) in die Ausgabedatei.
+ * @param counts - Häufigkeiten je Zeichen
+ */
+extern void write_frequencies(const unsigned long long counts[]);
+
+/**
+ * Liest mit write_frequencies() geschriebene Häufigkeiten aus der Eingabedatei
+ * und prüft sie: höchstens NUM_OF_SYMBOLS Zeichen in aufsteigender Folge,
+ * jede Häufigkeit größer 0 und eine Summe, mit der der Baum ohne Überlauf
+ * aufgebaut wird.
+ * @param counts - Häufigkeiten je Zeichen, werden überschrieben
+ * @param char_count - Übergabeparameter für die Summe der Häufigkeiten oder NULL
+ * @return COMPRESSION_EXCEPTION, falls die Häufigkeiten ungültig sind oder
+ * die Eingabedatei vorher endet
+ */
+extern EXIT read_frequencies(unsigned long long counts[], unsigned long long *char_count);
+
+/**
+ * Baut optimalen Baum und Huffman-Code-Tabelle aus den Häufigkeiten auf.
+ * Ein zuvor aufgebauter Code wird freigegeben.
+ * @param counts - Häufigkeiten je Zeichen
+ * @param escape_count - Häufigkeit des Escape-Symbols, 0 für keines
+ * @return Exit-Code
+ */
+extern EXIT build_code_table(const unsigned long long counts[], unsigned long long escape_count);
+
+/**
+ * Kodiert die restlichen Zeichen der Eingabedatei mit der aktuellen
+ * Huffman-Code-Tabelle in die Ausgabedatei.
+ */
+extern void encode_infile(void);
+
+/**
+ * Dekodiert Zeichen aus der Eingabedatei mit der aktuellen
+ * Huffman-Code-Tabelle in eine neue Datei. Die Datei wird mit ihrer
+ * endgültigen Größe angelegt und direkt im eingeblendeten Speicher
+ * beschrieben; ist das nicht möglich, wird gepuffert geschrieben.
+ * @param out_filename - Name der Ausgabedatei
+ * @param char_count - Anzahl zu dekodierender Zeichen
+ * @param crc - Zeiger auf fortzuschreibende Prüfsumme oder NULL
+ * @return Exit-Code
+ */
+extern EXIT decode_file(char *out_filename, unsigned long long char_count, unsigned int *crc);
+
+/**
+ * Dekodiert Zeichen aus der Eingabedatei mit der aktuellen
+ * Huffman-Code-Tabelle in einen Speicherbereich. Da jedes Zeichen an seiner
+ * endgültigen Position landet, können getrennte Bereiche unabhängig
+ * voneinander dekodiert werden.
+ * @param destination - Anfang des Speicherbereichs
+ * @param char_count - Anzahl zu dekodierender Zeichen
+ * @param crc - Zeiger auf fortzuschreibende Prüfsumme oder NULL
+ * @return COMPRESSION_EXCEPTION, falls die Eingabedatei vorher endet
+ */
+extern EXIT decode_memory(unsigned char *destination, unsigned long long char_count, unsigned int *crc);
+
+/**
+ * Dekodiert Zeichen aus der Eingabedatei mit der aktuellen
+ * Huffman-Code-Tabelle in die Ausgabedatei.
+ * @param char_count - Anzahl zu dekodierender Zeichen
+ * @param crc - Zeiger auf fortzuschreibende Prüfsumme oder NULL
+ * @return COMPRESSION_EXCEPTION, falls die Eingabedatei vorher endet
+ */
+extern EXIT decode_outfile(unsigned long long char_count, unsigned int *crc);
+
+/**
+ * Gibt optimalen Baum und Huffman-Code-Tabelle frei.
+ */
+extern void release_code_table(void);
+
+/**
+ * Legt den Speicher fest, den der Codec je Thread verwendet. Der Aufruf
+ * muss erfolgen, bevor ein Thread zum ersten Mal (de-)komprimiert.
+ * @param block_size - Größe des Blockspeichers zwischen MIN_BLOCK_SIZE und
+ * MAX_BLOCK_SIZE, bei der Dekomprimierung MAX_BLOCK_SIZE
+ * @param is_bounded - Gibt an, ob der Speicher begrenzt ist. Dann werden
+ * Dateien aus Archiven nicht eingeblendet.
+ */
+extern void set_codec_memory(size_t block_size, bool is_bounded);
+
+/**
+ * Legt das Fenster der LZ77-Vorstufe bei der Komprimierung fest; gilt für
+ * alle Threads. Wie gründlich Verweise gesucht werden, hängt vom
+ * Komprimierungslevel ab.
+ * @param window_size - größter Abstand eines Verweises, höchstens
+ * MAX_BLOCK_SIZE, 0 schaltet die Vorstufe ab
+ */
+extern void set_codec_window(size_t window_size);
+
+/**
+ * Legt den Filter fest, mit dem die Komprimierung jeden Blockspeicher vor
+ * der Kodierung vorbereitet; gilt für alle Threads. Die Dekomprimierung
+ * macht Filter anhand der Blockköpfe rückgängig.
+ * @param filter - gültiger Filter (siehe is_valid_filter()), FILTER_AUTO
+ * oder 0 für keinen
+ */
+extern void set_codec_filter(unsigned int filter);
+
+/**
+ * Übernimmt die Tabelle des ersten Blocks einer komprimierten Datei für
+ * alle folgenden Komprimierungen; gilt für alle Threads. Jede Datei wird
+ * dann in einem Durchgang ohne Zählen mit dieser Tabelle kodiert, Zeichen
+ * ohne Code über das Escape-Symbol. Der erste Block darf kein LZ77-, BWT-
+ * oder gefilterter Block sein.
+ * @param table_filename - Name der komprimierten Datei
+ * @return Exit-Code, COMPRESSION_EXCEPTION, wenn die Datei keine solche
+ *         Tabelle enthält
+ */
+extern EXIT set_codec_table(char *table_filename);
+
+/**
+ * Liefert den Speicher, den ein Thread höchstens für den Codec belegt.
+ * @param block_size - Größe des Blockspeichers
+ * @param level - höchster Komprimierungslevel, 0 bei der Dekomprimierung
+ * @return Anzahl Bytes
+ */
+extern unsigned long long get_codec_memory(size_t block_size, int level);
+
+/**
+ * Gibt den Speicher des Codecs im aufrufenden Thread frei.
+ */
+extern void free_codec(void);
+
 #endif //HUFFMAN_HUFFMAN_H
\ No newline at end of file
@@ -1,5 +1,6 @@
 #include "huffman_code.h"
 #include <stdlib.h>
+#include <string.h>
 
 /**
  * Implementierung des Eintrags der Huffman-Code-Tabelle.
@@ -9,7 +10,7 @@ typedef struct _HUFFMAN_CODE
     /**
      * Zeichen des Huffman-Codes
      */
-    unsigned char character;
+    unsigned int character;
 
     /**
      * Zeichenkette des Huffman-Codes.
@@ -17,21 +18,25 @@ typedef struct _HUFFMAN_CODE
     char *code;
 } HUFFMAN_CODE;
 
-extern HUFFMAN_CODE *huffman_code_create(unsigned char character, char *code)
+extern HUFFMAN_CODE *huffman_code_create(unsigned int character, char *code)
 {
-    HUFFMAN_CODE *huff_code = (HUFFMAN_CODE *) malloc(sizeof(HUFFMAN_CODE *));
-    huff_code->code = code;
+    HUFFMAN_CODE *huff_code = (HUFFMAN_CODE *) malloc(sizeof(HUFFMAN_CODE));
+    huff_code->code = strdup(code);
     huff_code->character = character;
     return huff_code;
 }
 
 extern void huffman_code_destroy(HUFFMAN_CODE *huffman_code)
 {
+    if (huffman_code != NULL)
+    {
+        free(huffman_code->code);
+    }
     free(huffman_code);
     huffman_code = NULL;
 }
 
-extern unsigned char huffman_code_get_character(HUFFMAN_CODE *huffman_code)
+extern unsigned int huffman_code_get_character(HUFFMAN_CODE *huffman_code)
 {
     if (huffman_code != NULL)
     {
@@ -55,7 +60,7 @@ extern char *huffman_code_get_code(HUFFMAN_CODE *huffman_code)
     }
 }
 
-extern void huffman_code_set_character(HUFFMAN_CODE *huffman_code, unsigned char character)
+extern void huffman_code_set_character(HUFFMAN_CODE *huffman_code, unsigned int character)
 {
     if (huffman_code != NULL)
     {
@@ -67,6 +72,7 @@ extern void huffman_code_set_code(HUFFMAN_CODE *huffman_code, char *code)
 {
     if (huffman_code != NULL)
     {
-        huffman_code->code = code;
+        free(huffman_code->code);
+        huffman_code->code = strdup(code);
     }
 }
\ No newline at end of file
@@ -9,10 +9,10 @@ typedef struct _HUFFMAN_CODE HUFFMAN_CODE;
 /**
  * Erzeugt eine Instanz vom Typ Huffman-Code.
  * @param character - Zeichen des Codes
- * @param code - Zeichenkette des Codes
+ * @param code - Zeichenkette des Codes, wird kopiert
  * @return Adresse des erzeugten Huffman-Codes
  */
-extern HUFFMAN_CODE *huffman_code_create(unsigned char character, char *code);
+extern HUFFMAN_CODE *huffman_code_create(unsigned int character, char *code);
 
 /**
  * Löscht übergebenen Huffman-Code.
@@ -25,7 +25,7 @@ extern void huffman_code_destroy(HUFFMAN_CODE *huffman_code);
  * @param huffman_code - Huffman-Code, dessen Zeichen geliefert werden soll
  * @return Zeichen des Huffman-Codes
  */
-extern unsigned char huffman_code_get_character(HUFFMAN_CODE *huffman_code);
+extern unsigned int huffman_code_get_character(HUFFMAN_CODE *huffman_code);
 
 /**
  * Liefert Zeichenkette eines Huffman-Codes.
@@ -39,12 +39,12 @@ extern char *huffman_code_get_code(HUFFMAN_CODE *huffman_code);
  * @param huffman_code - Huffman-Code, dessen Zeichen gesetzt werden soll
  * @param character - zu setzendes Zeichen
  */
-extern void huffman_code_set_character(HUFFMAN_CODE *huffman_code, unsigned char character);
+extern void huffman_code_set_character(HUFFMAN_CODE *huffman_code, unsigned int character);
 
 /**
  * Setzt Zeichenkette eines Huffman-Codes.
  * @param huffman_code - Huffman-Code, dessen Zeichenkette gesetzt werden soll
- * @param code - zu setzende Zeichenkette
+ * @param code - zu setzende Zeichenkette, wird kopiert
  */
 extern void huffman_code_set_code(HUFFMAN_CODE *huffman_code, char *code);
 
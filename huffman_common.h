@@ -42,6 +42,11 @@ typedef enum
  */
 #define MAX_LENGTH_FILENAME 2000
 
+/**
+ * Anzahl unterschiedlicher Zeichen (Bytewerte)
+ */
+#define NUM_OF_SYMBOLS 256
+
 /**
  * Anzahl Elemente, die reserviert/gelöscht werden
  */
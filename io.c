@@ -1,7 +1,16 @@
+#define _GNU_SOURCE
 #include "io.h"
+#include "ring.h"
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <stdint.h>
+#include <errno.h>
 
 /**
  * liefert Bitwert an bestimmter Position in einem Byte
@@ -30,75 +39,359 @@ static int read_infile(void);
 static void write_outfile(void);
 
 /**
- * Eingabepuffer
+ * Liest aus der Eingabedatei, gepuffert über stdio oder ausgerichtet am
+ * Seitencache vorbei.
+ * @param destination - Zielbereich
+ * @param count - höchste Anzahl zu lesender Bytes
+ * @return Anzahl gelesener Bytes, weniger als count am Dateiende
  */
-static unsigned char in_buffer[BUF_SIZE];
+static size_t read_input(unsigned char *destination, size_t count);
+
+/**
+ * Schreibt in die Ausgabedatei, gepuffert über stdio oder ausgerichtet am
+ * Seitencache vorbei.
+ * @param source - Anfang des Speicherbereichs
+ * @param count - Anzahl der Bytes
+ */
+static void write_output(const unsigned char *source, size_t count);
+
+/**
+ * Gibt an, ob eine Ausgabedatei zum Schreiben geöffnet ist.
+ * @return Wahrheitswert
+ */
+static bool is_outfile_open(void);
+
+/**
+ * Liefert den Dateideskriptor der Eingabedatei.
+ * @return Dateideskriptor oder -1, wenn keine Eingabedatei geöffnet ist
+ */
+static int get_infile_descriptor(void);
+
+/**
+ * Liest den ausgerichteten Abschnitt der Eingabedatei ab einem Offset in
+ * den Direktpuffer.
+ * @param offset - Offset, Vielfaches von DIRECT_ALIGNMENT
+ */
+static void read_direct(unsigned long long offset);
+
+/**
+ * Schreibt die vollständigen ausgerichteten Abschnitte des Direktpuffers
+ * der Ausgabedatei.
+ */
+static void flush_direct(void);
+
+/**
+ * Schreibt den Anfang des Direktpuffers der Ausgabedatei an ihr Ende.
+ * @param size - Anzahl der Bytes, ein Vielfaches von DIRECT_ALIGNMENT,
+ * solange die Datei mit O_DIRECT geöffnet ist
+ */
+static void write_direct(size_t size);
+
+/**
+ * Reserviert Ein- und Ausgabepuffer des Threads, falls noch nicht geschehen.
+ */
+static void init_buffers(void);
+
+/**
+ * Öffnet eine Datei mit O_DIRECT und reserviert den zugehörigen
+ * Direktpuffer des Threads.
+ * @param filename - Name der Datei
+ * @param flags - Flags von open() ohne O_DIRECT
+ * @param buffer - Direktpuffer des Threads
+ * @return Dateideskriptor oder -1, falls das Dateisystem O_DIRECT nicht
+ * unterstützt; dann wird gepuffert gelesen bzw. geschrieben
+ */
+static int open_direct(const char *filename, int flags, unsigned char **buffer);
+
+/**
+ * Arbeitsfunktion der Lesestufe: liest die Eingabedatei der Reihe nach in
+ * die leeren Puffer der Stufe, bis ihre Anzahl Bytes gelesen ist, und
+ * beendet sich mit einem leeren Puffer.
+ * @param stage - Lesestufe
+ * @return NULL
+ */
+static void *run_read_stage(void *stage);
+
+/**
+ * Arbeitsfunktion der Schreibstufe: schreibt die gefüllten Puffer der Stufe
+ * in die Ausgabedatei, bis ein leerer Puffer kommt.
+ * @param stage - Schreibstufe
+ * @return NULL
+ */
+static void *run_write_stage(void *stage);
+
+/**
+ * Beendet die Lesestufe vorzeitig; ihre bereits gelesenen Puffer werden
+ * verworfen.
+ */
+static void stop_read_stage(void);
+
+/**
+ * Übergibt einen vollen Puffer an die Schreibstufe, die beim ersten vollen
+ * Puffer gestartet wird.
+ */
+static void flush_write_stage(void);
+
+/**
+ * Schreibt den letzten Puffer und beendet die Schreibstufe.
+ */
+static void close_write_stage(void);
+
+/**
+ * Liefert die Puffer der Stufen des Threads, die beim ersten Aufruf
+ * reserviert werden: zuerst die der Lese-, dann die der Schreibstufe.
+ * @return Anfang des ersten Puffers
+ */
+static unsigned char *get_stage_buffers(void);
+
+/**
+ * Gibt an, ob Dateien mit O_DIRECT gelesen und geschrieben werden; gilt
+ * für alle Threads
+ */
+static bool is_io_direct = false;
+
+/**
+ * Gibt an, ob große Dateien in eigenen Threads gelesen und geschrieben
+ * werden; gilt für alle Threads
+ */
+static bool is_io_pipelined = false;
+
+/**
+ * Stufe, die in einem eigenen Thread eine Datei liest oder schreibt. Der
+ * Thread der Datei und der der Stufe reichen sich die Puffer über zwei
+ * Ringe weiter, gefüllte in Richtung der Daten, leere zurück.
+ */
+typedef struct
+{
+    /**
+     * Gefüllte Puffer, von der Lesestufe bzw. zur Schreibstufe
+     */
+    SPSC_RING filled;
+
+    /**
+     * Leere Puffer, zur Lesestufe bzw. von der Schreibstufe
+     */
+    SPSC_RING empty;
+
+    /**
+     * Datei der Stufe
+     */
+    FILE *file;
+
+    /**
+     * Anzahl der Bytes, die die Lesestufe noch liest
+     */
+    unsigned long long remaining;
+
+    /**
+     * Gibt an, ob die Lesestufe vorzeitig enden soll
+     */
+    atomic_bool is_stopping;
+
+    /**
+     * Thread der Stufe
+     */
+    pthread_t thread;
+} IO_STAGE;
+
+/**
+ * Eingabepuffer, wird vom Thread selbst angelegt
+ */
+static _Thread_local unsigned char *in_buffer = NULL;
 
 /**
  * Leseposition Byte Eingabepuffer
  */
-static unsigned int read_byte_position = 0;
+static _Thread_local unsigned int read_byte_position = 0;
 
 /**
  * Füllstand Byte Eingabepuffer
  */
-static unsigned int read_byte_filling_level = 0;
+static _Thread_local unsigned int read_byte_filling_level = 0;
 
 /**
  * Lesepostion Bit Eingabepuffer
  */
-static unsigned int read_bit_position = 0;
+static _Thread_local unsigned int read_bit_position = 0;
 
 /**
  * Füllstand Bit Eingabepuffer
  */
-static unsigned int read_bit_filling_level = 0;
+static _Thread_local unsigned int read_bit_filling_level = 0;
 
 /**
- * Ausgabepuffer
+ * Ausgabepuffer, wird vom Thread selbst angelegt
  */
-static unsigned char out_buffer[BUF_SIZE] = {0};
+static _Thread_local unsigned char *out_buffer = NULL;
 
 /**
  * Schreibposition Byte Ausgabepuffer
  */
-static unsigned int write_byte_position = 0;
+static _Thread_local unsigned int write_byte_position = 0;
 
 /**
  * Schreibposition Bit Ausgabepuffer
  */
-static unsigned int write_bit_position = 0;
+static _Thread_local unsigned int write_bit_position = 0;
 
 /**
  * Eingabestream
  */
-static FILE *p_infile;
+static _Thread_local FILE *p_infile;
 
 /**
  * Ausgabestream
  */
-static FILE *p_outfile;
+static _Thread_local FILE *p_outfile;
 
-static bool end_of_infile;
+static _Thread_local bool end_of_infile;
 
 /**
- * Union, mit deren Hilfe man auf die einzelnen Bytes eines Integerwertes zugreifen kann.
+ * Gibt an, ob eine variabel kodierte Ganzzahl unvollständig oder zu lang war
  */
-typedef union
-{
-    /**
-     * Wert als Integer
-     */
-    unsigned int i;
+static _Thread_local bool is_varint_broken = false;
 
-    /**
-     * Wert als Char-Array
-     */
-    unsigned char c[4];
-} CHARS_IN_INT;
+/**
+ * Dateideskriptor der mit O_DIRECT geöffneten Eingabedatei
+ */
+static _Thread_local int in_direct_fd = -1;
+
+/**
+ * Ausgerichteter Puffer der mit O_DIRECT geöffneten Eingabedatei
+ */
+static _Thread_local unsigned char *in_direct_buffer = NULL;
+
+/**
+ * Offset des Direktpuffers der Eingabedatei in der Datei
+ */
+static _Thread_local unsigned long long in_direct_offset = 0;
+
+/**
+ * Leseposition und Füllstand des Direktpuffers der Eingabedatei
+ */
+static _Thread_local size_t in_direct_position = 0;
+static _Thread_local size_t in_direct_filling_level = 0;
+
+/**
+ * Dateideskriptor der mit O_DIRECT geöffneten Ausgabedatei
+ */
+static _Thread_local int out_direct_fd = -1;
+
+/**
+ * Ausgerichteter Puffer der mit O_DIRECT geöffneten Ausgabedatei
+ */
+static _Thread_local unsigned char *out_direct_buffer = NULL;
+
+/**
+ * Offset des Direktpuffers der Ausgabedatei in der Datei
+ */
+static _Thread_local unsigned long long out_direct_offset = 0;
+
+/**
+ * Füllstand des Direktpuffers der Ausgabedatei
+ */
+static _Thread_local size_t out_direct_filling_level = 0;
+
+/**
+ * Dateideskriptor der eingeblendeten Ausgabedatei
+ */
+static _Thread_local int out_fd = -1;
+
+/**
+ * Eingeblendeter Bereich der Ausgabedatei
+ */
+static _Thread_local unsigned char *out_mapping = NULL;
+
+/**
+ * Größe des eingeblendeten Bereichs der Ausgabedatei
+ */
+static _Thread_local size_t out_mapping_size = 0;
+
+/**
+ * Größe des Anfangs des eingeblendeten Bereichs, der bereits aus dem
+ * Speicher entfernt wurde
+ */
+static _Thread_local size_t out_trimmed_size = 0;
+
+/**
+ * Speicherbereich der mit open_outfile_memory() geöffneten Ausgabe
+ */
+static _Thread_local char *out_memory = NULL;
+
+/**
+ * Größe des Speicherbereichs der Ausgabe
+ */
+static _Thread_local size_t out_memory_size = 0;
+
+/**
+ * Eingeblendete Eingabedatei
+ */
+static _Thread_local unsigned char *in_mapping = NULL;
+
+/**
+ * Größe der eingeblendeten Eingabedatei
+ */
+static _Thread_local size_t in_mapping_size = 0;
+
+/**
+ * Puffer der Lese- und Schreibstufe des Threads
+ */
+static _Thread_local unsigned char *stage_buffers = NULL;
+
+/**
+ * Lesestufe der Eingabedatei
+ */
+static _Thread_local IO_STAGE in_stage;
+
+/**
+ * Gibt an, ob die Lesestufe läuft
+ */
+static _Thread_local bool is_in_staged = false;
+
+/**
+ * Puffer der Lesestufe, aus dem gerade gelesen wird, data ist NULL vor dem
+ * ersten
+ */
+static _Thread_local RING_SLOT in_stage_slot;
+
+/**
+ * Position im Puffer der Lesestufe
+ */
+static _Thread_local size_t in_stage_position = 0;
+
+/**
+ * Schreibstufe der Ausgabedatei
+ */
+static _Thread_local IO_STAGE out_stage;
+
+/**
+ * Gibt an, ob die Ausgabe über eine Schreibstufe geschrieben wird
+ */
+static _Thread_local bool can_stage_out = false;
+
+/**
+ * Gibt an, ob die Schreibstufe läuft
+ */
+static _Thread_local bool is_out_staged = false;
+
+/**
+ * Puffer, der gerade für die Schreibstufe gefüllt wird, data ist NULL, wenn keiner
+ */
+static _Thread_local RING_SLOT out_stage_slot;
+
+/**
+ * Anzahl der bisher aus der Eingabedatei gelesenen Bytes
+ */
+static _Thread_local unsigned long long in_offset = 0;
+
+/**
+ * Anzahl der bisher in die Ausgabedatei geschriebenen Bytes
+ */
+static _Thread_local unsigned long long out_offset = 0;
 
 extern void init_in(void)
 {
+    init_buffers();
     read_byte_position = 0;
     read_bit_position = 0;
     read_bit_filling_level = 0;
@@ -107,6 +400,7 @@ extern void init_in(void)
 
 extern void init_out(bool save_last_byte)
 {
+    init_buffers();
     if (save_last_byte)
     {
         out_buffer[0] = out_buffer[write_byte_position];
@@ -120,9 +414,18 @@ extern void init_out(bool save_last_byte)
 
 extern EXIT open_infile(char in_filename[])
 {
-    p_infile = fopen(in_filename, "rb");
     init_in();
     end_of_infile = false;
+    is_varint_broken = false;
+    in_offset = 0;
+    in_direct_fd = open_direct(in_filename, O_RDONLY, &in_direct_buffer);
+    if (in_direct_fd != -1)
+    {
+        read_direct(0);
+        return SUCCESS;
+    }
+
+    p_infile = fopen(in_filename, "rb");
     if (p_infile == NULL)
     {
         return IO_EXCEPTION;
@@ -132,8 +435,30 @@ extern EXIT open_infile(char in_filename[])
 
 extern EXIT open_outfile(char out_filename[])
 {
+    init_out(false);
+    out_offset = 0;
+    out_direct_fd = open_direct(out_filename, O_WRONLY | O_CREAT | O_TRUNC, &out_direct_buffer);
+    if (out_direct_fd != -1)
+    {
+        out_direct_offset = 0;
+        out_direct_filling_level = 0;
+        return SUCCESS;
+    }
+
     p_outfile = fopen(out_filename, "wb");
+    if (p_outfile == NULL)
+    {
+        return IO_EXCEPTION;
+    }
+    can_stage_out = is_io_pipelined;
+    return SUCCESS;
+}
+
+extern EXIT open_outfile_memory(void)
+{
     init_out(false);
+    out_offset = 0;
+    p_outfile = open_memstream(&out_memory, &out_memory_size);
     if (p_outfile == NULL)
     {
         return IO_EXCEPTION;
@@ -141,22 +466,670 @@ extern EXIT open_outfile(char out_filename[])
     return SUCCESS;
 }
 
+extern void close_outfile_memory(unsigned char **data, size_t *size)
+{
+    close_outfile();
+    *data = (unsigned char *) out_memory;
+    *size = out_memory_size;
+    out_memory = NULL;
+    out_memory_size = 0;
+}
+
 extern void close_infile(void)
 {
-    fclose(p_infile);
+    stop_read_stage();
+    if (p_infile != NULL)
+    {
+        fclose(p_infile);
+        p_infile = NULL;
+    }
+
+    if (in_direct_fd != -1)
+    {
+        close(in_direct_fd);
+        in_direct_fd = -1;
+    }
 }
 
 extern void close_outfile(void)
 {
-    fclose(p_outfile);
+    if (!is_outfile_open())
+    {
+        return;
+    }
+
+    write_output(out_buffer, write_byte_position);
+    out_offset += write_byte_position;
+    init_out(false);
+
+    if (p_outfile != NULL)
+    {
+        close_write_stage();
+        fclose(p_outfile);
+        p_outfile = NULL;
+        return;
+    }
+
+    // the unaligned tail cannot be written directly, it goes through the page cache
+    flush_direct();
+    if (out_direct_filling_level > 0)
+    {
+        int flags = fcntl(out_direct_fd, F_GETFL);
+        if (flags != -1 && fcntl(out_direct_fd, F_SETFL, flags & ~O_DIRECT) == 0)
+        {
+            write_direct(out_direct_filling_level);
+        }
+        out_direct_filling_level = 0;
+    }
+    close(out_direct_fd);
+    out_direct_fd = -1;
+}
+
+extern void set_io_direct(bool is_direct)
+{
+    is_io_direct = is_direct;
+}
+
+extern void set_io_pipelined(bool is_pipelined)
+{
+    is_io_pipelined = is_pipelined;
+}
+
+extern unsigned long long get_io_memory(void)
+{
+    return (is_io_direct ? 2 * (unsigned long long) DIRECT_BUF_SIZE : 0)
+           + (is_io_pipelined ? 2 * (unsigned long long) STAGE_BUFFERS * STAGE_BUF_SIZE : 0);
+}
+
+extern void free_io(void)
+{
+    free(in_buffer);
+    in_buffer = NULL;
+    out_buffer = NULL;
+    free(stage_buffers);
+    stage_buffers = NULL;
+    free(in_direct_buffer);
+    in_direct_buffer = NULL;
+    free(out_direct_buffer);
+    out_direct_buffer = NULL;
+}
+
+static void init_buffers(void)
+{
+    if (in_buffer != NULL)
+    {
+        return;
+    }
+
+    // one block for both buffers, touched by the thread itself so it lies on its node
+    in_buffer = (unsigned char *) malloc(2 * BUF_SIZE);
+    if (in_buffer == NULL)
+    {
+        printf("Fehler bei der Speicherreservierung.");
+        exit(1);
+    }
+    memset(in_buffer, 0, 2 * BUF_SIZE);
+    out_buffer = in_buffer + BUF_SIZE;
+}
+
+static int open_direct(const char *filename, int flags, unsigned char **buffer)
+{
+    struct stat attribut;
+    int fd;
+
+    // only regular files bypass the page cache, pipes and devices are buffered
+    if (!is_io_direct || (stat(filename, &attribut) == 0 && !S_ISREG(attribut.st_mode)))
+    {
+        return -1;
+    }
+
+    if (*buffer == NULL)
+    {
+        void *memory = NULL;
+        if (posix_memalign(&memory, DIRECT_ALIGNMENT, DIRECT_BUF_SIZE) != 0)
+        {
+            printf("Fehler bei der Speicherreservierung.");
+            exit(1);
+        }
+        *buffer = (unsigned char *) memory;
+    }
+
+    // file systems without direct i/o refuse the flag with EINVAL
+    fd = open(filename, flags | O_DIRECT, 0666);
+    return fd;
+}
+
+static void read_direct(unsigned long long offset)
+{
+    ssize_t size;
+
+    do
+    {
+        size = pread(in_direct_fd, in_direct_buffer, DIRECT_BUF_SIZE, (off_t) offset);
+    } while (size == -1 && errno == EINTR);
+
+    in_direct_offset = offset;
+    in_direct_position = 0;
+    in_direct_filling_level = size > 0 ? (size_t) size : 0;
+}
+
+static void flush_direct(void)
+{
+    size_t size = out_direct_filling_level / DIRECT_ALIGNMENT * DIRECT_ALIGNMENT;
+
+    write_direct(size);
+    memmove(out_direct_buffer, out_direct_buffer + size, out_direct_filling_level - size);
+    out_direct_filling_level -= size;
+}
+
+static void write_direct(size_t size)
+{
+    size_t written = 0;
+
+    while (written < size)
+    {
+        ssize_t result = pwrite(out_direct_fd, out_direct_buffer + written, size - written,
+                                (off_t) (out_direct_offset + written));
+        if (result == -1 && errno == EINTR)
+        {
+            continue;
+        }
+        if (result <= 0)
+        {
+            // a failed write drops the section like a failed fwrite
+            break;
+        }
+        written += (size_t) result;
+    }
+    out_direct_offset += size;
+}
+
+static size_t read_input(unsigned char *destination, size_t count)
+{
+    size_t read_count = 0;
+
+    while (read_count < count && is_in_staged)
+    {
+        size_t size;
+
+        if (in_stage_position == in_stage_slot.size)
+        {
+            if (in_stage_slot.data != NULL)
+            {
+                // an empty buffer ends the stage, the file is then read on at its end
+                if (in_stage_slot.size == 0)
+                {
+                    pthread_join(in_stage.thread, NULL);
+                    is_in_staged = false;
+                    break;
+                }
+                ring_push(&in_stage.empty, in_stage_slot);
+            }
+            in_stage_slot = ring_pop(&in_stage.filled);
+            in_stage_position = 0;
+            continue;
+        }
+
+        size = in_stage_slot.size - in_stage_position;
+        size = count - read_count < size ? count - read_count : size;
+        memcpy(destination + read_count, in_stage_slot.data + in_stage_position, size);
+        in_stage_position += size;
+        read_count += size;
+    }
+
+    if (p_infile != NULL)
+    {
+        return read_count + fread(destination + read_count, sizeof(char), count - read_count, p_infile);
+    }
+
+    while (read_count < count && in_direct_fd != -1)
+    {
+        size_t size;
+
+        if (in_direct_position == in_direct_filling_level)
+        {
+            // a short section marks the end of the file
+            if (in_direct_filling_level < DIRECT_BUF_SIZE)
+            {
+                break;
+            }
+            read_direct(in_direct_offset + DIRECT_BUF_SIZE);
+            continue;
+        }
+
+        size = in_direct_filling_level - in_direct_position;
+        size = count - read_count < size ? count - read_count : size;
+        memcpy(destination + read_count, in_direct_buffer + in_direct_position, size);
+        in_direct_position += size;
+        read_count += size;
+    }
+    return read_count;
+}
+
+static void write_output(const unsigned char *source, size_t count)
+{
+    while (count > 0 && can_stage_out)
+    {
+        size_t size;
+
+        if (out_stage_slot.data == NULL)
+        {
+            // the first buffer is filled before the stage runs
+            out_stage_slot.data = is_out_staged ? ring_pop(&out_stage.empty).data
+                                                : get_stage_buffers() + STAGE_BUFFERS * STAGE_BUF_SIZE;
+            out_stage_slot.size = 0;
+        }
+
+        size = STAGE_BUF_SIZE - out_stage_slot.size;
+        size = count < size ? count : size;
+        memcpy(out_stage_slot.data + out_stage_slot.size, source, size);
+        out_stage_slot.size += size;
+        source += size;
+        count -= size;
+
+        if (out_stage_slot.size == STAGE_BUF_SIZE)
+        {
+            flush_write_stage();
+        }
+    }
+
+    if (p_outfile != NULL)
+    {
+        fwrite(source, sizeof(char), count, p_outfile);
+        return;
+    }
+
+    while (count > 0 && out_direct_fd != -1)
+    {
+        size_t size = DIRECT_BUF_SIZE - out_direct_filling_level;
+
+        size = count < size ? count : size;
+        memcpy(out_direct_buffer + out_direct_filling_level, source, size);
+        out_direct_filling_level += size;
+        source += size;
+        count -= size;
+
+        if (out_direct_filling_level == DIRECT_BUF_SIZE)
+        {
+            flush_direct();
+        }
+    }
+}
+
+static bool is_outfile_open(void)
+{
+    return p_outfile != NULL || out_direct_fd != -1;
+}
+
+static int get_infile_descriptor(void)
+{
+    return p_infile != NULL ? fileno(p_infile) : in_direct_fd;
+}
+
+extern EXIT open_outfile_mapped(char out_filename[], unsigned long long size, unsigned char **destination)
+{
+    struct stat attribut;
+    unsigned long long position;
+    unsigned long long reserved_size;
+
+    *destination = NULL;
+
+    // a mapping writes through the page cache
+    if (size > SIZE_MAX || is_io_direct)
+    {
+        return IO_EXCEPTION;
+    }
+
+    // only regular files can be preallocated and mapped
+    if (stat(out_filename, &attribut) == 0 && !S_ISREG(attribut.st_mode))
+    {
+        return IO_EXCEPTION;
+    }
+
+    out_fd = open(out_filename, O_RDWR | O_CREAT | O_TRUNC, 0666);
+    if (out_fd == -1)
+    {
+        return IO_EXCEPTION;
+    }
+
+    // the size comes from an untrusted header: the file is extended sparsely, and only as many blocks are
+    // reserved up front as the rest of the infile can produce, so a full disk fails here and not with SIGBUS
+    position = in_offset - (read_byte_filling_level - read_byte_position);
+    reserved_size = get_infile_size() > position ? (get_infile_size() - position) * MAPPED_RESERVE_FACTOR : 0;
+    reserved_size = size < reserved_size ? size : reserved_size;
+    if (ftruncate(out_fd, (off_t) size) != 0
+        || (reserved_size > 0 && posix_fallocate(out_fd, 0, (off_t) reserved_size) != 0))
+    {
+        close(out_fd);
+        out_fd = -1;
+        return IO_EXCEPTION;
+    }
+
+    if (size > 0)
+    {
+        void *mapping = mmap(NULL, (size_t) size, PROT_READ | PROT_WRITE, MAP_SHARED, out_fd, 0);
+        if (mapping == MAP_FAILED)
+        {
+            close(out_fd);
+            out_fd = -1;
+            return IO_EXCEPTION;
+        }
+        madvise(mapping, (size_t) size, MADV_SEQUENTIAL);
+        out_mapping = (unsigned char *) mapping;
+        out_mapping_size = (size_t) size;
+        out_trimmed_size = 0;
+    }
+
+    *destination = out_mapping;
+    return SUCCESS;
+}
+
+extern void close_outfile_mapped(void)
+{
+    if (out_mapping != NULL)
+    {
+        munmap(out_mapping, out_mapping_size);
+        out_mapping = NULL;
+        out_offset = out_mapping_size;
+        out_mapping_size = 0;
+    }
+
+    if (out_fd != -1)
+    {
+        close(out_fd);
+        out_fd = -1;
+    }
+}
+
+extern void discard_outfile_mapped(void)
+{
+    if (out_mapping != NULL)
+    {
+        munmap(out_mapping, out_mapping_size);
+        out_mapping = NULL;
+        out_mapping_size = 0;
+    }
+
+    if (out_fd != -1)
+    {
+        // nothing of the claimed size stays behind
+        if (ftruncate(out_fd, 0) == 0)
+        {
+            out_offset = 0;
+        }
+        close(out_fd);
+        out_fd = -1;
+    }
+}
+
+extern void trim_outfile_mapped(unsigned long long offset)
+{
+    size_t page_size = (size_t) sysconf(_SC_PAGESIZE);
+    size_t end = (size_t) offset / page_size * page_size;
+
+    if (out_mapping != NULL && end > out_trimmed_size && end <= out_mapping_size)
+    {
+        madvise(out_mapping + out_trimmed_size, end - out_trimmed_size, MADV_DONTNEED);
+        out_trimmed_size = end;
+    }
+}
+
+extern EXIT map_infile_rest(const unsigned char **data, unsigned long long *size)
+{
+    struct stat attribut;
+    unsigned long long position = in_offset - (read_byte_filling_level - read_byte_position);
+    void *mapping;
+
+    // the mapping replaces the reads ahead
+    stop_read_stage();
+
+    // only the unread rest of a regular file counts, read past the page cache if requested
+    if (p_infile == NULL || is_io_direct || fstat(fileno(p_infile), &attribut) != 0 || !S_ISREG(attribut.st_mode)
+        || (unsigned long long) attribut.st_size <= position || (unsigned long long) attribut.st_size > SIZE_MAX)
+    {
+        return IO_EXCEPTION;
+    }
+
+    mapping = mmap(NULL, (size_t) attribut.st_size, PROT_READ, MAP_PRIVATE, fileno(p_infile), 0);
+    if (mapping == MAP_FAILED)
+    {
+        return IO_EXCEPTION;
+    }
+    in_mapping = (unsigned char *) mapping;
+    in_mapping_size = (size_t) attribut.st_size;
+
+    *data = in_mapping + position;
+    *size = in_mapping_size - position;
+    return SUCCESS;
+}
+
+extern void unmap_infile(void)
+{
+    if (in_mapping != NULL)
+    {
+        munmap(in_mapping, in_mapping_size);
+        in_mapping = NULL;
+        seek_infile(in_mapping_size);
+        in_mapping_size = 0;
+    }
+}
+
+extern EXIT seek_infile(unsigned long long offset)
+{
+    stop_read_stage();
+    if (in_direct_fd != -1)
+    {
+        // direct reads start at an aligned offset, the bytes before are skipped
+        read_direct(offset / DIRECT_ALIGNMENT * DIRECT_ALIGNMENT);
+        in_direct_position = (size_t) (offset % DIRECT_ALIGNMENT);
+        if (in_direct_position > in_direct_filling_level)
+        {
+            in_direct_position = in_direct_filling_level;
+        }
+    }
+    else if (p_infile == NULL || fseeko(p_infile, (off_t) offset, SEEK_SET) != 0)
+    {
+        return IO_EXCEPTION;
+    }
+    init_in();
+    end_of_infile = false;
+    is_varint_broken = false;
+    in_offset = offset;
+    return SUCCESS;
+}
+
+extern unsigned long long get_infile_size(void)
+{
+    struct stat attribut;
+
+    if (get_infile_descriptor() == -1 || fstat(get_infile_descriptor(), &attribut) != 0)
+    {
+        return 0;
+    }
+    return (unsigned long long) attribut.st_size;
+}
+
+extern void prefetch_infile(unsigned long long size)
+{
+    // direct reads bypass the page cache, so there is nothing to fill ahead
+    if (p_infile != NULL && size > 0)
+    {
+        posix_fadvise(fileno(p_infile), (off_t) in_offset, (off_t) size, POSIX_FADV_WILLNEED);
+    }
+}
+
+extern void stream_infile(unsigned long long size)
+{
+    // small files do not pay for a thread, direct reads and pipes are not staged
+    if (!is_io_pipelined || is_in_staged || p_infile == NULL || size <= STAGE_BUF_SIZE
+        || get_infile_size() < in_offset + size)
+    {
+        return;
+    }
+
+    ring_init(&in_stage.filled);
+    ring_init(&in_stage.empty);
+    for (int i = 0; i < STAGE_BUFFERS; i++)
+    {
+        ring_push(&in_stage.empty, (RING_SLOT) {get_stage_buffers() + i * STAGE_BUF_SIZE, 0});
+    }
+    in_stage.file = p_infile;
+    in_stage.remaining = size;
+    atomic_store(&in_stage.is_stopping, false);
+    in_stage_slot.data = NULL;
+    in_stage_slot.size = 0;
+    in_stage_position = 0;
+
+    is_in_staged = pthread_create(&in_stage.thread, NULL, run_read_stage, &in_stage) == 0;
+}
+
+static void *run_read_stage(void *stage)
+{
+    IO_STAGE *in = (IO_STAGE *) stage;
+    RING_SLOT slot;
+
+    do
+    {
+        size_t size = in->remaining < STAGE_BUF_SIZE ? (size_t) in->remaining : STAGE_BUF_SIZE;
+
+        slot = ring_pop(&in->empty);
+        slot.size = atomic_load(&in->is_stopping) ? 0 : fread(slot.data, sizeof(char), size, in->file);
+        in->remaining -= slot.size;
+        ring_push(&in->filled, slot);
+    }
+    while (slot.size > 0);
+
+    return NULL;
+}
+
+static void stop_read_stage(void)
+{
+    if (!is_in_staged)
+    {
+        return;
+    }
+
+    // the stage ends with an empty buffer, until then all buffers go back to it
+    atomic_store(&in_stage.is_stopping, true);
+    while (in_stage_slot.data == NULL || in_stage_slot.size > 0)
+    {
+        if (in_stage_slot.data != NULL)
+        {
+            ring_push(&in_stage.empty, in_stage_slot);
+        }
+        in_stage_slot = ring_pop(&in_stage.filled);
+    }
+    pthread_join(in_stage.thread, NULL);
+    is_in_staged = false;
+}
+
+static void *run_write_stage(void *stage)
+{
+    IO_STAGE *out = (IO_STAGE *) stage;
+    RING_SLOT slot;
+
+    while ((slot = ring_pop(&out->filled)).size > 0)
+    {
+        fwrite(slot.data, sizeof(char), slot.size, out->file);
+        slot.size = 0;
+        ring_push(&out->empty, slot);
+    }
+
+    return NULL;
+}
+
+static void flush_write_stage(void)
+{
+    if (!is_out_staged)
+    {
+        ring_init(&out_stage.filled);
+        ring_init(&out_stage.empty);
+        for (int i = 1; i < STAGE_BUFFERS; i++)
+        {
+            ring_push(&out_stage.empty, (RING_SLOT) {get_stage_buffers() + (STAGE_BUFFERS + i) * STAGE_BUF_SIZE, 0});
+        }
+        out_stage.file = p_outfile;
+        is_out_staged = pthread_create(&out_stage.thread, NULL, run_write_stage, &out_stage) == 0;
+    }
+
+    if (is_out_staged)
+    {
+        ring_push(&out_stage.filled, out_stage_slot);
+        out_stage_slot.data = NULL;
+    }
+    else
+    {
+        // without a thread, the output is written directly from now on
+        fwrite(out_stage_slot.data, sizeof(char), out_stage_slot.size, p_outfile);
+        out_stage_slot.data = NULL;
+        can_stage_out = false;
+    }
+}
+
+static void close_write_stage(void)
+{
+    if (out_stage_slot.data != NULL && out_stage_slot.size > 0)
+    {
+        if (is_out_staged)
+        {
+            ring_push(&out_stage.filled, out_stage_slot);
+        }
+        else
+        {
+            fwrite(out_stage_slot.data, sizeof(char), out_stage_slot.size, p_outfile);
+        }
+    }
+    out_stage_slot.data = NULL;
+
+    if (is_out_staged)
+    {
+        ring_push(&out_stage.filled, (RING_SLOT) {NULL, 0});
+        pthread_join(out_stage.thread, NULL);
+        is_out_staged = false;
+    }
+    can_stage_out = false;
+}
+
+static unsigned char *get_stage_buffers(void)
+{
+    if (stage_buffers == NULL)
+    {
+        stage_buffers = (unsigned char *) malloc(2 * STAGE_BUFFERS * (size_t) STAGE_BUF_SIZE);
+        if (stage_buffers == NULL)
+        {
+            printf("Fehler bei der Speicherreservierung.");
+            exit(1);
+        }
+    }
+    return stage_buffers;
+}
+
+extern void align_out(void)
+{
+    // at the end of the infile, the begun byte has already been written
+    if (write_bit_position != 0 && !end_of_infile)
+    {
+        write_byte_position++;
+    }
+    write_bit_position = 0;
+}
+
+extern void align_in(void)
+{
+    if (read_bit_position != 0)
+    {
+        read_bit_position = 0;
+        read_byte_position++;
+    }
 }
 
 static int read_infile(void)
 {
     init_in();
-    size_t size = fread(in_buffer, sizeof(char), BUF_SIZE, p_infile);
+    size_t size = read_input(in_buffer, BUF_SIZE);
     read_byte_filling_level = size;
     read_bit_filling_level = 7;
+    in_offset += size;
     SPRINT(in_buffer);
     return size;
 }
@@ -168,7 +1141,11 @@ static void write_outfile(void)
         write_byte_position++;
     }
 
-    fwrite(out_buffer, sizeof(char), write_byte_position, p_outfile);
+    if (is_outfile_open())
+    {
+        write_output(out_buffer, write_byte_position);
+        out_offset += write_byte_position;
+    }
     SPRINT(out_buffer);
     init_out(write_bit_position != 0);
 }
@@ -198,33 +1175,112 @@ extern unsigned char read_char(void)
     return next_char;
 }
 
+extern size_t read_chars(unsigned char *destination, size_t count)
+{
+    size_t read_count = 0;
+
+    // large blocks bypass the empty buffer, the rest and the end of the file go through it
+    if (read_byte_position == read_byte_filling_level && read_bit_position == 0 && count >= BUF_SIZE)
+    {
+        read_count = read_input(destination, count / BUF_SIZE * BUF_SIZE);
+        in_offset += read_count;
+    }
+
+    while (read_count < count && has_next_char())
+    {
+        // copy as much of the buffered input as possible at once
+        size_t available = read_byte_filling_level - read_byte_position;
+        size_t size = count - read_count < available ? count - read_count : available;
+        memcpy(destination + read_count, in_buffer + read_byte_position, size);
+        read_byte_position += size;
+        read_count += size;
+    }
+    return read_count;
+}
+
 extern void write_char(unsigned char c)
 {
+    if (write_byte_position == BUF_SIZE)
+    {
+        write_outfile();
+    }
+
     out_buffer[write_byte_position] = c;
     write_byte_position++;
 }
 
-extern unsigned int read_int(void)
+extern void write_chars(const unsigned char *source, size_t count)
 {
-    CHARS_IN_INT *chars_in_int = (CHARS_IN_INT *) malloc(sizeof(CHARS_IN_INT));
-    for (int i = 3; i >= 0; i--)
+    while (count > 0)
     {
-        if (has_next_char())
+        size_t size;
+
+        if (write_byte_position == BUF_SIZE)
         {
-            chars_in_int->c[i] = read_char();
+            write_outfile();
         }
+
+        // large blocks bypass the empty buffer
+        if (write_byte_position == 0 && count >= BUF_SIZE && is_outfile_open())
+        {
+            write_output(source, count);
+            out_offset += count;
+            return;
+        }
+
+        size = count < BUF_SIZE - write_byte_position ? count : BUF_SIZE - write_byte_position;
+        memcpy(out_buffer + write_byte_position, source, size);
+        write_byte_position += size;
+        source += size;
+        count -= size;
     }
-    return chars_in_int->i;
 }
 
-extern void write_int(unsigned int i)
+extern unsigned long long read_varint(void)
 {
-    CHARS_IN_INT *chars_in_int = (CHARS_IN_INT *) malloc(sizeof(CHARS_IN_INT));
-    chars_in_int->i = i;
-    for (int j = 3; j >= 0; j--)
+    unsigned long long value = 0;
+    unsigned int shift = 0;
+    unsigned char next_byte = 0x80;
+
+    // 7 bits per byte, least significant group first, at most 10 bytes for 64 bits
+    while ((next_byte & 0x80) && shift < 64 && has_next_char())
+    {
+        next_byte = read_char();
+        value |= (unsigned long long) (next_byte & 0x7F) << shift;
+        shift += 7;
+    }
+
+    // the value is used anyway, the caller checks has_varint_error() once for a whole header
+    if (next_byte & 0x80)
     {
-        write_char(chars_in_int->c[j]);
+        is_varint_broken = true;
     }
+    return value;
+}
+
+extern bool has_varint_error(void)
+{
+    return is_varint_broken;
+}
+
+extern void write_varint(unsigned long long i)
+{
+    while (i >= 0x80)
+    {
+        write_char((unsigned char) ((i & 0x7F) | 0x80));
+        i >>= 7;
+    }
+    write_char((unsigned char) i);
+}
+
+extern unsigned long long get_in_offset(void)
+{
+    return in_offset;
+}
+
+extern unsigned long long get_out_offset(void)
+{
+    return out_offset + write_byte_position;
 }
 
 extern bool has_next_bit(void)
@@ -261,6 +1317,11 @@ extern BIT read_bit(void)
 
 extern void write_bit(BIT c)
 {
+    if (write_byte_position == BUF_SIZE)
+    {
+        write_outfile();
+    }
+
     if (write_bit_position == 0)
     {
         out_buffer[write_byte_position] = '\0';
@@ -2,12 +2,15 @@
  * @file
  * Diese Modul stellt die Funktionen zum byte- sowie bitweisen Lesen und
  * Schreiben zur Verfügung.
+ * Puffer und Dateien sind threadlokal, sodass mehrere Threads unabhängig
+ * voneinander je eine Ein- und Ausgabedatei bearbeiten können.
  *
  * @author  Tim Ostermann
  * @date    2020-12-05
  */
 
 #include <stdbool.h>
+#include <stddef.h>
 #include "huffman_common.h"
 
 #ifndef HUFFMAN_IO_H
@@ -18,6 +21,33 @@
  */
 #define BUF_SIZE 4096
 
+/**
+ * Höchstes Verhältnis der vorab reservierten Größe einer eingeblendeten
+ * Ausgabedatei zu den restlichen Bytes der Eingabedatei; Huffman-Codes
+ * belegen mindestens ein Bit je Zeichen
+ */
+#define MAPPED_RESERVE_FACTOR 8
+
+/**
+ * Größe der Puffer, über die mit O_DIRECT gelesen und geschrieben wird
+ */
+#define DIRECT_BUF_SIZE 4194304
+
+/**
+ * Ausrichtung von Puffern, Offsets und Längen bei O_DIRECT
+ */
+#define DIRECT_ALIGNMENT 4096
+
+/**
+ * Größe der Puffer, die Lese- und Schreibstufe weiterreichen
+ */
+#define STAGE_BUF_SIZE 1048576
+
+/**
+ * Anzahl der Puffer je Stufe
+ */
+#define STAGE_BUFFERS 4
+
 /**
  * Initialisiert Eingabepuffer.
  */
@@ -29,6 +59,39 @@ extern void init_in(void);
  */
 extern void init_out(bool save_last_byte);
 
+/**
+ * Legt fest, ob reguläre Dateien mit O_DIRECT am Seitencache vorbei in
+ * Abschnitten von DIRECT_BUF_SIZE Bytes gelesen und geschrieben werden; gilt
+ * für alle Threads. Die Ausgabe wird dann nicht eingeblendet, der
+ * unausgerichtete Rest am Dateiende über den Seitencache geschrieben.
+ * Unterstützt das Dateisystem O_DIRECT nicht, wird gepuffert gearbeitet.
+ * @param is_direct - Wahrheitswert
+ */
+extern void set_io_direct(bool is_direct);
+
+/**
+ * Legt fest, ob große Dateien in eigenen Threads gelesen und geschrieben
+ * werden; gilt für alle Threads. Eine Lesestufe liest dann die mit
+ * stream_infile() angekündigten Bytes voraus, eine Schreibstufe schreibt
+ * die Ausgabe, sobald mehr als ein Puffer anfällt. Die Puffer werden über
+ * Ringe ohne Mutex weitergereicht und wiederverwendet. Ohne Wirkung mit
+ * O_DIRECT.
+ * @param is_pipelined - Wahrheitswert
+ */
+extern void set_io_pipelined(bool is_pipelined);
+
+/**
+ * Liefert den Speicher, den ein Thread zusätzlich für Ein- und Ausgabe
+ * belegt.
+ * @return Anzahl Bytes
+ */
+extern unsigned long long get_io_memory(void);
+
+/**
+ * Gibt die Puffer für O_DIRECT im aufrufenden Thread frei.
+ */
+extern void free_io(void);
+
 /**
  * Öffnet Eingabedatei.
  * @param in_filename - Name der Eingabedatei
@@ -43,16 +106,128 @@ extern EXIT open_infile(char in_filename[]);
  */
 extern EXIT open_outfile(char out_filename[]);
 
+/**
+ * Öffnet eine Ausgabe in den Speicher statt in eine Datei. Der Speicher
+ * wächst mit der Ausgabe und wird von close_outfile_memory() übergeben.
+ * @return Exit-Code
+ */
+extern EXIT open_outfile_memory(void);
+
+/**
+ * Schließt die mit open_outfile_memory() geöffnete Ausgabe und übergibt
+ * ihren Speicher, der mit free() freizugeben ist.
+ * @param data - Zeiger auf den Anfang der Ausgabe, NULL, falls keine geöffnet war
+ * @param size - Anzahl der geschriebenen Bytes
+ */
+extern void close_outfile_memory(unsigned char **data, size_t *size);
+
 /**
  * Schließt Eingabedatei.
  */
 extern void close_infile(void);
 
 /**
- * Schließt Ausgabedatei.
+ * Schließt Ausgabedatei. Noch gepufferte vollständige Bytes werden vorher
+ * geschrieben.
  */
 extern void close_outfile(void);
 
+/**
+ * Legt die Ausgabedatei mit ihrer endgültigen Größe an und blendet sie in
+ * den Speicher ein. Da die Größe aus einem ungeprüften Dateikopf stammt,
+ * wird auf dem Datenträger höchstens das MAPPED_RESERVE_FACTOR-fache der
+ * restlichen Eingabedatei reserviert, der Rest bleibt dünn belegt.
+ * Die Ausgabe wird dann direkt in den gelieferten Speicherbereich
+ * geschrieben, ohne Ausgabepuffer und ohne Schreibaufrufe.
+ * Schlägt das Einblenden fehl (z.B. bei Pipes), wird IO_EXCEPTION geliefert
+ * und keine Datei geöffnet; dann kann open_outfile() verwendet werden.
+ * @param out_filename - Name der Ausgabedatei
+ * @param size - endgültige Größe der Ausgabedatei in Bytes
+ * @param destination - Zeiger auf Anfang des eingeblendeten Bereichs
+ *                      (NULL bei Größe 0)
+ * @return Exit-Code
+ */
+extern EXIT open_outfile_mapped(char out_filename[], unsigned long long size, unsigned char **destination);
+
+/**
+ * Blendet die mit open_outfile_mapped() geöffnete Ausgabedatei aus und
+ * schließt sie.
+ */
+extern void close_outfile_mapped(void);
+
+/**
+ * Blendet die mit open_outfile_mapped() geöffnete Ausgabedatei aus, kürzt
+ * sie auf 0 Bytes und schließt sie, etwa wenn die Eingabe fehlerhaft ist.
+ */
+extern void discard_outfile_mapped(void);
+
+/**
+ * Entfernt die vollständig beschriebenen Seiten vor einem Offset aus dem
+ * Speicher des Prozesses. Ihr Inhalt bleibt im Seitencache der Datei.
+ * @param offset - Offset ab Anfang der eingeblendeten Ausgabedatei
+ */
+extern void trim_outfile_mapped(unsigned long long offset);
+
+/**
+ * Blendet die Eingabedatei in den Speicher ein, um ihre noch nicht
+ * gelesenen Zeichen ohne Kopie zu verarbeiten. Schlägt das fehl (z.B. bei
+ * Pipes oder ohne weitere Zeichen), wird IO_EXCEPTION geliefert; dann kann
+ * weiter mit read_char() gelesen werden.
+ * @param data - Zeiger auf das erste noch nicht gelesene Zeichen
+ * @param size - Anzahl der noch nicht gelesenen Zeichen
+ * @return Exit-Code
+ */
+extern EXIT map_infile_rest(const unsigned char **data, unsigned long long *size);
+
+/**
+ * Blendet die mit map_infile_rest() eingeblendete Eingabedatei aus. Die
+ * Zeichen gelten als gelesen, die Leseposition steht am Dateiende.
+ */
+extern void unmap_infile(void);
+
+/**
+ * Setzt die Leseposition der Eingabedatei auf einen absoluten Byte-Offset.
+ * Der Eingabepuffer wird dabei verworfen.
+ * @param offset - 64-Bit-Offset ab Dateianfang
+ * @return Exit-Code
+ */
+extern EXIT seek_infile(unsigned long long offset);
+
+/**
+ * Liefert die Größe der geöffneten Eingabedatei.
+ * @return Größe in Bytes
+ */
+extern unsigned long long get_infile_size(void);
+
+/**
+ * Lässt das Betriebssystem die nächsten Bytes der Eingabedatei im
+ * Hintergrund in den Seitencache lesen, während die bisher gelesenen
+ * verarbeitet werden. Ohne Wirkung mit O_DIRECT und bei Pipes.
+ * @param size - Anzahl der Bytes ab der Leseposition
+ */
+extern void prefetch_infile(unsigned long long size);
+
+/**
+ * Kündigt an, dass die nächsten Bytes der Eingabedatei der Reihe nach
+ * gelesen werden. Mit set_io_pipelined() liest sie dann eine Lesestufe in
+ * einem eigenen Thread voraus, bis sie gelesen sind oder die Leseposition
+ * gesetzt wird; danach wird wieder direkt gelesen.
+ * @param size - Anzahl der Bytes ab der Leseposition
+ */
+extern void stream_infile(unsigned long long size);
+
+/**
+ * Füllt das angefangene Byte des Ausgabepuffers mit 0-Bits auf, sodass die
+ * nächste Ausgabe an einer Byte-Grenze beginnt.
+ */
+extern void align_out(void);
+
+/**
+ * Überspringt die restlichen Bits des angefangenen Bytes des Eingabepuffers,
+ * sodass die nächste Eingabe an einer Byte-Grenze beginnt.
+ */
+extern void align_in(void);
+
 /**
  * Gibt an, ob noch weitere Zeichen aus dem Eingabepuffer mit read_char()
  * gelesen werden können.
@@ -67,6 +242,16 @@ extern bool has_next_char(void);
  */
 extern unsigned char read_char(void);
 
+/**
+ * Liest bis zu count Zeichen aus der Eingabedatei in einen Speicherbereich.
+ * Ist der Eingabepuffer leer, werden ganze Puffergrößen direkt in den
+ * Speicherbereich gelesen.
+ * @param destination - Zielbereich
+ * @param count - Anzahl der zu lesenden Zeichen
+ * @return Anzahl der gelesenen Zeichen, weniger als count am Dateiende
+ */
+extern size_t read_chars(unsigned char *destination, size_t count);
+
 /**
  * Schreibt Zeichen an die nächste freie Position im Ausgabepuffer.
  * @param c - zu schreibendes Zeichen
@@ -74,16 +259,47 @@ extern unsigned char read_char(void);
 extern void write_char(unsigned char c);
 
 /**
- * Liefert den nächsten Integerwert aus dem Eingabepuffer.
- * @return den nächsten Integerwert
+ * Schreibt die Zeichen eines Speicherbereichs in die Ausgabedatei.
+ * Vorbedingung: Die Ausgabe beginnt an einer Byte-Grenze.
+ * @param source - Anfang des Speicherbereichs
+ * @param count - Anzahl der Zeichen
+ */
+extern void write_chars(const unsigned char *source, size_t count);
+
+/**
+ * Liefert die nächste variabel kodierte Ganzzahl (LEB128, 7 Bit je Byte,
+ * höchstwertiges Bit als Fortsetzungskennzeichen) aus dem Eingabepuffer.
+ * @return den nächsten 64-Bit-Wert
+ */
+extern unsigned long long read_varint(void);
+
+/**
+ * Gibt an, ob seit dem Öffnen der Eingabedatei bzw. dem Setzen der
+ * Leseposition eine mit read_varint() gelesene Ganzzahl unvollständig war,
+ * weil die Eingabedatei vorher endete, oder mehr als zehn Bytes belegte.
+ * @return Wahrheitswert
+ */
+extern bool has_varint_error(void);
+
+/**
+ * Schreibt Ganzzahl variabel kodiert (LEB128) an die nächste freie Position im
+ * Ausgabepuffer. Werte kleiner 128 belegen ein Byte, 64-Bit-Werte höchstens zehn.
+ * @param i - zu schreibender 64-Bit-Wert
+ */
+extern void write_varint(unsigned long long i);
+
+/**
+ * Liefert die Anzahl der bisher aus der Eingabedatei gelesenen Bytes.
+ * @return 64-Bit-Leseposition der Eingabedatei
  */
-extern unsigned int read_int(void);
+extern unsigned long long get_in_offset(void);
 
 /**
- * Schreibt Integerwert an die nächste freie Position im Ausgabepuffer.
- * @param i - zu schreibender Integerwert
+ * Liefert die Anzahl der bisher in die Ausgabedatei geschriebenen Bytes
+ * einschließlich der vollständigen Bytes im Ausgabepuffer.
+ * @return 64-Bit-Schreibposition der Ausgabedatei
  */
-extern void write_int(unsigned int i);
+extern unsigned long long get_out_offset(void);
 
 /**
  * Gibt an, ob noch weitere Bits aus dem Eingabepuffer gelesen werden können.
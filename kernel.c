@@ -0,0 +1,591 @@
+#include "kernel.h"
+#include "huffman.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+/**
+ * Gibt an, ob Varianten für x86-Befehlssatzerweiterungen übersetzt werden
+ */
+#define KERNEL_X86 1
+#else
+#define KERNEL_X86 0
+#endif
+
+/**
+ * Höchste Anzahl Zeichen, die in 32-Bit-Zählern gezählt wird, bevor diese
+ * in die 64-Bit-Häufigkeiten übernommen werden
+ */
+#define HISTOGRAM_CHUNK_SIZE ((size_t) 1 << 30)
+
+/**
+ * Körper eines Kerns, der in jede Variante eingesetzt und dort mit deren
+ * Befehlssatz übersetzt wird
+ */
+#define KERNEL_BODY static inline __attribute__((always_inline))
+
+/**
+ * Gewählte Kerne
+ */
+static KERNELS kernels;
+
+/**
+ * Sorgt dafür, dass die Kerne genau einmal gewählt werden
+ */
+static pthread_once_t kernels_once = PTHREAD_ONCE_INIT;
+
+/**
+ * Wählt die Kerne anhand der Befehlssatzerweiterungen des Prozessors.
+ */
+static void select_kernels(void);
+
+/**
+ * Zählt Häufigkeiten in vier Zählertabellen, sodass aufeinanderfolgende
+ * gleiche Zeichen nicht aufeinander warten.
+ * @param block - Anfang des Speicherbereichs
+ * @param block_size - Anzahl der Zeichen
+ * @param counts - Häufigkeiten je Zeichen, werden erhöht
+ */
+KERNEL_BODY void histogram_body(const unsigned char *block, size_t block_size, unsigned long long counts[])
+{
+    unsigned int partial_counts[4][NUM_OF_SYMBOLS];
+
+    while (block_size > 0)
+    {
+        size_t size = block_size < HISTOGRAM_CHUNK_SIZE ? block_size : HISTOGRAM_CHUNK_SIZE;
+        size_t i = 0;
+
+        memset(partial_counts, 0, sizeof(partial_counts));
+        for (; i + 8 <= size; i += 8)
+        {
+            unsigned long long word;
+            memcpy(&word, block + i, sizeof(word));
+            partial_counts[0][word & 0xFF]++;
+            partial_counts[1][(word >> 8) & 0xFF]++;
+            partial_counts[2][(word >> 16) & 0xFF]++;
+            partial_counts[3][(word >> 24) & 0xFF]++;
+            partial_counts[0][(word >> 32) & 0xFF]++;
+            partial_counts[1][(word >> 40) & 0xFF]++;
+            partial_counts[2][(word >> 48) & 0xFF]++;
+            partial_counts[3][word >> 56]++;
+        }
+        for (; i < size; i++)
+        {
+            partial_counts[0][block[i]]++;
+        }
+
+        for (int c = 0; c < NUM_OF_SYMBOLS; c++)
+        {
+            counts[c] += (unsigned long long) partial_counts[0][c] + partial_counts[1][c]
+                         + partial_counts[2][c] + partial_counts[3][c];
+        }
+        block += size;
+        block_size -= size;
+    }
+}
+
+/**
+ * Packt Codes über einen 64-Bit-Puffer, aus dem je 32 Bits auf einmal
+ * geschrieben werden.
+ * @param block - Anfang des Speicherbereichs
+ * @param block_size - Anzahl der Zeichen
+ * @param table - Codes der Zeichen
+ * @param destination - Ziel
+ * @return Anzahl der geschriebenen Bytes
+ */
+KERNEL_BODY size_t pack_body(const unsigned char *block, size_t block_size, const ENCODE_TABLE *table,
+                             unsigned char *destination)
+{
+    unsigned long long bit_buffer = 0;
+    unsigned int bit_count = 0;
+    size_t position = 0;
+
+    for (size_t i = 0; i < block_size; i++)
+    {
+        // at most 31 pending bits plus a code of at most 32 bits fit into the buffer
+        bit_buffer = bit_buffer << table->lengths[block[i]] | table->codes[block[i]];
+        bit_count += table->lengths[block[i]];
+        if (bit_count >= 32)
+        {
+            bit_count -= 32;
+            destination[position] = (unsigned char) (bit_buffer >> (bit_count + 24));
+            destination[position + 1] = (unsigned char) (bit_buffer >> (bit_count + 16));
+            destination[position + 2] = (unsigned char) (bit_buffer >> (bit_count + 8));
+            destination[position + 3] = (unsigned char) (bit_buffer >> bit_count);
+            position += 4;
+        }
+    }
+
+    // write pending bits, the last byte padded with 0-bits
+    while (bit_count >= 8)
+    {
+        bit_count -= 8;
+        destination[position++] = (unsigned char) (bit_buffer >> bit_count);
+    }
+    if (bit_count > 0)
+    {
+        destination[position++] = (unsigned char) (bit_buffer << (8 - bit_count));
+    }
+    return position;
+}
+
+/**
+ * Sucht den Code am Anfang eines linksbündigen Bitpuffers.
+ * @param bit_buffer - Bitpuffer
+ * @param table - Dekodiertabelle
+ * @return Eintrag des Codes, Länge 0, falls kein Code passt
+ */
+KERNEL_BODY DECODE_ENTRY lookup_code(unsigned long long bit_buffer, const DECODE_TABLE *table)
+{
+    DECODE_ENTRY entry = table->entries[bit_buffer >> (64 - DECODE_LOOKUP_BITS)];
+
+    if (entry.length == 0)
+    {
+        // long codes belong to rare chars, so a linear search is sufficient
+        for (unsigned int j = 0; j < table->long_count; j++)
+        {
+            if (bit_buffer >> (64 - table->long_entries[j].length) == table->long_codes[j])
+            {
+                return table->long_entries[j];
+            }
+        }
+    }
+    return entry;
+}
+
+/**
+ * Lädt 8 Bytes hinter die Bits eines linksbündigen Bitpuffers, sodass
+ * danach mindestens 56 Bits vorliegen.
+ * Vorbedingung: Ab position sind noch mindestens 8 Bytes lesbar.
+ * @param source - gepackte Codes
+ * @param position - Leseposition, wird um die ganz übernommenen Bytes erhöht
+ * @param bit_buffer - Bitpuffer
+ * @param bit_count - Anzahl der Bits im Bitpuffer
+ */
+KERNEL_BODY void refill_bits(const unsigned char *source, size_t *position, unsigned long long *bit_buffer,
+                             unsigned int *bit_count)
+{
+    unsigned long long word = 0;
+
+    // load 8 bytes behind the pending bits, but only count the whole bytes that fit
+    for (int j = 0; j < 8; j++)
+    {
+        word = word << 8 | source[*position + j];
+    }
+    *bit_buffer |= word >> *bit_count;
+    *position += (63 - *bit_count) >> 3;
+    *bit_count |= 56;
+}
+
+/**
+ * Dekodiert ein Zeichen aus einem Bitpuffer mit mindestens
+ * KERNEL_MAX_CODE_LENGTH Bits.
+ * @param bit_buffer - Bitpuffer, der Code wird entfernt
+ * @param bit_count - Anzahl der Bits im Bitpuffer
+ * @param table - Dekodiertabelle
+ * @param symbol - Ziel des Zeichens
+ * @return Wahrheitswert, ob ein Code passt
+ */
+KERNEL_BODY bool decode_symbol(unsigned long long *bit_buffer, unsigned int *bit_count, const DECODE_TABLE *table,
+                               unsigned char *symbol)
+{
+    // codes and escaped chars together are at most KERNEL_MAX_CODE_LENGTH bits
+    DECODE_ENTRY entry = lookup_code(*bit_buffer, table);
+    if (entry.length == 0)
+    {
+        return false;
+    }
+    *bit_buffer <<= entry.length;
+    *bit_count -= entry.length;
+
+    if (entry.symbol == ESCAPE_SYMBOL)
+    {
+        entry.symbol = (unsigned short) (*bit_buffer >> 56);
+        *bit_buffer <<= 8;
+        *bit_count -= 8;
+    }
+    *symbol = (unsigned char) entry.symbol;
+    return true;
+}
+
+/**
+ * Dekodiert gepackte Codes über einen linksbündigen 64-Bit-Puffer, der vor
+ * jedem Zeichen auf mindestens 56 Bits aufgefüllt wird. Solange 8 Bytes am
+ * Stück geladen werden können, reichen die Bits stets für einen Code samt
+ * Escape-Zeichen; erst für die letzten Bytes wird jeder Code gegen die
+ * vorhandenen Bits geprüft. Mit Einträgen mehrerer Zeichen liefert jeder
+ * Zugriff auf die Tabelle alle Zeichen der nächsten MULTI_LOOKUP_BITS Bits.
+ * @param source - gepackte Codes
+ * @param source_size - Anzahl der Bytes der gepackten Codes
+ * @param table - Dekodiertabelle
+ * @param destination - Ziel
+ * @param char_count - Anzahl zu dekodierender Zeichen
+ * @return Exit-Code
+ */
+KERNEL_BODY EXIT unpack_body(const unsigned char *source, size_t source_size, const DECODE_TABLE *table,
+                             unsigned char *destination, size_t char_count)
+{
+    unsigned long long bit_buffer = 0;
+    unsigned int bit_count = 0;
+    size_t position = 0;
+    size_t i = 0;
+
+    // every entry is stored whole, so four of them have to fit into the destination
+    while (table->has_multi_entries && char_count - i >= 4 * MULTI_LOOKUP_SYMBOLS && source_size - position >= 8)
+    {
+        int probes = 0;
+
+        refill_bits(source, &position, &bit_buffer, &bit_count);
+
+        // four probes consume at most 48 of the at least 56 bits
+        for (; probes < 4; probes++)
+        {
+            MULTI_DECODE_ENTRY entry = table->multi_entries[bit_buffer >> (64 - MULTI_LOOKUP_BITS)];
+            if (entry.count == 0)
+            {
+                break;
+            }
+            memcpy(destination + i, entry.symbols, MULTI_LOOKUP_SYMBOLS);
+            i += entry.count;
+            bit_buffer <<= entry.length;
+            bit_count -= entry.length;
+        }
+
+        // long codes and escaped chars are decoded one at a time from freshly loaded bits
+        if (probes == 0 && !decode_symbol(&bit_buffer, &bit_count, table, destination + i++))
+        {
+            return COMPRESSION_EXCEPTION;
+        }
+    }
+
+    for (; i < char_count && source_size - position >= 8; i++)
+    {
+        refill_bits(source, &position, &bit_buffer, &bit_count);
+        if (!decode_symbol(&bit_buffer, &bit_count, table, destination + i))
+        {
+            return COMPRESSION_EXCEPTION;
+        }
+    }
+
+    for (; i < char_count; i++)
+    {
+        DECODE_ENTRY entry;
+
+        while (bit_count <= 56 && position < source_size)
+        {
+            bit_buffer |= (unsigned long long) source[position++] << (56 - bit_count);
+            bit_count += 8;
+        }
+
+        entry = lookup_code(bit_buffer, table);
+        if (entry.length == 0 || entry.length > bit_count)
+        {
+            return COMPRESSION_EXCEPTION;
+        }
+        bit_buffer <<= entry.length;
+        bit_count -= entry.length;
+
+        if (entry.symbol == ESCAPE_SYMBOL)
+        {
+            // escaped char follows as plain bits
+            if (bit_count < 8)
+            {
+                return COMPRESSION_EXCEPTION;
+            }
+            entry.symbol = (unsigned short) (bit_buffer >> 56);
+            bit_buffer <<= 8;
+            bit_count -= 8;
+        }
+        destination[i] = (unsigned char) entry.symbol;
+    }
+    return SUCCESS;
+}
+
+/**
+ * Liest eine Lane als vorzeichenlose Little-Endian-Zahl.
+ * @param source - Anfang der Lane
+ * @param lane - Breite der Lane in Bytes
+ * @return Wert der Lane
+ */
+KERNEL_BODY unsigned long long load_lane(const unsigned char *source, size_t lane)
+{
+    unsigned long long value = 0;
+
+    // the byte order is the host's, which is little endian on all supported platforms
+    memcpy(&value, source, lane);
+    return value;
+}
+
+/**
+ * Filtert die Lanes eines Speicherbereichs mit fester Breite und
+ * Transformation. Jede Lane wird mit der ungefilterten vorherigen
+ * verrechnet, sodass die Lanes unabhängig voneinander und damit über
+ * Vektorbefehle gefiltert werden können.
+ * @param block - Anfang des Speicherbereichs
+ * @param block_size - Anzahl der Zeichen
+ * @param destination - Ziel
+ * @param lane - Breite einer Lane in Bytes
+ * @param transform - FILTER_DELTA, FILTER_XOR oder FILTER_NONE
+ * @param is_shuffled - Gibt an, ob die Bytes in Ebenen aufgeteilt werden
+ */
+KERNEL_BODY void filter_lanes_body(const unsigned char *block, size_t block_size, unsigned char *destination,
+                                   size_t lane, unsigned int transform, bool is_shuffled)
+{
+    size_t count = block_size / lane;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        unsigned long long value = load_lane(block + i * lane, lane);
+        unsigned long long previous = i > 0 ? load_lane(block + (i - 1) * lane, lane) : 0;
+
+        if (transform == FILTER_DELTA)
+        {
+            value -= previous;
+        }
+        else if (transform == FILTER_XOR)
+        {
+            value ^= previous;
+        }
+
+        if (is_shuffled)
+        {
+            for (size_t j = 0; j < lane; j++)
+            {
+                destination[j * count + i] = (unsigned char) (value >> 8 * j);
+            }
+        }
+        else
+        {
+            memcpy(destination + i * lane, &value, lane);
+        }
+    }
+    memcpy(destination + count * lane, block + count * lane, block_size - count * lane);
+}
+
+/**
+ * Macht die Filterung der Lanes eines Speicherbereichs mit fester Breite
+ * und Transformation rückgängig.
+ * @param source - gefilterter Speicherbereich
+ * @param block_size - Anzahl der Zeichen
+ * @param destination - Ziel
+ * @param lane - Breite einer Lane in Bytes
+ * @param transform - FILTER_DELTA, FILTER_XOR oder FILTER_NONE
+ * @param is_shuffled - Gibt an, ob die Bytes in Ebenen aufgeteilt sind
+ */
+KERNEL_BODY void unfilter_lanes_body(const unsigned char *source, size_t block_size, unsigned char *destination,
+                                     size_t lane, unsigned int transform, bool is_shuffled)
+{
+    size_t count = block_size / lane;
+    unsigned long long mask = lane < 8 ? (1ull << 8 * lane) - 1 : ~0ull;
+    unsigned long long previous = 0;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        unsigned long long value = 0;
+
+        if (is_shuffled)
+        {
+            for (size_t j = 0; j < lane; j++)
+            {
+                value |= (unsigned long long) source[j * count + i] << 8 * j;
+            }
+        }
+        else
+        {
+            value = load_lane(source + i * lane, lane);
+        }
+
+        // each lane depends on the one before, so this part stays serial
+        if (transform == FILTER_DELTA)
+        {
+            value = (value + previous) & mask;
+        }
+        else if (transform == FILTER_XOR)
+        {
+            value ^= previous;
+        }
+        memcpy(destination + i * lane, &value, lane);
+        previous = value;
+    }
+    memcpy(destination + count * lane, source + count * lane, block_size - count * lane);
+}
+
+/**
+ * Wählt für Filter und Umkehrung eine Schleife, in der Breite und
+ * Transformation Konstanten sind.
+ * @param source - Anfang des Speicherbereichs
+ * @param block_size - Anzahl der Zeichen
+ * @param filter - Filter
+ * @param destination - Ziel
+ * @param is_inverse - Gibt an, ob die Filterung rückgängig gemacht wird
+ */
+KERNEL_BODY void filter_body(const unsigned char *source, size_t block_size, unsigned int filter,
+                             unsigned char *destination, bool is_inverse)
+{
+    bool is_shuffled = (filter & FILTER_SHUFFLE) != 0;
+
+#define FILTER_LANES(LANE, TRANSFORM) \
+    (is_inverse ? unfilter_lanes_body(source, block_size, destination, LANE, TRANSFORM, is_shuffled) \
+                : filter_lanes_body(source, block_size, destination, LANE, TRANSFORM, is_shuffled))
+#define FILTER_TRANSFORMS(LANE) \
+    ((filter & FILTER_DELTA) ? FILTER_LANES(LANE, FILTER_DELTA) \
+     : (filter & FILTER_XOR) ? FILTER_LANES(LANE, FILTER_XOR) : FILTER_LANES(LANE, FILTER_NONE))
+
+    switch (filter & FILTER_LANE_MASK)
+    {
+        case 0:
+            FILTER_TRANSFORMS(1);
+            break;
+        case 1:
+            FILTER_TRANSFORMS(2);
+            break;
+        case 2:
+            FILTER_TRANSFORMS(4);
+            break;
+        default:
+            FILTER_TRANSFORMS(8);
+            break;
+    }
+
+#undef FILTER_TRANSFORMS
+#undef FILTER_LANES
+}
+
+static void histogram_scalar(const unsigned char *block, size_t block_size, unsigned long long counts[])
+{
+    histogram_body(block, block_size, counts);
+}
+
+static size_t pack_scalar(const unsigned char *block, size_t block_size, const ENCODE_TABLE *table,
+                          unsigned char *destination)
+{
+    return pack_body(block, block_size, table, destination);
+}
+
+static EXIT unpack_scalar(const unsigned char *source, size_t source_size, const DECODE_TABLE *table,
+                          unsigned char *destination, size_t char_count)
+{
+    return unpack_body(source, source_size, table, destination, char_count);
+}
+
+static void filter_scalar(const unsigned char *block, size_t block_size, unsigned int filter,
+                          unsigned char *destination)
+{
+    filter_body(block, block_size, filter, destination, false);
+}
+
+static void unfilter_scalar(const unsigned char *block, size_t block_size, unsigned int filter,
+                            unsigned char *destination)
+{
+    filter_body(block, block_size, filter, destination, true);
+}
+
+#if KERNEL_X86
+// variable shifts become shlx/shrx, which neither read nor write the flags
+__attribute__((target("bmi2")))
+static size_t pack_bmi2(const unsigned char *block, size_t block_size, const ENCODE_TABLE *table,
+                        unsigned char *destination)
+{
+    return pack_body(block, block_size, table, destination);
+}
+
+__attribute__((target("bmi2")))
+static EXIT unpack_bmi2(const unsigned char *source, size_t source_size, const DECODE_TABLE *table,
+                        unsigned char *destination, size_t char_count)
+{
+    return unpack_body(source, source_size, table, destination, char_count);
+}
+#endif
+
+extern const KERNELS *get_kernels(void)
+{
+    pthread_once(&kernels_once, select_kernels);
+    return &kernels;
+}
+
+extern size_t get_packed_bound(size_t block_size)
+{
+    return block_size * (KERNEL_MAX_CODE_LENGTH / 8) + 8;
+}
+
+extern void build_multi_entries(DECODE_TABLE *table)
+{
+    for (unsigned int index = 0; index < 1u << MULTI_LOOKUP_BITS; index++)
+    {
+        MULTI_DECODE_ENTRY *multi = &table->multi_entries[index];
+        unsigned int bits = index;
+        unsigned int bit_count = MULTI_LOOKUP_BITS;
+
+        multi->count = 0;
+        multi->length = 0;
+        memset(multi->symbols, 0, sizeof(multi->symbols));
+
+        // take codes while they lie completely in the index, an escaped char ends the entry
+        while (multi->count < MULTI_LOOKUP_SYMBOLS)
+        {
+            unsigned int lookup = bit_count >= DECODE_LOOKUP_BITS ? bits >> (bit_count - DECODE_LOOKUP_BITS)
+                                                                  : bits << (DECODE_LOOKUP_BITS - bit_count);
+            DECODE_ENTRY entry = table->entries[lookup & ((1u << DECODE_LOOKUP_BITS) - 1)];
+
+            if (entry.length == 0 || entry.length > bit_count || entry.symbol == ESCAPE_SYMBOL)
+            {
+                break;
+            }
+            multi->symbols[multi->count++] = (unsigned char) entry.symbol;
+            multi->length = (unsigned char) (multi->length + entry.length);
+            bit_count -= entry.length;
+            bits &= (1u << bit_count) - 1;
+        }
+    }
+    table->has_multi_entries = true;
+}
+
+extern bool is_valid_filter(unsigned int filter)
+{
+    unsigned int transform = filter & (FILTER_DELTA | FILTER_XOR);
+
+    if (filter > (FILTER_LANE_MASK | FILTER_DELTA | FILTER_XOR | FILTER_SHUFFLE)
+        || transform == (FILTER_DELTA | FILTER_XOR))
+    {
+        return false;
+    }
+
+    // shuffling single bytes changes nothing
+    return transform != FILTER_NONE || (filter & FILTER_SHUFFLE && filter & FILTER_LANE_MASK);
+}
+
+extern void print_kernels(void)
+{
+    const KERNELS *selected = get_kernels();
+    printf(" - Kerne: Häufigkeiten %s, Packen %s, Dekodieren %s, Filter %s\n",
+           selected->histogram_name, selected->pack_name, selected->unpack_name, selected->filter_name);
+}
+
+static void select_kernels(void)
+{
+    kernels = (KERNELS) {
+            .histogram = histogram_scalar,
+            .pack = pack_scalar,
+            .unpack = unpack_scalar,
+            .filter = filter_scalar,
+            .unfilter = unfilter_scalar,
+            .histogram_name = "scalar",
+            .pack_name = "scalar",
+            .unpack_name = "scalar",
+            .filter_name = "scalar"
+    };
+
+#if KERNEL_X86
+    __builtin_cpu_init();
+
+    // the bit kernels are serial, flagless shifts help them more than wide vectors; histogram and
+    // filters have no variant, compiled for other extensions their loops would stay the same
+    if (__builtin_cpu_supports("bmi2"))
+    {
+        kernels.pack = pack_bmi2;
+        kernels.unpack = unpack_bmi2;
+        kernels.pack_name = kernels.unpack_name = "bmi2";
+    }
+#endif
+}
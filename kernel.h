@@ -0,0 +1,285 @@
+/**
+ * @file
+ * Dieses Modul stellt die rechenintensiven Kerne des Codecs (Häufigkeiten
+ * zählen, Codes zu Bits packen, Bits über eine Tabelle dekodieren) zur
+ * Verfügung, Packen und Dekodieren in mehreren Varianten. Beim ersten
+ * Aufruf von get_kernels() wird per cpuid die schnellste Variante gewählt,
+ * die der Prozessor unterstützt, sodass dasselbe Programm auf allen
+ * Prozessoren läuft.
+ *
+ * Die Kerne arbeiten auf Speicherbereichen. Codes werden mit dem
+ * höchstwertigen Bit zuerst gepackt, wie bei write_bit().
+ *
+ * Filter bereiten Felder ganzer Zahlen oder Gleitkommazahlen fester Breite
+ * (Lanes) vor: Differenzen oder XOR benachbarter Lanes machen aus langsam
+ * veränderlichen Werten kleine, und das Aufteilen in Byte-Ebenen (Shuffle
+ * wie bei blosc) legt gleichwertige Bytes aller Lanes hintereinander.
+ *
+ * @author  Tim Ostermann
+ * @date    2020-12-05
+ */
+
+#ifndef HUFFMAN_KERNEL_H
+#define HUFFMAN_KERNEL_H
+
+#include "huffman_common.h"
+#include <stddef.h>
+
+/**
+ * Höchste Codelänge (einschließlich Escape-Code und Zeichen), mit der die
+ * Kerne arbeiten können
+ */
+#define KERNEL_MAX_CODE_LENGTH 32
+
+/**
+ * Anzahl der Bits, über die die Dekodiertabelle direkt indiziert wird
+ */
+#define DECODE_LOOKUP_BITS 11
+
+/**
+ * Anzahl der Bits, über die die Einträge mit mehreren Zeichen indiziert werden
+ */
+#define MULTI_LOOKUP_BITS 12
+
+/**
+ * Höchste Anzahl Zeichen eines Eintrags mit mehreren Zeichen
+ */
+#define MULTI_LOOKUP_SYMBOLS 4
+
+/**
+ * Bits eines Filters mit dem Zweierlogarithmus der Breite einer Lane (1 bis 8 Bytes)
+ */
+#define FILTER_LANE_MASK 0x03
+
+/**
+ * Filter: Differenz zur vorherigen Lane als vorzeichenlose Little-Endian-Zahl
+ */
+#define FILTER_DELTA 0x04
+
+/**
+ * Filter: XOR mit der vorherigen Lane
+ */
+#define FILTER_XOR 0x08
+
+/**
+ * Filter: Bytes nach ihrer Position in der Lane in Ebenen aufteilen
+ */
+#define FILTER_SHUFFLE 0x10
+
+/**
+ * Kein Filter
+ */
+#define FILTER_NONE 0x00
+
+/**
+ * Codes aller Zeichen zum Packen
+ */
+typedef struct
+{
+    /**
+     * Code je Zeichen, rechtsbündig
+     */
+    unsigned int codes[NUM_OF_SYMBOLS];
+
+    /**
+     * Codelänge je Zeichen, 0 für nicht kodierbare Zeichen
+     */
+    unsigned char lengths[NUM_OF_SYMBOLS];
+} ENCODE_TABLE;
+
+/**
+ * Eintrag der Dekodiertabelle
+ */
+typedef struct
+{
+    /**
+     * Dekodiertes Symbol, ESCAPE_SYMBOL, wenn die 8 Bits des Zeichens folgen
+     */
+    unsigned short symbol;
+
+    /**
+     * Codelänge, 0 für Codes, die länger als DECODE_LOOKUP_BITS sind
+     */
+    unsigned char length;
+} DECODE_ENTRY;
+
+/**
+ * Eintrag der Dekodiertabelle mit allen Zeichen, deren Codes vollständig in
+ * den nächsten MULTI_LOOKUP_BITS Bits liegen. Er ist auf 8 Bytes
+ * ausgerichtet, sodass er mit einem Zugriff geladen wird.
+ */
+typedef struct __attribute__((aligned(8)))
+{
+    /**
+     * Dekodierte Zeichen, hinter den gültigen beliebig
+     */
+    unsigned char symbols[MULTI_LOOKUP_SYMBOLS];
+
+    /**
+     * Anzahl der Zeichen, 0, wenn der erste Code länger ist oder ein
+     * Zeichen escapet
+     */
+    unsigned char count;
+
+    /**
+     * Summe der Codelängen der Zeichen
+     */
+    unsigned char length;
+} MULTI_DECODE_ENTRY;
+
+/**
+ * Tabelle zum Dekodieren
+ */
+typedef struct
+{
+    /**
+     * Einträge, indiziert über die nächsten DECODE_LOOKUP_BITS Bits
+     */
+    DECODE_ENTRY entries[1 << DECODE_LOOKUP_BITS];
+
+    /**
+     * Codes, die länger als DECODE_LOOKUP_BITS sind, rechtsbündig
+     */
+    unsigned int long_codes[NUM_OF_SYMBOLS + 1];
+
+    /**
+     * Symbole und Längen der langen Codes
+     */
+    DECODE_ENTRY long_entries[NUM_OF_SYMBOLS + 1];
+
+    /**
+     * Anzahl der langen Codes
+     */
+    unsigned int long_count;
+
+    /**
+     * Einträge mit mehreren Zeichen, indiziert über die nächsten
+     * MULTI_LOOKUP_BITS Bits
+     */
+    MULTI_DECODE_ENTRY multi_entries[1 << MULTI_LOOKUP_BITS];
+
+    /**
+     * Gibt an, ob die Einträge mit mehreren Zeichen aufgebaut sind
+     */
+    bool has_multi_entries;
+} DECODE_TABLE;
+
+/**
+ * Zählt die Häufigkeiten der Zeichen eines Speicherbereichs.
+ * @param block - Anfang des Speicherbereichs
+ * @param block_size - Anzahl der Zeichen
+ * @param counts - Häufigkeiten je Zeichen, werden erhöht
+ */
+typedef void (*HISTOGRAM_KERNEL) (const unsigned char *block, size_t block_size, unsigned long long counts[]);
+
+/**
+ * Packt die Codes der Zeichen eines Speicherbereichs. Das letzte Byte wird
+ * mit 0-Bits aufgefüllt.
+ * @param block - Anfang des Speicherbereichs
+ * @param block_size - Anzahl der Zeichen
+ * @param table - Codes der Zeichen, alle höchstens KERNEL_MAX_CODE_LENGTH lang
+ * @param destination - Ziel, mindestens get_packed_bound(block_size) Bytes groß
+ * @return Anzahl der geschriebenen Bytes
+ */
+typedef size_t (*PACK_KERNEL) (const unsigned char *block, size_t block_size, const ENCODE_TABLE *table,
+                               unsigned char *destination);
+
+/**
+ * Dekodiert gepackte Codes in einen Speicherbereich.
+ * @param source - gepackte Codes
+ * @param source_size - Anzahl der Bytes der gepackten Codes
+ * @param table - Dekodiertabelle
+ * @param destination - Ziel
+ * @param char_count - Anzahl zu dekodierender Zeichen
+ * @return COMPRESSION_EXCEPTION, falls die gepackten Codes vorher enden
+ */
+typedef EXIT (*UNPACK_KERNEL) (const unsigned char *source, size_t source_size, const DECODE_TABLE *table,
+                               unsigned char *destination, size_t char_count);
+
+/**
+ * Filtert einen Speicherbereich. Bytes hinter der letzten vollständigen
+ * Lane bleiben unverändert am Ende.
+ * @param block - Anfang des Speicherbereichs
+ * @param block_size - Anzahl der Zeichen
+ * @param filter - Filter, siehe is_valid_filter()
+ * @param destination - Ziel, darf sich nicht mit dem Speicherbereich überschneiden
+ */
+typedef void (*FILTER_KERNEL) (const unsigned char *block, size_t block_size, unsigned int filter,
+                               unsigned char *destination);
+
+/**
+ * Gewählte Varianten der Kerne
+ */
+typedef struct
+{
+    /**
+     * Häufigkeiten zählen
+     */
+    HISTOGRAM_KERNEL histogram;
+
+    /**
+     * Codes packen
+     */
+    PACK_KERNEL pack;
+
+    /**
+     * Gepackte Codes dekodieren
+     */
+    UNPACK_KERNEL unpack;
+
+    /**
+     * Filter anwenden
+     */
+    FILTER_KERNEL filter;
+
+    /**
+     * Filter rückgängig machen
+     */
+    FILTER_KERNEL unfilter;
+
+    /**
+     * Namen der gewählten Varianten
+     */
+    const char *histogram_name;
+    const char *pack_name;
+    const char *unpack_name;
+    const char *filter_name;
+} KERNELS;
+
+/**
+ * Liefert die für den Prozessor gewählten Kerne. Die Wahl erfolgt beim
+ * ersten Aufruf, auch bei gleichzeitigen Aufrufen aus mehreren Threads.
+ * @return gewählte Kerne
+ */
+extern const KERNELS *get_kernels(void);
+
+/**
+ * Liefert die Größe, die gepackte Codes eines Speicherbereichs höchstens
+ * belegen.
+ * @param block_size - Anzahl der Zeichen
+ * @return Anzahl Bytes
+ */
+extern size_t get_packed_bound(size_t block_size);
+
+/**
+ * Baut die Einträge mit mehreren Zeichen aus den übrigen Einträgen einer
+ * Dekodiertabelle auf. Das lohnt sich erst für Speicherbereiche, die
+ * deutlich mehr Zeichen haben, als es Einträge gibt.
+ * @param table - Dekodiertabelle
+ */
+extern void build_multi_entries(DECODE_TABLE *table);
+
+/**
+ * Prüft, ob ein Filter bekannt ist und die Daten verändert.
+ * @param filter - Filter aus FILTER_DELTA oder FILTER_XOR, FILTER_SHUFFLE und
+ * dem Zweierlogarithmus der Breite einer Lane
+ * @return Wahrheitswert
+ */
+extern bool is_valid_filter(unsigned int filter);
+
+/**
+ * Gibt die gewählten Kerne auf dem Bildschirm aus.
+ */
+extern void print_kernels(void);
+
+#endif //HUFFMAN_KERNEL_H
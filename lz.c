@@ -0,0 +1,549 @@
+#include "lz.h"
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/**
+ * Anzahl der Bits des Hashwerts, über den Positionen mit gleichen ersten
+ * LZ_MIN_MATCH Zeichen verkettet werden
+ */
+#define HASH_BITS 16
+
+/**
+ * Anzahl der Hashwerte
+ */
+#define HASH_SIZE (1 << HASH_BITS)
+
+/**
+ * Größter Wert, der direkt als Code steht
+ */
+#define DIRECT_CODE_COUNT 16
+
+/**
+ * Suchaufwand eines Komprimierungslevels
+ */
+typedef struct
+{
+    /**
+     * Anzahl der früheren Positionen, die höchstens verglichen werden
+     */
+    unsigned int chain_length;
+
+    /**
+     * Länge, ab der ein Verweis ohne weitere Suche genommen wird
+     */
+    size_t nice_length;
+
+    /**
+     * Gibt an, ob vor einem Verweis geprüft wird, ob an der nächsten
+     * Position ein längerer beginnt
+     */
+    bool is_lazy;
+} EFFORT;
+
+/**
+ * Schreibt Bits, das höchstwertige zuerst
+ */
+typedef struct
+{
+    /**
+     * Ziel
+     */
+    unsigned char *destination;
+
+    /**
+     * Anzahl der geschriebenen Bytes
+     */
+    size_t position;
+
+    /**
+     * Noch nicht geschriebene Bits in den niedrigsten Stellen
+     */
+    unsigned long long bit_buffer;
+
+    /**
+     * Anzahl der noch nicht geschriebenen Bits
+     */
+    unsigned int bit_count;
+} BIT_WRITER;
+
+/**
+ * Suchaufwand je Komprimierungslevel 1 bis 9
+ */
+static const EFFORT efforts[] = {
+        {4,    16,   false},
+        {8,    32,   false},
+        {16,   32,   false},
+        {16,   64,   true},
+        {32,   128,  true},
+        {64,   128,  true},
+        {128,  256,  true},
+        {256,  512,  true},
+        {1024, 1024, true}
+};
+
+/**
+ * Letzte Position je Hashwert, um 1 erhöht, 0 für keine
+ */
+static _Thread_local unsigned int *head;
+
+/**
+ * Vorherige Position mit gleichem Hashwert je Position, um 1 erhöht
+ */
+static _Thread_local unsigned int *chain;
+
+/**
+ * Speicher für die Literale eines Blocks
+ */
+static _Thread_local unsigned char *literal_buffer;
+
+/**
+ * Speicher für die drei Arten von Codes eines Blocks, nacheinander
+ */
+static _Thread_local unsigned char *code_buffer;
+
+/**
+ * Speicher für die unkodierten Bits eines Blocks, mit 8 Bytes Reserve
+ */
+static _Thread_local unsigned char *extra_buffer;
+
+/**
+ * Größter Block, für den der Speicher reserviert ist
+ */
+static _Thread_local size_t capacity;
+
+/**
+ * Reserviert den Speicher für einen Block, falls noch nicht geschehen.
+ * @param block_size - Anzahl der Zeichen
+ * @param is_parsing - Gibt an, ob auch der Speicher zum Zerlegen nötig ist
+ */
+static void reserve_buffers(size_t block_size, bool is_parsing);
+
+/**
+ * Liefert den Hashwert der ersten LZ_MIN_MATCH Zeichen.
+ * @param block - Zeichen
+ * @return Hashwert
+ */
+static inline unsigned int get_hash(const unsigned char *block);
+
+/**
+ * Trägt eine Position in ihre Kette ein.
+ * @param block - Anfang des Blocks
+ * @param position - Position
+ */
+static inline void insert_position(const unsigned char *block, size_t position);
+
+/**
+ * Sucht den längsten Verweis für eine Position in der Kette ihres
+ * Hashwerts, die Position selbst ist noch nicht eingetragen.
+ * @param block - Anfang des Blocks
+ * @param position - Position
+ * @param block_size - Anzahl der Zeichen des Blocks
+ * @param effort - Suchaufwand
+ * @param window_size - größter Abstand
+ * @param distance - Übergabeparameter für den Abstand
+ * @return Länge des Verweises, kleiner LZ_MIN_MATCH für keinen
+ */
+static inline size_t find_match(const unsigned char *block, size_t position, size_t block_size,
+                                const EFFORT *effort, size_t window_size, size_t *distance);
+
+/**
+ * Liefert die Anzahl gleicher Zeichen am Anfang zweier Speicherbereiche.
+ * @param first - erster Speicherbereich
+ * @param second - zweiter Speicherbereich
+ * @param max_length - höchste Anzahl
+ * @return Anzahl
+ */
+static inline size_t get_match_length(const unsigned char *first, const unsigned char *second, size_t max_length);
+
+/**
+ * Übersetzt einen Wert in seinen Code und schreibt die übrigen Bits.
+ * @param value - Wert
+ * @param writer - Ziel der übrigen Bits
+ * @return Code
+ */
+static inline unsigned char encode_value(size_t value, BIT_WRITER *writer);
+
+/**
+ * Liest den Wert zu einem Code.
+ * @param code - Code
+ * @param extra_bits - unkodierte Bits, mit 8 Bytes Reserve
+ * @param bit_limit - Anzahl der unkodierten Bits
+ * @param bit_position - Position des nächsten Bits, wird erhöht
+ * @param value - Übergabeparameter für den Wert
+ * @return Wahrheitswert, ob der Code gültig ist und seine Bits vorhanden sind
+ */
+static inline bool decode_value(unsigned char code, const unsigned char *extra_bits, unsigned long long bit_limit,
+                                unsigned long long *bit_position, size_t *value);
+
+/**
+ * Kopiert einen Verweis, der sich mit seinem Ziel überschneiden darf.
+ * @param destination - Ziel
+ * @param distance - Abstand der Quelle
+ * @param length - Länge
+ */
+static inline void copy_match(unsigned char *destination, size_t distance, size_t length);
+
+/**
+ * Liefert die Position des höchsten gesetzten Bits.
+ * @param value - Wert größer 0
+ * @return Position, 0 für das niedrigste Bit
+ */
+static inline unsigned int get_highest_bit(size_t value);
+
+extern void lz_parse(const unsigned char *block, size_t block_size, int level, size_t window_size,
+                     LZ_SEQUENCES *sequences)
+{
+    const EFFORT *effort = &efforts[level < 1 ? 0 : level > 9 ? 8 : level - 1];
+    BIT_WRITER writer = {.position = 0, .bit_buffer = 0, .bit_count = 0};
+    size_t position = 0;
+    size_t anchor = 0;
+
+    reserve_buffers(block_size, true);
+    lz_get_buffers(block_size, sequences);
+    writer.destination = sequences->extra_bits;
+    memset(head, 0, sizeof(unsigned int) * HASH_SIZE);
+
+    while (position + LZ_MIN_MATCH <= block_size)
+    {
+        size_t distance = 0;
+        size_t length = find_match(block, position, block_size, effort, window_size, &distance);
+        size_t index = sequences->sequence_count;
+
+        insert_position(block, position);
+        if (length < LZ_MIN_MATCH)
+        {
+            position++;
+            continue;
+        }
+
+        // a longer match starting at the next position is worth a literal
+        while (effort->is_lazy && length < effort->nice_length && position + 1 + LZ_MIN_MATCH <= block_size)
+        {
+            size_t next_distance = 0;
+            size_t next_length = find_match(block, position + 1, block_size, effort, window_size, &next_distance);
+            if (next_length <= length)
+            {
+                break;
+            }
+            insert_position(block, position + 1);
+            position++;
+            length = next_length;
+            distance = next_distance;
+        }
+
+        // literals before the match, then the sequence with the extra bits in the same order
+        memcpy(sequences->literals + sequences->literal_count, block + anchor, position - anchor);
+        sequences->literal_count += position - anchor;
+        sequences->run_codes[index] = encode_value(position - anchor, &writer);
+        sequences->length_codes[index] = encode_value(length - LZ_MIN_MATCH, &writer);
+        sequences->distance_codes[index] = encode_value(distance - 1, &writer);
+        sequences->sequence_count++;
+
+        // the positions inside the match are candidates for later matches
+        for (size_t i = position + 1; i < position + length && i + LZ_MIN_MATCH <= block_size; i++)
+        {
+            insert_position(block, i);
+        }
+        position += length;
+        anchor = position;
+    }
+
+    // the trailing literals need no sequence, their number follows from the block size
+    memcpy(sequences->literals + sequences->literal_count, block + anchor, block_size - anchor);
+    sequences->literal_count += block_size - anchor;
+
+    sequences->extra_bit_count = (unsigned long long) writer.position * 8 + writer.bit_count;
+    if (writer.bit_count > 0)
+    {
+        writer.destination[writer.position] = (unsigned char) (writer.bit_buffer << (8 - writer.bit_count));
+    }
+}
+
+extern void lz_get_buffers(size_t block_size, LZ_SEQUENCES *sequences)
+{
+    size_t max_sequences = lz_get_max_sequences(block_size);
+
+    reserve_buffers(block_size, false);
+    sequences->literals = literal_buffer;
+    sequences->literal_count = 0;
+    sequences->run_codes = code_buffer;
+    sequences->length_codes = code_buffer + max_sequences;
+    sequences->distance_codes = code_buffer + 2 * max_sequences;
+    sequences->sequence_count = 0;
+    sequences->extra_bits = extra_buffer;
+    sequences->extra_bit_count = 0;
+}
+
+extern size_t lz_get_max_sequences(size_t block_size)
+{
+    // every sequence covers at least one match
+    return block_size / LZ_MIN_MATCH;
+}
+
+extern size_t lz_get_extra_bound(size_t block_size)
+{
+    // no value exceeds the block size, so each has at most its highest bit minus 1 extra bits
+    unsigned int bit_count = block_size >= DIRECT_CODE_COUNT ? get_highest_bit(block_size) - 1 : 0;
+    return (lz_get_max_sequences(block_size) * 3 * bit_count + 7) / 8;
+}
+
+extern EXIT lz_decode(const LZ_SEQUENCES *sequences, size_t extra_size, unsigned char *destination,
+                      size_t block_size)
+{
+    unsigned long long bit_limit = (unsigned long long) extra_size * 8;
+    unsigned long long bit_position = 0;
+    size_t literal_position = 0;
+    size_t position = 0;
+
+    for (size_t i = 0; i < sequences->sequence_count; i++)
+    {
+        size_t run;
+        size_t length;
+        size_t distance;
+
+        if (!decode_value(sequences->run_codes[i], sequences->extra_bits, bit_limit, &bit_position, &run)
+            || !decode_value(sequences->length_codes[i], sequences->extra_bits, bit_limit, &bit_position, &length)
+            || !decode_value(sequences->distance_codes[i], sequences->extra_bits, bit_limit, &bit_position, &distance))
+        {
+            return COMPRESSION_EXCEPTION;
+        }
+        length += LZ_MIN_MATCH;
+        distance++;
+
+        // the sequence has to stay within the literals and the block, the match within the decoded chars
+        if (run > sequences->literal_count - literal_position || run > block_size - position
+            || length > block_size - position - run || distance > position + run)
+        {
+            return COMPRESSION_EXCEPTION;
+        }
+
+        memcpy(destination + position, sequences->literals + literal_position, run);
+        literal_position += run;
+        position += run;
+        copy_match(destination + position, distance, length);
+        position += length;
+    }
+
+    // the trailing literals fill the rest of the block, all extra bits are used up
+    if (sequences->literal_count - literal_position != block_size - position || (bit_position + 7) / 8 != extra_size)
+    {
+        return COMPRESSION_EXCEPTION;
+    }
+    memcpy(destination + position, sequences->literals + literal_position, block_size - position);
+    return SUCCESS;
+}
+
+extern unsigned long long lz_get_memory(size_t block_size, bool is_parsing)
+{
+    unsigned long long memory = block_size + 3 * lz_get_max_sequences(block_size) + lz_get_extra_bound(block_size) + 8;
+
+    if (is_parsing)
+    {
+        memory += sizeof(unsigned int) * ((unsigned long long) HASH_SIZE + block_size);
+    }
+    return memory;
+}
+
+extern void lz_free(void)
+{
+    free(head);
+    head = NULL;
+    free(chain);
+    chain = NULL;
+    free(literal_buffer);
+    literal_buffer = NULL;
+    free(code_buffer);
+    code_buffer = NULL;
+    free(extra_buffer);
+    extra_buffer = NULL;
+    capacity = 0;
+}
+
+static void reserve_buffers(size_t block_size, bool is_parsing)
+{
+    if (block_size > capacity)
+    {
+        // a larger block needs new buffers for everything
+        lz_free();
+        literal_buffer = (unsigned char *) malloc(block_size);
+        code_buffer = (unsigned char *) malloc(3 * lz_get_max_sequences(block_size));
+        extra_buffer = (unsigned char *) malloc(lz_get_extra_bound(block_size) + 8);
+        capacity = block_size;
+    }
+    if (is_parsing && chain == NULL)
+    {
+        head = (unsigned int *) malloc(sizeof(unsigned int) * HASH_SIZE);
+        chain = (unsigned int *) malloc(sizeof(unsigned int) * capacity);
+    }
+    if (literal_buffer == NULL || code_buffer == NULL || extra_buffer == NULL
+        || (is_parsing && (head == NULL || chain == NULL)))
+    {
+        printf("Fehler bei der Speicherreservierung.");
+        exit(1);
+    }
+}
+
+static inline unsigned int get_hash(const unsigned char *block)
+{
+    unsigned int word;
+
+    memcpy(&word, block, sizeof(word));
+    return (word * 2654435761u) >> (32 - HASH_BITS);
+}
+
+static inline void insert_position(const unsigned char *block, size_t position)
+{
+    unsigned int hash = get_hash(block + position);
+
+    chain[position] = head[hash];
+    head[hash] = (unsigned int) position + 1;
+}
+
+static inline size_t find_match(const unsigned char *block, size_t position, size_t block_size,
+                                const EFFORT *effort, size_t window_size, size_t *distance)
+{
+    size_t max_length = block_size - position;
+    size_t best_length = 0;
+    unsigned int candidate = head[get_hash(block + position)];
+
+    for (unsigned int i = 0; i < effort->chain_length && candidate != 0; i++)
+    {
+        size_t match = candidate - 1;
+
+        // the chain runs backwards, so all further positions are out of the window as well
+        if (position - match > window_size)
+        {
+            break;
+        }
+
+        // a longer match has to agree at the end of the best one first
+        if (block[match + best_length] == block[position + best_length])
+        {
+            size_t length = get_match_length(block + match, block + position, max_length);
+            if (length > best_length)
+            {
+                best_length = length;
+                *distance = position - match;
+                if (length >= effort->nice_length || length == max_length)
+                {
+                    break;
+                }
+            }
+        }
+        candidate = chain[match];
+    }
+    return best_length;
+}
+
+static inline size_t get_match_length(const unsigned char *first, const unsigned char *second, size_t max_length)
+{
+    size_t length = 0;
+
+    // compare 8 chars at a time, on little endian the lowest differing bit is in the first differing char
+    while (length + 8 <= max_length)
+    {
+        unsigned long long first_word;
+        unsigned long long second_word;
+
+        memcpy(&first_word, first + length, sizeof(first_word));
+        memcpy(&second_word, second + length, sizeof(second_word));
+        if (first_word != second_word)
+        {
+            return length + (size_t) (__builtin_ctzll(first_word ^ second_word) >> 3);
+        }
+        length += 8;
+    }
+    while (length < max_length && first[length] == second[length])
+    {
+        length++;
+    }
+    return length;
+}
+
+static inline unsigned char encode_value(size_t value, BIT_WRITER *writer)
+{
+    unsigned int highest_bit;
+    unsigned int bit_count;
+
+    if (value < DIRECT_CODE_COUNT)
+    {
+        return (unsigned char) value;
+    }
+
+    // two codes per highest bit, told apart by the bit below it
+    highest_bit = get_highest_bit(value);
+    bit_count = highest_bit - 1;
+    writer->bit_buffer = writer->bit_buffer << bit_count | (value & ((1u << bit_count) - 1));
+    writer->bit_count += bit_count;
+    while (writer->bit_count >= 8)
+    {
+        writer->bit_count -= 8;
+        writer->destination[writer->position++] = (unsigned char) (writer->bit_buffer >> writer->bit_count);
+    }
+    return (unsigned char) (DIRECT_CODE_COUNT + 2 * (highest_bit - 4) + (value >> bit_count & 1));
+}
+
+static inline bool decode_value(unsigned char code, const unsigned char *extra_bits, unsigned long long bit_limit,
+                                unsigned long long *bit_position, size_t *value)
+{
+    const unsigned char *bytes = extra_bits + (*bit_position >> 3);
+    unsigned long long word = 0;
+    unsigned int bit_count;
+
+    if (code < DIRECT_CODE_COUNT)
+    {
+        *value = code;
+        return true;
+    }
+    bit_count = (code - DIRECT_CODE_COUNT) / 2 + 3;
+    if (code >= LZ_CODE_COUNT || bit_count > bit_limit - *bit_position)
+    {
+        return false;
+    }
+
+    // big endian, compilers turn this into a single load
+    for (int i = 0; i < 8; i++)
+    {
+        word = word << 8 | bytes[i];
+    }
+    *value = (size_t) (2 | (code & 1)) << bit_count | (size_t) (word << (*bit_position & 7) >> (64 - bit_count));
+    *bit_position += bit_count;
+    return true;
+}
+
+static inline void copy_match(unsigned char *destination, size_t distance, size_t length)
+{
+    const unsigned char *source = destination - distance;
+
+    if (distance >= length)
+    {
+        memcpy(destination, source, length);
+        return;
+    }
+    if (distance == 1)
+    {
+        memset(destination, *source, length);
+        return;
+    }
+
+    // overlapping: chunks no longer than the distance read only chars written before
+    if (distance >= 8)
+    {
+        for (; length >= 8; length -= 8)
+        {
+            memcpy(destination, source, 8);
+            destination += 8;
+            source += 8;
+        }
+    }
+    while (length-- > 0)
+    {
+        *destination++ = *source++;
+    }
+}
+
+static inline unsigned int get_highest_bit(size_t value)
+{
+    return 63 - (unsigned int) __builtin_clzll(value);
+}
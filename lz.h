@@ -0,0 +1,139 @@
+/**
+ * @file
+ * Dieses Modul implementiert eine LZ77-Vorstufe: Wiederholungen innerhalb
+ * eines Blocks werden durch Verweise (Länge und Abstand) auf frühere
+ * Zeichen ersetzt. Übrig bleiben Sequenzen aus einer Anzahl Literale, auf
+ * die ein Verweis folgt, sowie die Literale selbst.
+ *
+ * Anzahlen, Längen und Abstände werden in Codes übersetzt: Werte unter 16
+ * direkt, größere über die Position ihres höchsten Bits und das Bit
+ * darunter, die übrigen Bits folgen unkodiert. Literale und die drei Arten
+ * von Codes bilden je ein eigenes Alphabet, das wie einzelne Zeichen
+ * Huffman-kodiert wird.
+ *
+ * @author  Tim Ostermann
+ * @date    2020-12-05
+ */
+
+#ifndef HUFFMAN_LZ_H
+#define HUFFMAN_LZ_H
+
+#include "huffman_common.h"
+#include <stddef.h>
+
+/**
+ * Kürzeste Länge eines Verweises
+ */
+#define LZ_MIN_MATCH 4
+
+/**
+ * Anzahl der Codes, über die jeder Wert eines Blocks ausgedrückt werden kann
+ */
+#define LZ_CODE_COUNT 48
+
+/**
+ * Sequenzen eines Blocks
+ */
+typedef struct
+{
+    /**
+     * Literale in Reihenfolge
+     */
+    unsigned char *literals;
+
+    /**
+     * Anzahl der Literale
+     */
+    size_t literal_count;
+
+    /**
+     * Code der Anzahl Literale vor dem Verweis je Sequenz
+     */
+    unsigned char *run_codes;
+
+    /**
+     * Code der Länge des Verweises je Sequenz
+     */
+    unsigned char *length_codes;
+
+    /**
+     * Code des Abstands des Verweises je Sequenz
+     */
+    unsigned char *distance_codes;
+
+    /**
+     * Anzahl der Sequenzen
+     */
+    size_t sequence_count;
+
+    /**
+     * Unkodierte Bits aller Werte, je Sequenz Anzahl, Länge und Abstand
+     */
+    unsigned char *extra_bits;
+
+    /**
+     * Anzahl der unkodierten Bits
+     */
+    unsigned long long extra_bit_count;
+} LZ_SEQUENCES;
+
+/**
+ * Zerlegt einen Block in Sequenzen. Wie gründlich nach Verweisen gesucht
+ * wird, hängt vom Komprimierungslevel ab.
+ * @param block - Anfang des Blocks
+ * @param block_size - Anzahl der Zeichen, höchstens MAX_BLOCK_SIZE
+ * @param level - Komprimierungslevel
+ * @param window_size - größter Abstand eines Verweises
+ * @param sequences - Ziel, die Speicherbereiche gehören dem Thread
+ */
+extern void lz_parse(const unsigned char *block, size_t block_size, int level, size_t window_size,
+                     LZ_SEQUENCES *sequences);
+
+/**
+ * Liefert Speicherbereiche des Threads, in die die Literale und Codes
+ * eines Blocks dekodiert werden.
+ * @param block_size - Anzahl der Zeichen, höchstens MAX_BLOCK_SIZE
+ * @param sequences - Ziel
+ */
+extern void lz_get_buffers(size_t block_size, LZ_SEQUENCES *sequences);
+
+/**
+ * Liefert die größte Anzahl Sequenzen eines Blocks.
+ * @param block_size - Anzahl der Zeichen
+ * @return Anzahl Sequenzen
+ */
+extern size_t lz_get_max_sequences(size_t block_size);
+
+/**
+ * Liefert die größte Anzahl Bytes der unkodierten Bits eines Blocks.
+ * @param block_size - Anzahl der Zeichen
+ * @return Anzahl Bytes
+ */
+extern size_t lz_get_extra_bound(size_t block_size);
+
+/**
+ * Setzt einen Block aus seinen Sequenzen zusammen. Hinter den unkodierten
+ * Bits müssen 8 Bytes lesbar sein.
+ * @param sequences - Sequenzen des Blocks
+ * @param extra_size - Anzahl der Bytes der unkodierten Bits
+ * @param destination - Ziel
+ * @param block_size - Anzahl der Zeichen des Blocks
+ * @return COMPRESSION_EXCEPTION, falls die Sequenzen nicht zum Block passen
+ */
+extern EXIT lz_decode(const LZ_SEQUENCES *sequences, size_t extra_size, unsigned char *destination,
+                      size_t block_size);
+
+/**
+ * Liefert den Speicher, den ein Thread für die Vorstufe höchstens belegt.
+ * @param block_size - Größe des Blockspeichers
+ * @param is_parsing - Gibt an, ob auch Blöcke zerlegt werden
+ * @return Anzahl Bytes
+ */
+extern unsigned long long lz_get_memory(size_t block_size, bool is_parsing);
+
+/**
+ * Gibt den Speicher der Vorstufe im aufrufenden Thread frei.
+ */
+extern void lz_free(void);
+
+#endif //HUFFMAN_LZ_H
@@ -14,10 +14,15 @@
  * @date    2020-12-05
  */
 
-#include "io.h"
-#include "huffman.h"
 #include "huffman_common.h"
 #include "arguments.h"
+#include "batch.h"
+#include "archive.h"
+#include "daemon.h"
+#include "kernel.h"
+#include "huffman.h"
+#include "io.h"
+#include <stddef.h>
 
 /**
  * Hauptmethode des Programms
@@ -27,36 +32,80 @@
  */
 int main(int argc, char *argv[])
 {
-    // variables for legal arguments
-    OPERATION_MODE operation_mode = NONE;
-    bool should_view_info = false;
-    bool should_view_help = false;
-    int level = 2;
-    char out_filename[MAX_LENGTH_FILENAME] = {'\0'};
-    char in_filename[MAX_LENGTH_FILENAME]= {'\0'};
+    // legal arguments with default values
+    ARGUMENTS arguments = {
+            .operation_mode = NONE,
+            .should_view_info = false,
+            .should_view_help = false,
+            .level = 2,
+            .threads = 0,
+            .memory_budget = 0,
+            .window_size = 0,
+            .filter = 0,
+            .is_json = false,
+            .is_direct_io = false,
+            .is_pipelined_io = false,
+            .recursive = false,
+            .solid = false,
+            .member_name = {'\0'},
+            .table_filename = {'\0'},
+            .out_filename = {'\0'},
+            .socket_filename = {'\0'},
+            .in_filenames = NULL,
+            .in_count = 0,
+            .in_size = 0
+    };
 
     start_clock();
 
-    EXIT exit = read_arguments(argv, argc, &operation_mode, &should_view_info, &should_view_help, &level, out_filename, in_filename);
+    EXIT exit = read_arguments(argv, argc, &arguments);
 
-    if (should_view_help)
+    // the memory budget depends on whether matches are searched
+    if (exit == SUCCESS)
     {
-        print_help();
+        set_codec_window((size_t) arguments.window_size);
+        set_codec_filter(arguments.filter);
+        set_io_direct(arguments.is_direct_io);
+        set_io_pipelined(arguments.is_pipelined_io);
+        exit = apply_memory_budget(&arguments);
     }
 
-    if (operation_mode == COMPRESSION && exit == SUCCESS)
+    // the table is read once and encodes all infiles
+    if (exit == SUCCESS && arguments.table_filename[0] != '\0')
     {
-        exit = compress(in_filename, out_filename);
+        exit = set_codec_table(arguments.table_filename);
     }
-    else if (operation_mode == DECOMPRESSION && exit == SUCCESS)
+
+    if (arguments.should_view_help)
     {
-        exit = decompress(in_filename, out_filename);
+        print_help();
     }
 
-    if (should_view_info && exit == SUCCESS)
+    if (arguments.should_view_info && exit == SUCCESS)
     {
-        print_further_information(in_filename, out_filename);
+        print_kernels();
     }
 
+    if (arguments.operation_mode == COMPRESSION && arguments.solid && exit == SUCCESS)
+    {
+        exit = compress_archive(arguments.in_filenames, arguments.in_count, arguments.out_filename);
+        if (arguments.should_view_info && exit == SUCCESS)
+        {
+            print_further_information(NULL, arguments.out_filename);
+        }
+    }
+    else if ((arguments.operation_mode == COMPRESSION || arguments.operation_mode == DECOMPRESSION
+              || arguments.operation_mode == ANALYSIS) && exit == SUCCESS)
+    {
+        exit = run_batch(&arguments);
+    }
+    else if (arguments.operation_mode == DAEMON && exit == SUCCESS)
+    {
+        exit = run_daemon(&arguments);
+    }
+
+    free_codec();
+    free_arguments(&arguments);
+
     return exit;
 }
\ No newline at end of file
@@ -0,0 +1,149 @@
+// cpu_set_t, sched_getaffinity, pthread_setaffinity_np
+#define _GNU_SOURCE
+
+#include "node.h"
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/**
+ * Höchste Anzahl berücksichtigter Knoten
+ */
+#define MAX_NODES 64
+
+/**
+ * Höchste Länge der Prozessorliste eines Knotens
+ */
+#define MAX_LENGTH_CPULIST 4096
+
+/**
+ * Prozessoren je Knoten, auf denen der Prozess laufen darf
+ */
+static cpu_set_t node_cpus[MAX_NODES];
+
+/**
+ * Nummer je Knoten im System
+ */
+static int node_ids[MAX_NODES];
+
+/**
+ * Anzahl der Knoten mit solchen Prozessoren
+ */
+static int node_count = 1;
+
+/**
+ * Sorgt dafür, dass die Knoten genau einmal gelesen werden
+ */
+static pthread_once_t nodes_once = PTHREAD_ONCE_INIT;
+
+/**
+ * Liest die Knoten und ihre Prozessoren.
+ */
+static void read_nodes(void);
+
+/**
+ * Liest eine Prozessorliste wie "0-3,8-11" und nimmt die Prozessoren in
+ * eine Menge auf, die der Prozess verwenden darf.
+ * @param cpulist - Prozessorliste
+ * @param allowed - Prozessoren des Prozesses
+ * @param cpus - Menge, wird ergänzt
+ */
+static void parse_cpulist(const char *cpulist, const cpu_set_t *allowed, cpu_set_t *cpus);
+
+extern int get_node_count(void)
+{
+    pthread_once(&nodes_once, read_nodes);
+    return node_count;
+}
+
+extern int get_worker_node(int worker)
+{
+    return worker >= 0 ? worker % get_node_count() : 0;
+}
+
+extern bool bind_to_node(int worker)
+{
+    if (get_node_count() <= 1 || worker < 0)
+    {
+        return false;
+    }
+    return pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &node_cpus[get_worker_node(worker)]) == 0;
+}
+
+extern void print_node_placement(int threads)
+{
+    if (get_node_count() <= 1)
+    {
+        printf(" - NUMA: ein Knoten, Threads nicht gebunden\n");
+        return;
+    }
+
+    printf(" - NUMA: %d Knoten, Threads reihum gebunden:", node_count);
+    for (int node = 0; node < node_count; node++)
+    {
+        // workers node, node + node_count, ... share a node
+        int count = threads / node_count + (node < threads % node_count);
+        printf(" %d auf Knoten %d (%d Prozessoren)%s", count, node_ids[node], CPU_COUNT(&node_cpus[node]),
+               node + 1 < node_count ? "," : "\n");
+    }
+}
+
+static void read_nodes(void)
+{
+    cpu_set_t allowed;
+    int count = 0;
+
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0)
+    {
+        return;
+    }
+
+    for (int node = 0; node < MAX_NODES; node++)
+    {
+        char filename[64];
+        char cpulist[MAX_LENGTH_CPULIST];
+        FILE *file;
+
+        snprintf(filename, sizeof(filename), "/sys/devices/system/node/node%d/cpulist", node);
+        file = fopen(filename, "r");
+        if (file == NULL)
+        {
+            continue;
+        }
+        if (fgets(cpulist, sizeof(cpulist), file) != NULL)
+        {
+            // memory-only nodes and nodes outside the affinity get no workers
+            CPU_ZERO(&node_cpus[count]);
+            parse_cpulist(cpulist, &allowed, &node_cpus[count]);
+            node_ids[count] = node;
+            count += CPU_COUNT(&node_cpus[count]) > 0;
+        }
+        fclose(file);
+    }
+    node_count = count > 0 ? count : 1;
+}
+
+static void parse_cpulist(const char *cpulist, const cpu_set_t *allowed, cpu_set_t *cpus)
+{
+    char *end;
+
+    while (*cpulist >= '0' && *cpulist <= '9')
+    {
+        long first = strtol(cpulist, &end, 10);
+        long last = first;
+
+        if (*end == '-')
+        {
+            last = strtol(end + 1, &end, 10);
+        }
+        for (long cpu = first; cpu <= last && cpu < CPU_SETSIZE; cpu++)
+        {
+            if (CPU_ISSET((int) cpu, allowed))
+            {
+                CPU_SET((int) cpu, cpus);
+            }
+        }
+        cpulist = *end == ',' ? end + 1 : end;
+    }
+}
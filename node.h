@@ -0,0 +1,54 @@
+/**
+ * @file
+ * Dieses Modul verteilt Worker-Threads auf die NUMA-Knoten des Rechners.
+ * Jeder Thread wird an die Prozessoren eines Knotens gebunden, bevor er
+ * seine Puffer und Tabellen anlegt und zuerst beschreibt. Da Linux Seiten
+ * auf dem Knoten bereitstellt, der sie zuerst beschreibt, liegen sie so auf
+ * dem Knoten des Threads, und jede Datei wird auf demselben Knoten gelesen
+ * und (de-)komprimiert. Ausgenommen sind die wenigen Bytes im statischen
+ * Thread-Speicher, die der erzeugende Thread anlegt.
+ *
+ * Die Knoten werden aus /sys/devices/system/node gelesen, Knoten ohne
+ * Prozessoren sowie Prozessoren außerhalb der Affinität des Prozesses
+ * bleiben außen vor. Mit nur einem Knoten werden keine Threads gebunden.
+ *
+ * @author  Tim Ostermann
+ * @date    2020-12-05
+ */
+
+#ifndef HUFFMAN_NODE_H
+#define HUFFMAN_NODE_H
+
+#include "huffman_common.h"
+
+/**
+ * Liefert die Anzahl der NUMA-Knoten mit Prozessoren, auf denen der Prozess
+ * laufen darf.
+ * @return Anzahl Knoten, 1, wenn sie nicht bestimmt werden kann
+ */
+extern int get_node_count(void);
+
+/**
+ * Liefert den Knoten, auf dem ein Worker-Thread läuft. Die Worker werden
+ * reihum auf die Knoten verteilt.
+ * @param worker - Nummer des Worker-Threads ab 0
+ * @return Knoten ab 0
+ */
+extern int get_worker_node(int worker);
+
+/**
+ * Bindet den aufrufenden Thread an die Prozessoren eines Knotens. Die
+ * Worker werden reihum auf die Knoten verteilt.
+ * @param worker - Nummer des Worker-Threads ab 0
+ * @return Wahrheitswert, ob der Thread gebunden wurde
+ */
+extern bool bind_to_node(int worker);
+
+/**
+ * Gibt die Verteilung der Worker-Threads auf die Knoten auf dem Bildschirm
+ * aus.
+ * @param threads - Anzahl der Worker-Threads
+ */
+extern void print_node_placement(int threads);
+
+#endif //HUFFMAN_NODE_H
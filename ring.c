@@ -0,0 +1,88 @@
+#include "ring.h"
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+/**
+ * Anzahl der erneuten Prüfungen eines Zählers, bevor am Futex gewartet wird
+ */
+#define RING_SPIN_COUNT 256
+
+/**
+ * Wartet, bis ein Zähler der anderen Seite nicht mehr den angegebenen Wert hat.
+ * @param counter - Zähler der anderen Seite
+ * @param is_waiting - Kennzeichen, dass am Futex des Zählers gewartet wird
+ * @param value - Wert, bei dem gewartet wird
+ */
+static void wait_for_change(atomic_uint *counter, atomic_int *is_waiting, unsigned int value);
+
+/**
+ * Weckt die andere Seite, falls sie am Futex des Zählers wartet.
+ * @param counter - geänderter Zähler
+ * @param is_waiting - Kennzeichen, dass am Futex des Zählers gewartet wird
+ */
+static void wake_waiting(atomic_uint *counter, atomic_int *is_waiting);
+
+extern void ring_init(SPSC_RING *ring)
+{
+    atomic_init(&ring->head, 0);
+    atomic_init(&ring->tail, 0);
+    atomic_init(&ring->is_producer_waiting, 0);
+    atomic_init(&ring->is_consumer_waiting, 0);
+}
+
+extern void ring_push(SPSC_RING *ring, RING_SLOT slot)
+{
+    // only this thread changes tail
+    unsigned int tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+
+    // full while the consumer is a whole ring behind
+    wait_for_change(&ring->head, &ring->is_producer_waiting, tail - RING_CAPACITY);
+
+    ring->slots[tail % RING_CAPACITY] = slot;
+    atomic_store_explicit(&ring->tail, tail + 1, memory_order_seq_cst);
+    wake_waiting(&ring->tail, &ring->is_consumer_waiting);
+}
+
+extern RING_SLOT ring_pop(SPSC_RING *ring)
+{
+    // only this thread changes head
+    unsigned int head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    RING_SLOT slot;
+
+    // empty while the producer has not got further
+    wait_for_change(&ring->tail, &ring->is_consumer_waiting, head);
+
+    slot = ring->slots[head % RING_CAPACITY];
+    atomic_store_explicit(&ring->head, head + 1, memory_order_seq_cst);
+    wake_waiting(&ring->head, &ring->is_producer_waiting);
+
+    return slot;
+}
+
+static void wait_for_change(atomic_uint *counter, atomic_int *is_waiting, unsigned int value)
+{
+    for (int spin = 0; atomic_load_explicit(counter, memory_order_acquire) == value; spin++)
+    {
+        if (spin < RING_SPIN_COUNT)
+        {
+            continue;
+        }
+
+        // announce the wait before the last check, so a change after it wakes this thread
+        atomic_store_explicit(is_waiting, 1, memory_order_seq_cst);
+        if (atomic_load_explicit(counter, memory_order_seq_cst) == value)
+        {
+            syscall(SYS_futex, (unsigned int *) counter, FUTEX_WAIT_PRIVATE, value, NULL, NULL, 0);
+        }
+        atomic_store_explicit(is_waiting, 0, memory_order_relaxed);
+    }
+}
+
+static void wake_waiting(atomic_uint *counter, atomic_int *is_waiting)
+{
+    if (atomic_load_explicit(is_waiting, memory_order_seq_cst))
+    {
+        syscall(SYS_futex, (unsigned int *) counter, FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0);
+    }
+}
@@ -0,0 +1,100 @@
+/**
+ * @file
+ * Dieses Modul stellt begrenzte Ringe für genau einen schreibenden und einen
+ * lesenden Thread zur Verfügung, über die Beschreibungen von Puffern
+ * weitergereicht werden. Beide Seiten synchronisieren sich ohne Mutex nur
+ * über den Zähler der jeweils anderen Seite. Ist der Ring voll bzw. leer,
+ * prüft der Thread den Zähler kurz erneut und wartet dann am Futex des
+ * Zählers, bis die andere Seite ihn weckt.
+ *
+ * @author  Tim Ostermann
+ * @date    2020-12-05
+ */
+
+#ifndef HUFFMAN_RING_H
+#define HUFFMAN_RING_H
+
+#include <stdatomic.h>
+#include <stddef.h>
+#include "huffman_common.h"
+
+/**
+ * Anzahl der Plätze eines Rings, eine Zweierpotenz
+ */
+#define RING_CAPACITY 8
+
+/**
+ * Größe einer Cache-Zeile, auf der jeder Zähler allein liegt
+ */
+#define RING_CACHE_LINE 64
+
+/**
+ * Beschreibung eines Puffers
+ */
+typedef struct
+{
+    /**
+     * Anfang des Puffers
+     */
+    unsigned char *data;
+
+    /**
+     * Anzahl der gültigen Bytes
+     */
+    size_t size;
+} RING_SLOT;
+
+/**
+ * Ring für einen schreibenden und einen lesenden Thread
+ */
+typedef struct
+{
+    /**
+     * Anzahl der bisher entnommenen Plätze, nur vom lesenden Thread erhöht
+     */
+    _Alignas(RING_CACHE_LINE) atomic_uint head;
+
+    /**
+     * Gibt an, ob der schreibende Thread am Futex von head wartet
+     */
+    atomic_int is_producer_waiting;
+
+    /**
+     * Anzahl der bisher belegten Plätze, nur vom schreibenden Thread erhöht
+     */
+    _Alignas(RING_CACHE_LINE) atomic_uint tail;
+
+    /**
+     * Gibt an, ob der lesende Thread am Futex von tail wartet
+     */
+    atomic_int is_consumer_waiting;
+
+    /**
+     * Plätze, Index ist der Zähler modulo RING_CAPACITY
+     */
+    _Alignas(RING_CACHE_LINE) RING_SLOT slots[RING_CAPACITY];
+} SPSC_RING;
+
+/**
+ * Leert einen Ring. Vorbedingung: Kein Thread verwendet ihn.
+ * @param ring - Ring
+ */
+extern void ring_init(SPSC_RING *ring);
+
+/**
+ * Legt eine Pufferbeschreibung in den Ring; wartet, solange er voll ist.
+ * Darf nur vom schreibenden Thread aufgerufen werden.
+ * @param ring - Ring
+ * @param slot - Pufferbeschreibung
+ */
+extern void ring_push(SPSC_RING *ring, RING_SLOT slot);
+
+/**
+ * Entnimmt die älteste Pufferbeschreibung aus dem Ring; wartet, solange er
+ * leer ist. Darf nur vom lesenden Thread aufgerufen werden.
+ * @param ring - Ring
+ * @return Pufferbeschreibung
+ */
+extern RING_SLOT ring_pop(SPSC_RING *ring);
+
+#endif //HUFFMAN_RING_H